@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_ASYNC_EXECUTOR_H_
+#define SUP_PROTOCOL_ASYNC_EXECUTOR_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief The AsyncExecutor interface defines how the asynchronous calls to Protocol::Invoke in
+ * a ProtocolRPCServer are executed.
+ *
+ * @details A host application can provide its own implementation (e.g. to share an existing
+ * thread pool) through ProtocolRPCServerConfig. Implementations need to be threadsafe, since tasks
+ * can be submitted concurrently from different transport threads.
+ *
+ * @note The server will wait for all its submitted tasks to finish before it is destroyed, so
+ * implementations must eventually run every task that was submitted.
+ */
+class AsyncExecutor
+{
+public:
+  using Task = std::function<void()>;
+
+  AsyncExecutor() = default;
+  virtual ~AsyncExecutor();
+
+  AsyncExecutor(const AsyncExecutor&) = delete;
+  AsyncExecutor(AsyncExecutor&&) = delete;
+  AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+  AsyncExecutor& operator=(AsyncExecutor&&) = delete;
+
+  /**
+   * @brief Submit a task for execution. This method should not block until the task is executed.
+   *
+   * @param task Task to execute.
+   */
+  virtual void Submit(Task task) = 0;
+};
+
+/**
+ * @brief Create an executor that runs each task on a newly created thread. This corresponds to
+ * the behavior of launching each task with std::async.
+ *
+ * @return Executor that creates a thread per task.
+ */
+std::shared_ptr<AsyncExecutor> CreateThreadPerTaskExecutor();
+
+/**
+ * @brief Create an executor with a fixed number of worker threads that execute the tasks from a
+ * shared queue in the order of submission.
+ *
+ * @param n_threads Number of worker threads (must be larger than zero).
+ * @return Worker pool executor.
+ * @throw InvalidOperationException when the number of threads is zero.
+ */
+std::shared_ptr<AsyncExecutor> CreateWorkerPool(std::size_t n_threads);
+
+/**
+ * @brief Create an executor with a fixed number of worker threads, each with its own task queue.
+ * Idle workers steal tasks from the other queues. This scales better than a worker pool with a
+ * single shared queue when many short tasks are submitted concurrently.
+ *
+ * @param n_threads Number of worker threads (must be larger than zero).
+ * @return Work-stealing executor.
+ * @throw InvalidOperationException when the number of threads is zero.
+ */
+std::shared_ptr<AsyncExecutor> CreateWorkStealingPool(std::size_t n_threads);
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_ASYNC_EXECUTOR_H_
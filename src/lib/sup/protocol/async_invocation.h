@@ -27,6 +27,9 @@
 #include <sup/protocol/protocol_result.h>
 #include <sup/protocol/protocol_rpc.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <string>
 #include <utility>
 
 namespace sup
@@ -44,7 +47,23 @@ namespace protocol
  * callers to drive the polling loop themselves (e.g. across ticks of a behavior tree instruction)
  * without spawning threads.
  *
- * @note This class is single threaded: a single instance must not be used concurrently.
+ * Polls ask the server to include the reply as soon as it is ready. When the server does so,
+ * GetReply() returns that reply without another exchange with the server. Older servers ignore
+ * this request and GetReply() then retrieves the reply as before.
+ *
+ * Transports that deliver completion notifications from the server (see
+ * ProtocolRPCServerConfig::m_completion_callback) can forward them with NotifyCompletion(). The
+ * caller can then block in WaitForCompletion() instead of calling PollOnce() in a loop.
+ *
+ * An accepted request stays outstanding on the server until its reply was retrieved or it was
+ * invalidated. When the object is destroyed while its request is still outstanding (e.g. after a
+ * timeout or any other early return of the caller), the destructor invalidates the request, so
+ * the server does not keep its reply until it expires. This costs at most one exchange with the
+ * server, which is never retried, and is skipped altogether when the object is destroyed during
+ * stack unwinding: the request then expires on the server.
+ *
+ * @note This class is single threaded: a single instance must not be used concurrently. The only
+ * exception is NotifyCompletion(), which can be called from any thread.
  */
 class AsyncInvocation
 {
@@ -57,6 +76,33 @@ public:
    */
   AsyncInvocation(sup::dto::AnyFunctor& functor, PayloadEncoding encoding);
 
+  /**
+   * @brief Constructor.
+   * @param functor Network client used to send the RPC packets. Not owned; must outlive this
+   * object.
+   * @param encoding Payload encoding to use for the RPC packets.
+   * @param priority Priority of the asynchronous request.
+   */
+  AsyncInvocation(sup::dto::AnyFunctor& functor, PayloadEncoding encoding,
+                  AsyncPriority priority);
+
+  /**
+   * @brief Constructor.
+   * @param functor Network client used to send the RPC packets. Not owned; must outlive this
+   * object.
+   * @param encoding Payload encoding to use for the RPC packets.
+   * @param priority Priority of the asynchronous request.
+   * @param key Idempotency key of the asynchronous request (empty for none). It should be unique
+   * for each call. When a call to Start() fails because the reply was lost, Start() can then be
+   * retried without the server running the request twice.
+   */
+  AsyncInvocation(sup::dto::AnyFunctor& functor, PayloadEncoding encoding,
+                  AsyncPriority priority, const std::string& key);
+
+  /**
+   * @brief Destructor. Invalidates the request when it is still outstanding (best effort), unless
+   * an exception is propagating.
+   */
   ~AsyncInvocation();
 
   AsyncInvocation(const AsyncInvocation&) = delete;
@@ -69,10 +115,14 @@ public:
    * @param input Application level input payload (cannot be empty).
    * @return Success if the request was accepted (asynchronous handle obtained) or if the server
    * replied synchronously with a well-formed reply; an error code otherwise (including a
-   * synchronous reply that is malformed).
+   * synchronous reply that is malformed). ServerBusy indicates that the server did not accept the
+   * request at this time and Start() can be retried later.
    *
    * @note When the server chooses to reply synchronously, IsSynchronous() returns true and the
    * reply can be retrieved directly with GetReply() (PollOnce() will report ready immediately).
+   *
+   * @note Calling Start() again first invalidates a request that is still outstanding, so each
+   * object retains at most one request on the server.
    */
   ProtocolResult Start(const sup::dto::AnyValue& input);
 
@@ -84,7 +134,17 @@ public:
   std::pair<ProtocolResult, bool> PollOnce();
 
   /**
-   * @brief Retrieve the reply payload. Only meaningful once PollOnce() reported ready.
+   * @brief Perform a single poll that the server may hold until the reply is ready. The wait is
+   * limited to the maximum advertised by the server; when the server did not advertise support
+   * for waiting polls, this is the same as PollOnce().
+   * @param max_wait_sec Maximum time in seconds the poll may be held by the server.
+   * @return A pair {result, ready}, as for PollOnce().
+   */
+  std::pair<ProtocolResult, bool> PollOnce(double max_wait_sec);
+
+  /**
+   * @brief Retrieve the reply payload. Only meaningful once PollOnce() reported ready. When the
+   * server included the reply in the poll reply, no further request is sent.
    * @param output Output payload to be filled on success.
    * @return Success and a filled output, or an error code.
    */
@@ -92,22 +152,73 @@ public:
 
   /**
    * @brief Best effort notification to the server that this asynchronous request is no longer
-   * needed (e.g. when the caller is halted). Safe to call at any time.
+   * needed (e.g. when the caller is halted). Safe to call at any time: only a request that is
+   * still outstanding is invalidated and only once.
    */
   void Invalidate();
 
+  /**
+   * @brief Whether the server still retains the request, i.e. it was accepted by the server, but
+   * its reply was not retrieved yet and it was not invalidated.
+   */
+  bool IsOutstanding() const;
+
+  /**
+   * @brief Signal that the server notified the completion of this asynchronous request. This
+   * can be called from any thread and also before Start() returned.
+   */
+  void NotifyCompletion();
+
+  /**
+   * @brief Wait until the completion of this asynchronous request was notified or the timeout
+   * passed. Returns immediately when the reply was already received (e.g. a synchronous reply).
+   * After a successful wait, PollOnce() will report the reply as ready.
+   * @param seconds Maximum time to wait in seconds.
+   * @return true if completion was notified or the reply was already received.
+   */
+  bool WaitForCompletion(double seconds);
+
+  /**
+   * @brief Identifier the server assigned to this asynchronous request, used to match completion
+   * notifications. Zero before a successful Start() and for synchronous replies.
+   */
+  sup::dto::uint64 GetId() const;
+
   /**
    * @brief Whether the server replied synchronously to Start(). Only becomes true for a
    * well-formed synchronous reply.
    */
   bool IsSynchronous() const;
 
+  /**
+   * @brief Maximum time in seconds the server will hold a poll, as advertised in its reply to
+   * Start(). Zero when the server does not support waiting polls.
+   */
+  double GetMaxPollWait() const;
+
+  /**
+   * @brief Delay in seconds the server suggested before the next poll, in its reply to Start() or
+   * to the last poll. Zero when the server gave no suggestion.
+   */
+  double GetRetryAfter() const;
+
 private:
   sup::dto::AnyFunctor& m_functor;
   PayloadEncoding m_encoding;
+  AsyncPriority m_priority;
+  std::string m_key;
   sup::dto::uint64 m_id;
+  double m_max_poll_wait;
+  double m_retry_after;
   bool m_synchronous;
-  sup::dto::AnyValue m_sync_reply;
+  bool m_outstanding;
+  bool m_reply_received;
+  sup::dto::AnyValue m_received_reply;
+  std::mutex m_completion_mtx;
+  std::condition_variable m_completion_cv;
+  bool m_completion_notified;
+  // Number of exceptions in flight at construction, to detect destruction during unwinding
+  const int m_uncaught_exceptions;
 };
 
 }  // namespace protocol
@@ -44,6 +44,54 @@ bool ValidateMemberTypeIfPresent(const sup::dto::AnyValue& value, const std::str
   }
   return value[member_name].GetType() == member_type;
 }
+
+std::size_t GetApproximateSize(const sup::dto::AnyValue& value)
+{
+  switch (value.GetTypeCode())
+  {
+  case sup::dto::TypeCode::Empty:
+    return 0;
+  case sup::dto::TypeCode::Bool:
+  case sup::dto::TypeCode::Char8:
+  case sup::dto::TypeCode::Int8:
+  case sup::dto::TypeCode::UInt8:
+    return 1;
+  case sup::dto::TypeCode::Int16:
+  case sup::dto::TypeCode::UInt16:
+    return 2;
+  case sup::dto::TypeCode::Int32:
+  case sup::dto::TypeCode::UInt32:
+  case sup::dto::TypeCode::Float32:
+    return 4;
+  case sup::dto::TypeCode::Int64:
+  case sup::dto::TypeCode::UInt64:
+  case sup::dto::TypeCode::Float64:
+    return 8;
+  case sup::dto::TypeCode::String:
+    return value.As<std::string>().size();
+  case sup::dto::TypeCode::Struct:
+  {
+    std::size_t result = 0;
+    for (const auto& member_name : value.MemberNames())
+    {
+      result += GetApproximateSize(value[member_name]);
+    }
+    return result;
+  }
+  case sup::dto::TypeCode::Array:
+  {
+    std::size_t result = 0;
+    for (std::size_t idx = 0; idx < value.NumberOfElements(); ++idx)
+    {
+      result += GetApproximateSize(value[idx]);
+    }
+    return result;
+  }
+  default:
+    break;
+  }
+  return 0;
+}
 }  // namespace protocol
 
 }  // namespace sup
@@ -23,6 +23,8 @@
 
 #include <sup/dto/anyvalue.h>
 
+#include <cstddef>
+
 namespace sup
 {
 namespace protocol
@@ -32,6 +34,16 @@ bool ValidateMemberType(const sup::dto::AnyValue& value, const std::string& memb
 
 bool ValidateMemberTypeIfPresent(const sup::dto::AnyValue& value, const std::string& member_name,
                                  const sup::dto::AnyType& member_type);
+
+/**
+ * @brief Estimate the memory in bytes held by the data of the given value. The estimate only
+ * accounts for the leaf values (scalars and string contents) and ignores the type information and
+ * container overhead, but it is cheap to compute and scales with the actual memory use.
+ *
+ * @param value AnyValue to estimate.
+ * @return Approximate size in bytes.
+ */
+std::size_t GetApproximateSize(const sup::dto::AnyValue& value);
 }  // namespace protocol
 
 }  // namespace sup
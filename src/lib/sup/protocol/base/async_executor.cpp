@@ -0,0 +1,50 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/async_executor.h>
+
+#include "work_stealing_pool.h"
+#include "worker_pool.h"
+
+namespace sup
+{
+namespace protocol
+{
+
+AsyncExecutor::~AsyncExecutor() = default;
+
+std::shared_ptr<AsyncExecutor> CreateThreadPerTaskExecutor()
+{
+  return std::make_shared<ThreadPerTaskExecutor>();
+}
+
+std::shared_ptr<AsyncExecutor> CreateWorkerPool(std::size_t n_threads)
+{
+  return std::make_shared<WorkerPool>(n_threads);
+}
+
+std::shared_ptr<AsyncExecutor> CreateWorkStealingPool(std::size_t n_threads)
+{
+  return std::make_shared<WorkStealingPool>(n_threads);
+}
+
+}  // namespace protocol
+
+}  // namespace sup
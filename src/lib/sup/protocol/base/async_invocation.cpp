@@ -21,6 +21,10 @@
 #include <sup/dto/anyvalue_helper.h>
 #include <sup/protocol/async_invocation.h>
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
 namespace sup
 {
 namespace protocol
@@ -76,18 +80,115 @@ ProtocolResult DecodeReply(const sup::dto::AnyValue& reply, sup::dto::AnyValue&
   }
   return result;
 }
+
+// Extract the ready status from a (decoded) poll reply payload.
+std::pair<bool, bool> TryGetReadyStatus(const sup::dto::AnyValue& payload)
+{
+  const std::pair<bool, bool> failure{false, false};
+  if (!payload.HasField(constants::ASYNC_READY_FIELD_NAME))
+  {
+    return failure;
+  }
+  auto& ready_field = payload[constants::ASYNC_READY_FIELD_NAME];
+  if (ready_field.GetType() != sup::dto::BooleanType)
+  {
+    return failure;
+  }
+  return {true, ready_field.As<sup::dto::boolean>()};
+}
+
+// Convert a reply included in a (decoded) poll reply payload into a standard RPC reply packet,
+// so it can be decoded like a synchronous reply.
+std::pair<bool, sup::dto::AnyValue> TryGetInlineReply(const sup::dto::AnyValue& payload)
+{
+  const std::pair<bool, sup::dto::AnyValue> failure{false, {}};
+  auto& result_field = payload[constants::REPLY_RESULT];
+  if (result_field.GetType() != sup::dto::UnsignedInteger32Type)
+  {
+    return failure;
+  }
+  const ProtocolResult result{result_field.As<sup::dto::uint32>()};
+  if (!payload.HasField(constants::REPLY_PAYLOAD))
+  {
+    return {true, utils::CreateRPCReply(result)};
+  }
+  return {true, utils::CreateRPCReply(result, payload[constants::REPLY_PAYLOAD],
+                                      PayloadEncoding::kNone)};
+}
+
+// Extract the suggested delay before the next poll from a (decoded) poll reply payload. Zero when
+// absent or malformed.
+double TryGetRetryAfter(const sup::dto::AnyValue& payload)
+{
+  if (!payload.HasField(constants::ASYNC_RETRY_AFTER_FIELD_NAME))
+  {
+    return 0.0;
+  }
+  auto& retry_field = payload[constants::ASYNC_RETRY_AFTER_FIELD_NAME];
+  if (retry_field.GetType() != sup::dto::Float64Type)
+  {
+    return 0.0;
+  }
+  return retry_field.As<sup::dto::float64>();
+}
 }  // unnamed namespace
 
 AsyncInvocation::AsyncInvocation(sup::dto::AnyFunctor& functor, PayloadEncoding encoding)
-    : m_functor{functor}, m_encoding{encoding}, m_id{0}, m_synchronous{false}, m_sync_reply{}
+    : AsyncInvocation{functor, encoding, AsyncPriority::kNormal}
 {
 }
 
-AsyncInvocation::~AsyncInvocation() = default;
+AsyncInvocation::AsyncInvocation(sup::dto::AnyFunctor& functor, PayloadEncoding encoding,
+                                 AsyncPriority priority)
+    : AsyncInvocation{functor, encoding, priority, std::string{}}
+{
+}
+
+AsyncInvocation::AsyncInvocation(sup::dto::AnyFunctor& functor, PayloadEncoding encoding,
+                                 AsyncPriority priority, const std::string& key)
+    : m_functor{functor}
+    , m_encoding{encoding}
+    , m_priority{priority}
+    , m_key{key}
+    , m_id{0}
+    , m_max_poll_wait{0.0}
+    , m_retry_after{0.0}
+    , m_synchronous{false}
+    , m_outstanding{false}
+    , m_reply_received{false}
+    , m_received_reply{}
+    , m_completion_mtx{}
+    , m_completion_cv{}
+    , m_completion_notified{false}
+    , m_uncaught_exceptions{std::uncaught_exceptions()}
+{
+}
+
+AsyncInvocation::~AsyncInvocation()
+{
+  // Do not block the unwinding of an exception on the network: the request expires anyway
+  if (std::uncaught_exceptions() > m_uncaught_exceptions)
+  {
+    return;
+  }
+  Invalidate();
+}
 
 ProtocolResult AsyncInvocation::Start(const sup::dto::AnyValue& input)
 {
-  const auto request = utils::CreateAsyncRPCRequest(input, m_encoding);
+  // A new request replaces the previous one
+  Invalidate();
+  m_id = 0;
+  m_max_poll_wait = 0.0;
+  m_retry_after = 0.0;
+  m_synchronous = false;
+  m_reply_received = false;
+  m_received_reply = sup::dto::AnyValue{};
+  {
+    std::lock_guard<std::mutex> lk{m_completion_mtx};
+    m_completion_notified = false;
+  }
+  const auto request = utils::CreateAsyncRPCRequest(input, m_encoding, m_priority, m_key);
   sup::dto::AnyValue reply;
   try
   {
@@ -107,9 +208,16 @@ ProtocolResult AsyncInvocation::Start(const sup::dto::AnyValue& input)
       return ClientTransportDecodingError;
     }
     m_synchronous = true;
-    m_sync_reply = reply;
+    m_reply_received = true;
+    m_received_reply = reply;
     return Success;
   }
+  // The server can refuse the request, e.g. when it is busy
+  auto result_info = utils::TryExtractProtocolResult(reply);
+  if (result_info.first && result_info.second != Success)
+  {
+    return result_info.second;
+  }
   auto encoding_info = utils::TryGetPacketEncoding(reply);
   if (!encoding_info.first)
   {
@@ -121,16 +229,25 @@ ProtocolResult AsyncInvocation::Start(const sup::dto::AnyValue& input)
     return ClientTransportDecodingError;
   }
   m_id = id_info.second;
+  m_outstanding = true;
+  m_max_poll_wait = utils::GetAsyncMaxPollWait(reply, encoding_info.second);
+  m_retry_after = utils::GetAsyncRetryAfter(reply, encoding_info.second);
   return Success;
 }
 
 std::pair<ProtocolResult, bool> AsyncInvocation::PollOnce()
 {
-  if (m_synchronous)
+  return PollOnce(0.0);
+}
+
+std::pair<ProtocolResult, bool> AsyncInvocation::PollOnce(double max_wait_sec)
+{
+  if (m_reply_received)
   {
     return {Success, true};
   }
-  const auto poll_request = utils::CreateAsyncRPCPoll(m_id, m_encoding);
+  const auto wait_sec = std::min(max_wait_sec, m_max_poll_wait);
+  const auto poll_request = utils::CreateAsyncRPCPoll(m_id, m_encoding, wait_sec, true);
   sup::dto::AnyValue poll_reply;
   try
   {
@@ -145,19 +262,38 @@ std::pair<ProtocolResult, bool> AsyncInvocation::PollOnce()
   {
     return {ClientTransportDecodingError, false};
   }
-  auto ready_info = utils::TryExtractReadyStatus(poll_reply, encoding_info.second);
+  auto payload_info = utils::TryExtractRPCReplyPayload(poll_reply, encoding_info.second);
+  if (!payload_info.first)
+  {
+    return {ClientTransportDecodingError, false};
+  }
+  const auto& payload = payload_info.second;
+  auto ready_info = TryGetReadyStatus(payload);
   if (!ready_info.first)
   {
     return {ClientTransportDecodingError, false};
   }
+  if (ready_info.second && payload.HasField(constants::REPLY_RESULT))
+  {
+    auto reply_info = TryGetInlineReply(payload);
+    if (!reply_info.first)
+    {
+      return {ClientTransportDecodingError, false};
+    }
+    // Including the reply retires the request on the server
+    m_outstanding = false;
+    m_reply_received = true;
+    m_received_reply = reply_info.second;
+  }
+  m_retry_after = ready_info.second ? 0.0 : TryGetRetryAfter(payload);
   return {Success, ready_info.second};
 }
 
 ProtocolResult AsyncInvocation::GetReply(sup::dto::AnyValue& output)
 {
-  if (m_synchronous)
+  if (m_reply_received)
   {
-    return DecodeReply(m_sync_reply, output);
+    return DecodeReply(m_received_reply, output);
   }
   const auto get_reply_request = utils::CreateAsyncRPCGetReply(m_id, m_encoding);
   sup::dto::AnyValue reply;
@@ -175,6 +311,12 @@ ProtocolResult AsyncInvocation::GetReply(sup::dto::AnyValue& output)
     return ClientTransportDecodingError;
   }
   auto result = result_info.second;
+  // The server retires the request when it hands out the reply. Otherwise the reply was not
+  // ready and the request is kept.
+  if (result != InvalidAsynchronousOperationError)
+  {
+    m_outstanding = false;
+  }
   if (result != Success)
   {
     return result;
@@ -194,10 +336,12 @@ ProtocolResult AsyncInvocation::GetReply(sup::dto::AnyValue& output)
 
 void AsyncInvocation::Invalidate()
 {
-  if (m_synchronous || m_id == 0)
+  if (!m_outstanding)
   {
     return;
   }
+  // Never retried: a request that cannot be invalidated will expire on the server
+  m_outstanding = false;
   const auto invalidate_request = utils::CreateAsyncRPCInvalidate(m_id, m_encoding);
   try
   {
@@ -209,11 +353,50 @@ void AsyncInvocation::Invalidate()
   }
 }
 
+void AsyncInvocation::NotifyCompletion()
+{
+  // Notify under the lock, so the waiting thread cannot destroy this object in between
+  std::lock_guard<std::mutex> lk{m_completion_mtx};
+  m_completion_notified = true;
+  m_completion_cv.notify_all();
+}
+
+bool AsyncInvocation::WaitForCompletion(double seconds)
+{
+  if (m_reply_received)
+  {
+    return true;
+  }
+  std::unique_lock<std::mutex> lk{m_completion_mtx};
+  return m_completion_cv.wait_for(lk, std::chrono::duration<double>(seconds),
+                                  [this](){ return m_completion_notified; });
+}
+
+sup::dto::uint64 AsyncInvocation::GetId() const
+{
+  return m_id;
+}
+
+bool AsyncInvocation::IsOutstanding() const
+{
+  return m_outstanding;
+}
+
 bool AsyncInvocation::IsSynchronous() const
 {
   return m_synchronous;
 }
 
+double AsyncInvocation::GetMaxPollWait() const
+{
+  return m_max_poll_wait;
+}
+
+double AsyncInvocation::GetRetryAfter() const
+{
+  return m_retry_after;
+}
+
 }  // namespace protocol
 
 }  // namespace sup
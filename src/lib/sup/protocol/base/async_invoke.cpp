@@ -20,44 +20,158 @@
 
 #include "async_invoke.h"
 
+#include "anyvalue_utils.h"
+#include "cancellation_scope.h"
 #include "timing_utils.h"
 
-#include <chrono>
-#include <cmath>
-#include <future>
+#include <atomic>
 #include <memory>
+#include <new>
+#include <utility>
 
 namespace sup
 {
 namespace protocol
 {
+namespace
+{
+/**
+ * @brief State of the task that calls Protocol::Invoke, shared between the task and its owner.
+ * Together with the completion handle, it takes a single allocation.
+ *
+ * @details The function that is submitted to the executor owns a reference to the state, so the
+ * state lives until the task finished, also when its owner is already gone. When the executor
+ * destroys the function without running it, the state (and the copied input) is released too.
+ */
+class InvokeTask
+{
+public:
+  InvokeTask(Protocol& protocol, const sup::dto::AnyValue& input, const Clock& clock,
+             AsyncInvoke::FinishedCallback on_finished,
+             AsyncInvoke::CompletedCallback on_completed,
+             std::shared_ptr<ReplySpillStore> spill_store);
+  ~InvokeTask();
+
+  InvokeTask(const InvokeTask& other) = delete;
+  InvokeTask& operator=(const InvokeTask& other) = delete;
+  InvokeTask(InvokeTask&&) = delete;
+  InvokeTask& operator=(InvokeTask&&) = delete;
+
+  static void Submit(std::shared_ptr<InvokeTask> task, AsyncExecutor& executor);
+  void Run();
+  // Only allowed after the task was cancelled before it started
+  void ReleaseInput();
+
+  CompletionHandle m_completion;
+  // Written by the task before the reply becomes ready
+  std::atomic<sup::dto::uint64> m_started;
+  std::atomic<sup::dto::uint64> m_completed;
+  // Also used by the owner, but only when the task will never start
+  AsyncInvoke::FinishedCallback m_on_finished;
+private:
+  Protocol& m_protocol;
+  sup::dto::AnyValue m_input;
+  const Clock& m_clock;
+  AsyncInvoke::CompletedCallback m_on_completed;
+  std::shared_ptr<ReplySpillStore> m_spill_store;
+};
+}  // unnamed namespace
 
 class AsyncInvoke::AsyncInvokeImpl
 {
 public:
-  AsyncInvokeImpl(Protocol& protocol, const sup::dto::AnyValue& input, double expiration_sec);
+  AsyncInvokeImpl(Protocol& protocol, const sup::dto::AnyValue& input, double expiration_sec,
+                  AsyncExecutor& executor, AsyncInvoke::FinishedCallback on_finished,
+                  AsyncInvoke::CompletedCallback on_completed,
+                  std::shared_ptr<ReplySpillStore> spill_store, const Clock& clock,
+                  const std::shared_ptr<SlabPool>& pool);
   ~AsyncInvokeImpl();
 
   bool WaitForReady(double seconds);
 
+  std::shared_ptr<CompletionHandle> GetCompletionHandle();
+
+  sup::dto::uint64 GetExpirationDeadline() const;
+
+  sup::dto::uint64 GetLastAccess() const;
+
+  std::size_t GetReplySize() const;
+
+  AsyncInvoke::Timestamps GetTimestamps() const;
+
   bool IsReadyForRemoval() const;
 
   AsyncInvoke::Reply GetReply();
 
-  void Invalidate();
+  std::size_t EvictReply();
+
+  bool Invalidate();
 private:
   void UpdateLastAccess();
   bool IsExpired() const;
-  std::future<AsyncInvoke::Reply> m_future;
+  const Clock& m_clock;
+  std::shared_ptr<InvokeTask> m_task;
+  // Shares ownership with m_task
+  std::shared_ptr<CompletionHandle> m_completion;
+  bool m_reply_retrieved;
   bool m_invalidated;
   sup::dto::uint64 m_last_access;
   sup::dto::uint64 m_expiration_time_ns;
+  sup::dto::uint64 m_accepted;
+  sup::dto::uint64 m_first_ready;
+  sup::dto::uint64 m_fetched;
 };
 
-AsyncInvoke::AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input, double expiration_sec)
-  : m_impl{std::make_unique<AsyncInvokeImpl>(protocol, input, expiration_sec)}
+AsyncInvoke::AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input,
+                         double expiration_sec, AsyncExecutor& executor)
+  : AsyncInvoke{protocol, input, expiration_sec, executor, FinishedCallback{}}
+{}
+
+AsyncInvoke::AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input,
+                         double expiration_sec, AsyncExecutor& executor,
+                         FinishedCallback on_finished)
+  : AsyncInvoke{protocol, input, expiration_sec, executor, std::move(on_finished),
+                CompletedCallback{}}
+{}
+
+AsyncInvoke::AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input,
+                         double expiration_sec, AsyncExecutor& executor,
+                         FinishedCallback on_finished, CompletedCallback on_completed)
+  : AsyncInvoke{protocol, input, expiration_sec, executor, std::move(on_finished),
+                std::move(on_completed), std::shared_ptr<ReplySpillStore>{}, GetSteadyClock()}
+{}
+
+AsyncInvoke::AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input,
+                         double expiration_sec, AsyncExecutor& executor,
+                         FinishedCallback on_finished, CompletedCallback on_completed,
+                         std::shared_ptr<ReplySpillStore> spill_store, const Clock& clock)
+  : AsyncInvoke{protocol, input, expiration_sec, executor, std::move(on_finished),
+                std::move(on_completed), std::move(spill_store), clock,
+                std::shared_ptr<SlabPool>{}}
 {}
 
+AsyncInvoke::AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input,
+                         double expiration_sec, AsyncExecutor& executor,
+                         FinishedCallback on_finished, CompletedCallback on_completed,
+                         std::shared_ptr<ReplySpillStore> spill_store, const Clock& clock,
+                         std::shared_ptr<SlabPool> pool)
+  : m_impl{}
+{
+  PoolAllocator<AsyncInvokeImpl> allocator{pool};
+  auto impl = allocator.allocate(1);
+  try
+  {
+    new (impl) AsyncInvokeImpl{protocol, input, expiration_sec, executor, std::move(on_finished),
+                               std::move(on_completed), std::move(spill_store), clock, pool};
+  }
+  catch(...)
+  {
+    allocator.deallocate(impl, 1);
+    throw;
+  }
+  m_impl = std::unique_ptr<AsyncInvokeImpl, ImplDeleter>{impl, ImplDeleter{std::move(pool)}};
+}
+
 AsyncInvoke::~AsyncInvoke() = default;
 
 bool AsyncInvoke::IsReady()
@@ -70,6 +184,31 @@ bool AsyncInvoke::WaitForReady(double seconds)
   return m_impl->WaitForReady(seconds);
 }
 
+std::shared_ptr<CompletionHandle> AsyncInvoke::GetCompletionHandle()
+{
+  return m_impl->GetCompletionHandle();
+}
+
+sup::dto::uint64 AsyncInvoke::GetExpirationDeadline() const
+{
+  return m_impl->GetExpirationDeadline();
+}
+
+sup::dto::uint64 AsyncInvoke::GetLastAccess() const
+{
+  return m_impl->GetLastAccess();
+}
+
+std::size_t AsyncInvoke::GetReplySize() const
+{
+  return m_impl->GetReplySize();
+}
+
+AsyncInvoke::Timestamps AsyncInvoke::GetTimestamps() const
+{
+  return m_impl->GetTimestamps();
+}
+
 bool AsyncInvoke::IsReadyForRemoval() const
 {
   return m_impl->IsReadyForRemoval();
@@ -80,48 +219,99 @@ AsyncInvoke::Reply AsyncInvoke::GetReply()
   return m_impl->GetReply();
 }
 
-void AsyncInvoke::Invalidate()
+std::size_t AsyncInvoke::EvictReply()
+{
+  return m_impl->EvictReply();
+}
+
+bool AsyncInvoke::Invalidate()
 {
-  m_impl->Invalidate();
+  return m_impl->Invalidate();
 }
 
 AsyncInvoke::AsyncInvokeImpl::AsyncInvokeImpl(Protocol& protocol,
                                               const sup::dto::AnyValue& input,
-                                              double expiration_sec)
-  : m_future{}
+                                              double expiration_sec,
+                                              AsyncExecutor& executor,
+                                              AsyncInvoke::FinishedCallback on_finished,
+                                              AsyncInvoke::CompletedCallback on_completed,
+                                              std::shared_ptr<ReplySpillStore> spill_store,
+                                              const Clock& clock,
+                                              const std::shared_ptr<SlabPool>& pool)
+  : m_clock{clock}
+  , m_task{std::allocate_shared<InvokeTask>(PoolAllocator<InvokeTask>{pool}, protocol, input,
+                                            clock, std::move(on_finished),
+                                            std::move(on_completed), std::move(spill_store))}
+  , m_completion{m_task, &m_task->m_completion}
+  , m_reply_retrieved{false}
   , m_invalidated{false}
-  , m_last_access{utils::GetCurrentTimestamp()}
+  , m_last_access{clock.GetTimestamp()}
   , m_expiration_time_ns{utils::ToNanoseconds(expiration_sec)}
+  , m_accepted{m_last_access}
+  , m_first_ready{AsyncInvoke::kStageNotReached}
+  , m_fetched{AsyncInvoke::kStageNotReached}
 {
-  // input is captured with copy, since it may be a temporary object
-  auto func = [&protocol, input]() {
-    sup::dto::AnyValue output{};
-    auto result = protocol.Invoke(input, output);
-    return AsyncInvoke::Reply{ result, output };
-  };
-  m_future = std::async(std::launch::async, func);
+  InvokeTask::Submit(m_task, executor);
 }
 
-AsyncInvoke::AsyncInvokeImpl::~AsyncInvokeImpl() = default;
+AsyncInvoke::AsyncInvokeImpl::~AsyncInvokeImpl()
+{
+  // The submitted task references the protocol, so it needs to finish first
+  m_completion->Wait();
+}
 
 bool AsyncInvoke::AsyncInvokeImpl::WaitForReady(double seconds)
 {
-  if (!m_future.valid() || m_invalidated)
+  auto completion = GetCompletionHandle();
+  if (!completion || !completion->WaitForReady(seconds))
   {
     return false;
   }
+  if (m_first_ready == AsyncInvoke::kStageNotReached)
+  {
+    m_first_ready = m_clock.GetTimestamp();
+  }
+  return true;
+}
+
+std::shared_ptr<CompletionHandle> AsyncInvoke::AsyncInvokeImpl::GetCompletionHandle()
+{
+  if (m_reply_retrieved || m_invalidated)
+  {
+    return {};
+  }
   UpdateLastAccess();
-  auto duration = std::chrono::duration<double>(seconds);
-  return m_future.wait_for(duration) == std::future_status::ready;
+  return m_completion;
+}
+
+sup::dto::uint64 AsyncInvoke::AsyncInvokeImpl::GetExpirationDeadline() const
+{
+  return m_last_access + m_expiration_time_ns;
+}
+
+sup::dto::uint64 AsyncInvoke::AsyncInvokeImpl::GetLastAccess() const
+{
+  return m_last_access;
+}
+
+std::size_t AsyncInvoke::AsyncInvokeImpl::GetReplySize() const
+{
+  return m_completion->GetReplySize();
+}
+
+AsyncInvoke::Timestamps AsyncInvoke::AsyncInvokeImpl::GetTimestamps() const
+{
+  return { m_accepted, m_task->m_started.load(), m_task->m_completed.load(), m_first_ready,
+           m_fetched };
 }
 
 bool AsyncInvoke::AsyncInvokeImpl::IsReadyForRemoval() const
 {
-  if (!m_future.valid())
+  if (m_reply_retrieved)
   {
     return true;
   }
-  const bool is_ready = m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  const bool is_ready = m_completion->IsReady();
   const bool expired = IsExpired();
   const bool is_no_longer_needed = m_invalidated || expired;
   return is_ready && is_no_longer_needed;
@@ -130,40 +320,157 @@ bool AsyncInvoke::AsyncInvokeImpl::IsReadyForRemoval() const
 AsyncInvoke::Reply AsyncInvoke::AsyncInvokeImpl::GetReply()
 {
   const AsyncInvoke::Reply failure{ InvalidAsynchronousOperationError, {} };
-  if (!m_future.valid() ||
-      (m_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) ||
-       m_invalidated)
+  if (m_reply_retrieved || !m_completion->IsReady() || m_invalidated)
   {
     return failure;
   }
-  AsyncInvoke::Reply reply{ Success, {} };
-  try
-  {
-    reply = m_future.get();
-  }
-  catch(...)
+  m_reply_retrieved = true;
+  m_fetched = m_clock.GetTimestamp();
+  return m_completion->TakeReply();
+}
+
+std::size_t AsyncInvoke::AsyncInvokeImpl::EvictReply()
+{
+  if (m_reply_retrieved || m_invalidated || !m_completion->IsReady())
   {
-    reply = { ServerProtocolException, {} };
+    return 0;
   }
-  return reply;
+  return m_completion->ReplaceReply({ AsynchronousReplyEvicted, {} });
 }
 
-void AsyncInvoke::AsyncInvokeImpl::Invalidate()
+bool AsyncInvoke::AsyncInvokeImpl::Invalidate()
 {
+  if (m_reply_retrieved || m_invalidated)
+  {
+    return false;
+  }
   m_invalidated = true;
+  if (m_completion->Cancel())
+  {
+    // The task will never start, so finish the request here. The executor may hold on to the task
+    // until it would have run, so release the copied input already.
+    m_task->ReleaseInput();
+    if (m_task->m_on_finished)
+    {
+      m_task->m_on_finished(0);
+    }
+    m_completion->SetReply({ InvalidAsynchronousOperationError, {} }, 0);
+  }
+  return true;
 }
 
 void AsyncInvoke::AsyncInvokeImpl::UpdateLastAccess()
 {
-  m_last_access = utils::GetCurrentTimestamp();
+  m_last_access = m_clock.GetTimestamp();
 }
 
 bool AsyncInvoke::AsyncInvokeImpl::IsExpired() const
 {
-  const auto now = utils::GetCurrentTimestamp();
+  const auto now = m_clock.GetTimestamp();
   return (now - m_last_access) > m_expiration_time_ns;
 }
 
+void AsyncInvoke::ImplDeleter::operator()(AsyncInvokeImpl* impl) const
+{
+  impl->~AsyncInvokeImpl();
+  PoolAllocator<AsyncInvokeImpl>{m_pool}.deallocate(impl, 1);
+}
+
+namespace
+{
+InvokeTask::InvokeTask(Protocol& protocol, const sup::dto::AnyValue& input, const Clock& clock,
+                       AsyncInvoke::FinishedCallback on_finished,
+                       AsyncInvoke::CompletedCallback on_completed,
+                       std::shared_ptr<ReplySpillStore> spill_store)
+  : m_completion{}
+  , m_started{AsyncInvoke::kStageNotReached}
+  , m_completed{AsyncInvoke::kStageNotReached}
+  , m_on_finished{std::move(on_finished)}
+  , m_protocol{protocol}
+  , m_input{input}
+  , m_clock{clock}
+  , m_on_completed{std::move(on_completed)}
+  , m_spill_store{std::move(spill_store)}
+{}
+
+InvokeTask::~InvokeTask() = default;
+
+void InvokeTask::Submit(std::shared_ptr<InvokeTask> task, AsyncExecutor& executor)
+{
+  executor.Submit([task = std::move(task)]() { task->Run(); });
+}
+
+void InvokeTask::ReleaseInput()
+{
+  m_input = sup::dto::AnyValue{};
+}
+
+void InvokeTask::Run()
+{
+  if (!m_completion.TryStart())
+  {
+    // Cancelled before it started: the owner already finished the request
+    return;
+  }
+  m_started.store(m_clock.GetTimestamp());
+  AsyncInvoke::Reply reply{ Success, {} };
+  try
+  {
+    CancellationScope cancellation_scope{m_completion};
+    sup::dto::AnyValue output{};
+    auto result = m_protocol.Invoke(m_input, output);
+    reply = AsyncInvoke::Reply{ result, output };
+  }
+  catch(...)
+  {
+    reply = { ServerProtocolException, {} };
+  }
+  m_completed.store(m_clock.GetTimestamp());
+  // The input is no longer needed, while this object lives on until the request is removed
+  m_input = sup::dto::AnyValue{};
+  if (m_completion.IsCancelled())
+  {
+    // Nobody will retrieve the output, so release its memory right away
+    reply.second = sup::dto::AnyValue{};
+  }
+  const auto result = reply.first;
+  auto reply_size = GetApproximateSize(reply.second);
+  std::unique_ptr<SpilledValue> spilled_payload;
+  if (m_spill_store && m_spill_store->ShouldSpill(reply_size))
+  {
+    spilled_payload = m_spill_store->Spill(reply.second);
+  }
+  if (spilled_payload)
+  {
+    reply.second = sup::dto::AnyValue{};
+    reply_size = 0;
+  }
+  if (m_on_finished)
+  {
+    m_on_finished(reply_size);
+  }
+  if (spilled_payload)
+  {
+    m_completion.SetReply(result, std::move(spilled_payload));
+  }
+  else
+  {
+    m_completion.SetReply(std::move(reply), reply_size);
+  }
+  if (m_on_completed)
+  {
+    try
+    {
+      m_on_completed(result);
+    }
+    catch(...)
+    {
+      // Notification is best effort: the reply is available anyway.
+    }
+  }
+}
+}  // unnamed namespace
+
 }  // namespace protocol
 
 }  // namespace sup
@@ -21,9 +21,18 @@
 #ifndef SUP_PROTOCOL_ASYNC_INVOKE_H_
 #define SUP_PROTOCOL_ASYNC_INVOKE_H_
 
+#include "clock.h"
+#include "completion_handle.h"
+#include "reply_spill_store.h"
+#include "slab_pool.h"
+
+#include <sup/protocol/async_executor.h>
 #include <sup/protocol/protocol_rpc.h>
 #include <sup/protocol/protocol.h>
 
+#include <cstddef>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <utility>
 
@@ -35,7 +44,7 @@ namespace protocol
  * @brief This class handles asynchronous calls to Protocol::Invoke.
  *
  * @note Clients of this class are responsible for thread safety. Clients should also be aware that
- * if IsReady() returns false, this does not necessarily mean the encapsulated thread is still
+ * if IsReady() returns false, this does not necessarily mean the encapsulated task is still
  * running. IsReady returns false also when the reply was already retrieved (after GetReply) or no
  * longer needed (after Invalidate).
  */
@@ -43,16 +52,126 @@ class AsyncInvoke
 {
 public:
   using Reply = std::pair<ProtocolResult, sup::dto::AnyValue>;
+  using FinishedCallback = std::function<void(std::size_t)>;
+  using CompletedCallback = std::function<void(const ProtocolResult&)>;
+
+  /**
+   * @brief Timestamp of a lifecycle stage that was not reached (yet).
+   */
+  static constexpr sup::dto::uint64 kStageNotReached = std::numeric_limits<sup::dto::uint64>::max();
+
+  /**
+   * @brief Timestamps, from the clock of the AsyncInvoke, of the stages in the lifecycle of the
+   * request. Stages that were not reached are set to kStageNotReached.
+   */
+  struct Timestamps
+  {
+    sup::dto::uint64 m_accepted;
+    sup::dto::uint64 m_started;
+    sup::dto::uint64 m_completed;
+    sup::dto::uint64 m_first_ready;
+    sup::dto::uint64 m_fetched;
+  };
+
+  /**
+   * @brief Constructor that will immediately submit a task to the executor that calls
+   * Protocol::Invoke on the given protocol with the given input.
+   *
+   * @param protocol Protocol to invoke.
+   * @param input AnyValue to pass as input to Protocol::Invoke.
+   * @param expiration_sec Time in seconds for an asynchronous invoke to become expired.
+   * @param executor Executor that will run the call to Protocol::Invoke.
+   */
+  AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input, double expiration_sec,
+              AsyncExecutor& executor);
+
+  /**
+   * @brief Constructor that will immediately submit a task to the executor that calls
+   * Protocol::Invoke on the given protocol with the given input.
+   *
+   * @param protocol Protocol to invoke.
+   * @param input AnyValue to pass as input to Protocol::Invoke.
+   * @param expiration_sec Time in seconds for an asynchronous invoke to become expired.
+   * @param executor Executor that will run the call to Protocol::Invoke.
+   * @param on_finished Callback that is called by the executing task when Protocol::Invoke has
+   * finished, right before the reply becomes ready. It receives the approximate size in bytes of
+   * the reply (see GetReplySize()).
+   */
+  AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input, double expiration_sec,
+              AsyncExecutor& executor, FinishedCallback on_finished);
+
+  /**
+   * @brief Constructor that will immediately submit a task to the executor that calls
+   * Protocol::Invoke on the given protocol with the given input.
+   *
+   * @param protocol Protocol to invoke.
+   * @param input AnyValue to pass as input to Protocol::Invoke.
+   * @param expiration_sec Time in seconds for an asynchronous invoke to become expired.
+   * @param executor Executor that will run the call to Protocol::Invoke.
+   * @param on_finished Callback that is called by the executing task when Protocol::Invoke has
+   * finished, right before the reply becomes ready. It receives the approximate size in bytes of
+   * the reply (see GetReplySize()).
+   * @param on_completed Callback that is called by the executing task with the result of
+   * Protocol::Invoke, right after the reply became ready. Since this object can already be
+   * destroyed at that time, the callback should not reference it.
+   */
+  AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input, double expiration_sec,
+              AsyncExecutor& executor, FinishedCallback on_finished,
+              CompletedCallback on_completed);
 
   /**
-   * @brief Constructor that will immediately launch a thread that calls Protocol::Invoke on the
-   * given protocol with the given input.
+   * @brief Constructor that will immediately submit a task to the executor that calls
+   * Protocol::Invoke on the given protocol with the given input.
    *
    * @param protocol Protocol to invoke.
    * @param input AnyValue to pass as input to Protocol::Invoke.
    * @param expiration_sec Time in seconds for an asynchronous invoke to become expired.
+   * @param executor Executor that will run the call to Protocol::Invoke.
+   * @param on_finished Callback that is called by the executing task when Protocol::Invoke has
+   * finished, right before the reply becomes ready. It receives the approximate size in bytes of
+   * the reply (see GetReplySize()).
+   * @param on_completed Callback that is called by the executing task with the result of
+   * Protocol::Invoke, right after the reply became ready. Since this object can already be
+   * destroyed at that time, the callback should not reference it.
+   * @param spill_store Optional store for moving large outputs of Protocol::Invoke out of memory
+   * until the reply is retrieved. Spilled replies are reported with size zero.
+   * @param clock Clock for tracking the last access and expiration. It needs to outlive this
+   * object. The other constructors use the steady clock.
+   */
+  AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input, double expiration_sec,
+              AsyncExecutor& executor, FinishedCallback on_finished,
+              CompletedCallback on_completed, std::shared_ptr<ReplySpillStore> spill_store,
+              const Clock& clock);
+
+  /**
+   * @brief Constructor that will immediately submit a task to the executor that calls
+   * Protocol::Invoke on the given protocol with the given input.
+   *
+   * @param protocol Protocol to invoke.
+   * @param input AnyValue to pass as input to Protocol::Invoke.
+   * @param expiration_sec Time in seconds for an asynchronous invoke to become expired.
+   * @param executor Executor that will run the call to Protocol::Invoke.
+   * @param on_finished Callback that is called by the executing task when Protocol::Invoke has
+   * finished, right before the reply becomes ready. It receives the approximate size in bytes of
+   * the reply (see GetReplySize()).
+   * @param on_completed Callback that is called by the executing task with the result of
+   * Protocol::Invoke, right after the reply became ready. Since this object can already be
+   * destroyed at that time, the callback should not reference it.
+   * @param spill_store Optional store for moving large outputs of Protocol::Invoke out of memory
+   * until the reply is retrieved. Spilled replies are reported with size zero.
+   * @param clock Clock for tracking the last access and expiration. It needs to outlive this
+   * object.
+   * @param pool Optional pool for the internal state of this object and its task. Without pool,
+   * the global operator new is used.
+   */
+  AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input, double expiration_sec,
+              AsyncExecutor& executor, FinishedCallback on_finished,
+              CompletedCallback on_completed, std::shared_ptr<ReplySpillStore> spill_store,
+              const Clock& clock, std::shared_ptr<SlabPool> pool);
+
+  /**
+   * @brief Destructor. Waits for the submitted task to finish, since it references the protocol.
    */
-  AsyncInvoke(Protocol& protocol, const sup::dto::AnyValue& input, double expiration_sec);
   ~AsyncInvoke();
 
   // No copy/move ctor/assignment:
@@ -76,7 +195,50 @@ public:
   bool WaitForReady(double seconds);
 
   /**
-   * @brief Check if this AsyncInvoke object is ready for destruction, i.e. the encapsulated thread
+   * @brief Get the shared completion signal of the encapsulated task. This allows waiting for the
+   * reply without keeping this object (or the container it lives in) locked. Like IsReady(), this
+   * counts as an access for the expiration of the request.
+   *
+   * @return Completion handle or an empty pointer if the reply was already retrieved or is no
+   * longer needed.
+   */
+  std::shared_ptr<CompletionHandle> GetCompletionHandle();
+
+  /**
+   * @brief Get the time after which this request expires, unless it is accessed again.
+   *
+   * @return Expiration deadline as a timestamp in nanoseconds of the clock of this object.
+   */
+  sup::dto::uint64 GetExpirationDeadline() const;
+
+  /**
+   * @brief Get the time of the last access to this request (see GetCompletionHandle()), or of its
+   * construction if it was never accessed.
+   *
+   * @return Last access as a timestamp in nanoseconds of the clock of this object.
+   */
+  sup::dto::uint64 GetLastAccess() const;
+
+  /**
+   * @brief Get the approximate memory held by the reply of the encapsulated task, as reported to
+   * the finished callback. This stays constant after the reply became ready, even when it was
+   * retrieved, so owners can release exactly what they accounted for.
+   *
+   * @return Approximate reply size in bytes or zero if the reply is not ready.
+   */
+  std::size_t GetReplySize() const;
+
+  /**
+   * @brief Get the timestamps of the lifecycle stages of the request: when it was accepted (i.e.
+   * constructed), when Protocol::Invoke started and completed, when the reply was first found to
+   * be ready and when it was retrieved.
+   *
+   * @return Lifecycle timestamps.
+   */
+  Timestamps GetTimestamps() const;
+
+  /**
+   * @brief Check if this AsyncInvoke object is ready for destruction, i.e. the encapsulated task
    * has finished and the reply was already retrieved or no longer needed.
    *
    * @return true if this AsyncInvoke object is ready for destruction.
@@ -84,20 +246,41 @@ public:
   bool IsReadyForRemoval() const;
 
   /**
-   * @brief Retrieve the reply from the encapsulated thread. This is only possible if IsReady() would
+   * @brief Retrieve the reply from the encapsulated task. This is only possible if IsReady() would
    * return true.
    *
-   * @return The reply from the encapsulated thread or a failure reply if it was not ready.
+   * @return The reply from the encapsulated task or a failure reply if it was not ready.
    */
   Reply GetReply();
 
   /**
-   * @brief Indicate that the reply of the encapsulated thread is no longer needed.
+   * @brief Drop a reply that is ready, but not retrieved yet, to release its memory. Retrieving the
+   * reply afterwards results in AsynchronousReplyEvicted.
+   *
+   * @return Approximate size in bytes of the dropped reply or zero if nothing was dropped.
+   */
+  std::size_t EvictReply();
+
+  /**
+   * @brief Indicate that the reply of the encapsulated task is no longer needed. This also cancels
+   * the task: if it did not start yet, it will never call Protocol::Invoke (nor the completed
+   * callback) and this object is immediately ready for removal. A running task can detect the
+   * cancellation through IsInvocationCancelled(); its output is then discarded as soon as it
+   * finishes.
+   *
+   * @return true if this call abandoned the request, i.e. it was neither retrieved nor invalidated
+   * before.
    */
-  void Invalidate();
+  bool Invalidate();
 private:
   class AsyncInvokeImpl;
-  std::unique_ptr<AsyncInvokeImpl> m_impl;
+  // Returns the implementation to the pool it was allocated from
+  struct ImplDeleter
+  {
+    std::shared_ptr<SlabPool> m_pool;
+    void operator()(AsyncInvokeImpl* impl) const;
+  };
+  std::unique_ptr<AsyncInvokeImpl, ImplDeleter> m_impl;
 };
 
 }  // namespace protocol
@@ -20,18 +20,144 @@
 
 #include "async_invoke_server.h"
 
+#include <sup/protocol/exceptions.h>
+#include <sup/protocol/function_protocol.h>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
 namespace sup
 {
 namespace protocol
 {
+namespace
+{
+// Minimum size of an expiration queue before it is compacted
+const std::size_t kMinCompactionSize = 64;
+
+// Number of blocks that a request pool allocates at once for each block size
+const std::size_t kBlocksPerSlab = 64;
+
+// Weight of the latest completion time in the estimates used for retry-after hints
+const double kCompletionTimeSmoothing = 0.2;
+
+// Maximum number of request shapes with a completion time estimate
+const std::size_t kMaxRequestShapes = 256;
+
+// Once a request takes longer than estimated, suggest polling again after this fraction of the
+// estimate
+const double kOverdueRetryFraction = 0.1;
+
+/**
+ * @brief Holds back the completion callback of a request while the server waits to answer it
+ * inline, so that clients are not notified about requests whose identifier they never receive.
+ */
+class InlineCompletionGate
+{
+public:
+  InlineCompletionGate(AsyncCompletionCallback callback, sup::dto::uint64 id);
+
+  // Called by the executing task
+  void Complete(const ProtocolResult& result);
+
+  // Called once the grace period is over. A result that was held back is reported now, unless
+  // the request was answered inline. The task can still be reporting after the reply became
+  // ready, so results of requests answered inline are also dropped after this call.
+  void Release(bool answered_inline);
+private:
+  const AsyncCompletionCallback m_callback;
+  const sup::dto::uint64 m_id;
+  std::mutex m_mtx;
+  bool m_holding;
+  bool m_answered_inline;
+  bool m_completed;
+  ProtocolResult m_result;
+};
+
+/**
+ * @brief Executor that submits to the priority scheduler with a fixed priority and remembers the
+ * sequence number of the last queued task, so that task can be withdrawn later.
+ */
+class SequenceRecordingExecutor : public AsyncExecutor
+{
+public:
+  SequenceRecordingExecutor(PriorityScheduler& scheduler, AsyncPriority priority);
+  ~SequenceRecordingExecutor() override;
+
+  void Submit(Task task) override;
+
+  std::size_t GetSequence() const;
+private:
+  PriorityScheduler& m_scheduler;
+  const AsyncPriority m_priority;
+  std::size_t m_sequence;
+};
+
+ProtocolRPCServerConfig CreateServerConfig(double expiration_sec,
+                                           std::shared_ptr<AsyncExecutor> executor);
+std::shared_ptr<AsyncExecutor> GetAsyncExecutor(const ProtocolRPCServerConfig& config);
+std::shared_ptr<ReplySpillStore> CreateReplySpillStore(const ProtocolRPCServerConfig& config);
+std::shared_ptr<SlabPool> CreateRequestPool(const ProtocolRPCServerConfig& config);
+bool TryIncrementBelowLimit(std::atomic<std::size_t>& counter, std::size_t limit);
+std::string GetRequestShape(const sup::dto::AnyValue& payload);
+void RecordStageLatency(LatencyHistogram& histogram, sup::dto::uint64 begin,
+                        sup::dto::uint64 end);
+}  // unnamed namespace
 
 AsyncInvokeServer::AsyncInvokeServer(Protocol& protocol, double expiration_sec)
+  : AsyncInvokeServer{protocol, ProtocolRPCServerConfig{expiration_sec}}
+{}
+
+AsyncInvokeServer::AsyncInvokeServer(Protocol& protocol, double expiration_sec,
+                                     std::shared_ptr<AsyncExecutor> executor)
+  : AsyncInvokeServer{protocol, CreateServerConfig(expiration_sec, std::move(executor))}
+{}
+
+AsyncInvokeServer::AsyncInvokeServer(Protocol& protocol, const ProtocolRPCServerConfig& config)
+  : AsyncInvokeServer{protocol, config,
+                      config.m_coarse_clock ? GetCoarseClock() : GetSteadyClock()}
+{}
+
+AsyncInvokeServer::AsyncInvokeServer(Protocol& protocol, const ProtocolRPCServerConfig& config,
+                                     const Clock& clock)
   : m_protocol{protocol}
-  , m_expiration_sec{expiration_sec}
-  , m_invokes{}
-  , m_mtx{}
+  , m_clock{clock}
+  , m_expiration_sec{config.m_expiration_sec}
+  , m_max_active_requests{config.m_max_active_requests}
+  , m_max_retained_requests{config.m_max_retained_requests}
+  , m_background_cleanup{config.m_cleanup_interval_sec > 0.0}
+  , m_max_poll_wait_sec{config.m_max_poll_wait_sec}
+  , m_inline_grace_sec{config.m_inline_grace_sec}
+  , m_retry_after_hints{config.m_retry_after_hints}
+  , m_max_retained_reply_bytes{config.m_max_retained_reply_bytes}
+  , m_completion_callback{config.m_completion_callback}
+  , m_active_requests{0}
+  , m_retained_reply_size{0}
+  , m_spill_store{CreateReplySpillStore(config)}
+  , m_executor{GetAsyncExecutor(config)}
+  , m_scheduler{*m_executor, config.m_max_priority_skips}
+  , m_shards{}
+  , m_retained_requests{0}
+  , m_abandoned_requests{0}
+  , m_evicted_replies{0}
+  , m_eviction_mtx{}
+  , m_queue_time{}
+  , m_execution_time{}
+  , m_poll_delay{}
+  , m_fetch_time{}
+  , m_completion_times{kCompletionTimeSmoothing, kMaxRequestShapes}
   , m_last_id{0}
-{}
+  , m_key_mtx{}
+  , m_key_index{}
+{
+  for (auto& shard : m_shards)
+  {
+    shard.m_pool = CreateRequestPool(config);
+    shard.m_invokes = RequestMap{RequestMap::allocator_type{shard.m_pool}};
+  }
+}
 
 AsyncInvokeServer::~AsyncInvokeServer() = default;
 
@@ -39,9 +165,27 @@ sup::dto::AnyValue AsyncInvokeServer::HandleInvoke(const sup::dto::AnyValue& pay
                                                    PayloadEncoding encoding,
                                                    AsyncCommand command)
 {
+  return HandleInvoke(payload, encoding, command, AsyncPriority::kNormal);
+}
+
+sup::dto::AnyValue AsyncInvokeServer::HandleInvoke(const sup::dto::AnyValue& payload,
+                                                   PayloadEncoding encoding,
+                                                   AsyncCommand command,
+                                                   AsyncPriority priority)
+{
+  return HandleInvoke(payload, encoding, command, priority, std::string{});
+}
+
+sup::dto::AnyValue AsyncInvokeServer::HandleInvoke(const sup::dto::AnyValue& payload,
+                                                   PayloadEncoding encoding,
+                                                   AsyncCommand command,
+                                                   AsyncPriority priority,
+                                                   const std::string& key)
+{
+  EnforceReplyBudget();
   if (command == AsyncCommand::kInitialRequest)
   {
-    return NewRequest(payload, encoding);
+    return NewRequest(payload, encoding, priority, key);
   }
   auto id_info = ExtractAsyncRequestId(payload);
   if (!id_info.first)
@@ -51,7 +195,8 @@ sup::dto::AnyValue AsyncInvokeServer::HandleInvoke(const sup::dto::AnyValue& pay
   switch (command)
   {
   case AsyncCommand::kPoll:
-    return Poll(id_info.second, encoding);
+    return Poll(id_info.second, encoding, ExtractAsyncPollWait(payload),
+                ExtractAsyncInlineReply(payload));
   case AsyncCommand::kGetReply:
     return GetReply(id_info.second, encoding);
   case AsyncCommand::kInvalidate:
@@ -64,46 +209,249 @@ sup::dto::AnyValue AsyncInvokeServer::HandleInvoke(const sup::dto::AnyValue& pay
 
 bool AsyncInvokeServer::WaitForReady(sup::dto::uint64 id, double seconds)
 {
-  std::lock_guard<std::mutex> lk{m_mtx};
-  auto iter = m_invokes.find(id);
-  if (iter == m_invokes.end())
+  auto completion = GetCompletionHandle(id);
+  return completion && completion->WaitForReady(seconds);
+}
+
+void AsyncInvokeServer::CleanUpExpiredRequests()
+{
+  const auto now = m_clock.GetTimestamp();
+  for (auto& shard : m_shards)
   {
-    return false;
+    std::lock_guard<std::mutex> lk{shard.m_mtx};
+    RemoveExpiredRequests(shard, now);
   }
-  return iter->second.WaitForReady(seconds);
+  EnforceReplyBudget();
 }
 
-void AsyncInvokeServer::CleanUpExpiredRequests()
+std::size_t AsyncInvokeServer::GetNumberOfActiveRequests() const
+{
+  return m_active_requests.load();
+}
+
+std::size_t AsyncInvokeServer::GetNumberOfRetainedRequests() const
+{
+  return m_retained_requests.load();
+}
+
+std::size_t AsyncInvokeServer::GetNumberOfAbandonedRequests() const
+{
+  return m_abandoned_requests.load();
+}
+
+std::size_t AsyncInvokeServer::GetRetainedReplySize() const
+{
+  return m_retained_reply_size.load();
+}
+
+std::size_t AsyncInvokeServer::GetNumberOfEvictedReplies() const
+{
+  return m_evicted_replies.load();
+}
+
+std::size_t AsyncInvokeServer::GetNumberOfSpilledReplies() const
+{
+  return m_spill_store ? m_spill_store->GetNumberOfSpilledValues() : 0;
+}
+
+const Clock& AsyncInvokeServer::GetClock() const
+{
+  return m_clock;
+}
+
+AsyncLatencyStatistics AsyncInvokeServer::GetLatencyStatistics() const
+{
+  return { m_queue_time.GetSnapshot(), m_execution_time.GetSnapshot(),
+           m_poll_delay.GetSnapshot(), m_fetch_time.GetSnapshot() };
+}
+
+void AsyncInvokeServer::ResetLatencyStatistics()
+{
+  m_queue_time.Reset();
+  m_execution_time.Reset();
+  m_poll_delay.Reset();
+  m_fetch_time.Reset();
+}
+
+sup::dto::AnyValue AsyncInvokeServer::NewRequest(const sup::dto::AnyValue& payload,
+                                                 PayloadEncoding encoding,
+                                                 AsyncPriority priority,
+                                                 const std::string& key)
 {
-  std::lock_guard<std::mutex> lk{m_mtx};
-  for (auto iter = m_invokes.begin(); iter != m_invokes.end();)
+  if (!key.empty())
   {
-    if (iter->second.IsReadyForRemoval())
+    // A retried request does not count against the limits
+    auto existing_id = FindRequestKey(key);
+    if (existing_id != 0)
     {
-      iter = m_invokes.erase(iter);
+      return CreateRetriedRequestReply(existing_id, encoding);
     }
-    else
+  }
+  if (!TryReserveRequest())
+  {
+    return utils::CreateAsyncRPCReply(ServerBusy, AsyncCommand::kInitialRequest);
+  }
+  auto id = GetRequestId();
+  auto on_finished = [this, id](std::size_t reply_size) {
+    if (reply_size > 0 && m_max_retained_reply_bytes > 0)
+    {
+      ReportReadyReply(id);
+    }
+    m_retained_reply_size += reply_size;
+    --m_active_requests;
+  };
+  // The completion callback is copied, since it can be called after the server was destroyed
+  AsyncInvoke::CompletedCallback on_completed{};
+  std::shared_ptr<InlineCompletionGate> gate;
+  if (m_completion_callback && m_inline_grace_sec > 0.0)
+  {
+    gate = std::make_shared<InlineCompletionGate>(m_completion_callback, id);
+    on_completed = [gate](const ProtocolResult& result) {
+      gate->Complete(result);
+    };
+  }
+  else if (m_completion_callback)
+  {
+    on_completed = [callback = m_completion_callback, id](const ProtocolResult& result) {
+      callback(id, result);
+    };
+  }
+  const auto shape = m_retry_after_hints ? GetRequestShape(payload) : std::string{};
+  auto& shard = GetShard(id);
+  std::shared_ptr<CompletionHandle> completion;
+  sup::dto::uint64 accepted = 0;
+  sup::dto::uint64 registered_id = id;
+  {
+    std::lock_guard<std::mutex> lk{shard.m_mtx};
+    if (!key.empty())
+    {
+      // A concurrent request with the same key may have registered in the meantime. Registering
+      // under the shard's lock makes a retry that finds this identifier wait for the insertion
+      // before it can look up the request.
+      registered_id = RegisterRequestKey(key, id);
+    }
+    if (registered_id == id)
+    {
+      auto iter = InsertRequest(shard, id, payload, priority, key, std::move(on_finished),
+                                std::move(on_completed));
+      if (m_retry_after_hints)
+      {
+        shard.m_shapes[id] = shape;
+        accepted = iter->second.GetTimestamps().m_accepted;
+      }
+      CompactExpirationQueue(shard);
+      if (m_inline_grace_sec > 0.0)
+      {
+        completion = iter->second.GetCompletionHandle();
+      }
+    }
+  }
+  if (registered_id != id)
+  {
+    ReleaseRequest();
+    return CreateRetriedRequestReply(registered_id, encoding);
+  }
+  // Wait without holding the lock and answer synchronously if the reply is ready in time
+  sup::dto::AnyValue inline_reply;
+  bool answered_inline = false;
+  if (completion && completion->WaitForReady(m_inline_grace_sec))
+  {
+    std::lock_guard<std::mutex> lk{shard.m_mtx};
+    auto iter = shard.m_invokes.find(id);
+    // A concurrent poll or clean up may have retired the request in the meantime
+    if (iter != shard.m_invokes.end() && !iter->second.IsReadyForRemoval()
+        && iter->second.IsReady())
     {
-      ++iter;
+      auto reply = iter->second.GetReply();
+      if (iter->second.IsReadyForRemoval())
+      {
+        EraseRequest(shard, iter);
+      }
+      inline_reply = utils::CreateRPCReply(reply.first, reply.second, encoding);
+      answered_inline = true;
     }
   }
+  if (gate)
+  {
+    gate->Release(answered_inline);
+  }
+  if (answered_inline)
+  {
+    return inline_reply;
+  }
+  return utils::CreateAsyncRPCNewRequestReply(id, encoding, m_max_poll_wait_sec,
+                                              GetRetryAfter(shape, accepted));
 }
 
-sup::dto::AnyValue AsyncInvokeServer::NewRequest(const sup::dto::AnyValue& payload,
-                                                 PayloadEncoding encoding)
+AsyncInvokeServer::RequestMap::iterator AsyncInvokeServer::InsertRequest(
+  RequestShard& shard, sup::dto::uint64 id, const sup::dto::AnyValue& payload,
+  AsyncPriority priority, const std::string& key, AsyncInvoke::FinishedCallback on_finished,
+  AsyncInvoke::CompletedCallback on_completed)
 {
-  std::lock_guard<std::mutex> lk{m_mtx};
-  auto id = GetRequestId();
-  (void)m_invokes.emplace(std::piecewise_construct, std::forward_as_tuple(id),
-                          std::forward_as_tuple(m_protocol, payload, m_expiration_sec));
-  return utils::CreateAsyncRPCNewRequestReply(id, encoding);
+  if (!key.empty())
+  {
+    shard.m_keys[id] = key;
+  }
+  SequenceRecordingExecutor executor{m_scheduler, priority};
+  RequestMap::iterator iter;
+  try
+  {
+    iter = shard.m_invokes.emplace(std::piecewise_construct, std::forward_as_tuple(id),
+                                   std::forward_as_tuple(m_protocol, payload, m_expiration_sec,
+                                                         executor,
+                                                         std::move(on_finished),
+                                                         std::move(on_completed),
+                                                         m_spill_store, m_clock,
+                                                         shard.m_pool)).first;
+  }
+  catch(...)
+  {
+    // The task was not submitted, so nothing will finish this request
+    ReleaseRequestKey(shard, id);
+    ReleaseRequest();
+    throw;
+  }
+  if (executor.GetSequence() != 0)
+  {
+    shard.m_queued_tasks[id] = executor.GetSequence();
+  }
+  shard.m_expirations.Push(id, iter->second.GetExpirationDeadline());
+  return iter;
 }
 
-sup::dto::AnyValue AsyncInvokeServer::Poll(sup::dto::uint64 id, PayloadEncoding encoding)
+sup::dto::AnyValue AsyncInvokeServer::CreateRetriedRequestReply(sup::dto::uint64 id,
+                                                                PayloadEncoding encoding)
 {
-  std::lock_guard<std::mutex> lk{m_mtx};
-  auto iter = m_invokes.find(id);
-  if (iter == m_invokes.end())
+  double retry_after = 0.0;
+  {
+    auto& shard = GetShard(id);
+    std::lock_guard<std::mutex> lk{shard.m_mtx};
+    auto iter = shard.m_invokes.find(id);
+    if (iter != shard.m_invokes.end())
+    {
+      retry_after = GetRetryAfter(shard, iter);
+    }
+  }
+  return utils::CreateAsyncRPCNewRequestReply(id, encoding, m_max_poll_wait_sec, retry_after);
+}
+
+sup::dto::AnyValue AsyncInvokeServer::Poll(sup::dto::uint64 id, PayloadEncoding encoding,
+                                           double wait_sec, bool inline_reply)
+{
+  wait_sec = std::min(wait_sec, m_max_poll_wait_sec);
+  if (wait_sec > 0.0)
+  {
+    // Hold the poll without locking the shard, then report the state as usual
+    auto completion = GetCompletionHandle(id);
+    if (completion)
+    {
+      (void)completion->WaitForReady(wait_sec);
+    }
+  }
+  auto& shard = GetShard(id);
+  std::lock_guard<std::mutex> lk{shard.m_mtx};
+  auto iter = shard.m_invokes.find(id);
+  if (iter == shard.m_invokes.end())
   {
     return utils::CreateAsyncRPCReply(InvalidRequestIdentifierError, AsyncCommand::kPoll);
   }
@@ -113,37 +461,59 @@ sup::dto::AnyValue AsyncInvokeServer::Poll(sup::dto::uint64 id, PayloadEncoding
   {
     return utils::CreateAsyncRPCReply(InvalidAsynchronousOperationError, AsyncCommand::kPoll);
   }
-  return utils::CreateAsyncRPCPollReply(iter->second.IsReady(), encoding);
+  if (!iter->second.IsReady())
+  {
+    return utils::CreateAsyncRPCPollReply(false, encoding, GetRetryAfter(shard, iter));
+  }
+  TouchReply(shard, iter);
+  if (!inline_reply)
+  {
+    return utils::CreateAsyncRPCPollReply(true, encoding);
+  }
+  // Include the reply and retire the request, as a separate GetReply will not follow
+  auto reply = iter->second.GetReply();
+  if (iter->second.IsReadyForRemoval())
+  {
+    EraseRequest(shard, iter);
+  }
+  return utils::CreateAsyncRPCPollReply(reply.first, reply.second, encoding);
 }
 
 sup::dto::AnyValue AsyncInvokeServer::GetReply(sup::dto::uint64 id, PayloadEncoding encoding)
 {
-  std::lock_guard<std::mutex> lk{m_mtx};
-  auto iter = m_invokes.find(id);
-  if (iter == m_invokes.end())
+  auto& shard = GetShard(id);
+  std::lock_guard<std::mutex> lk{shard.m_mtx};
+  auto iter = shard.m_invokes.find(id);
+  if (iter == shard.m_invokes.end())
   {
     return utils::CreateAsyncRPCReply(InvalidRequestIdentifierError, AsyncCommand::kGetReply);
   }
   auto reply = iter->second.GetReply();
   if (iter->second.IsReadyForRemoval())
   {
-    (void)m_invokes.erase(iter);
+    EraseRequest(shard, iter);
   }
   return utils::CreateAsyncRPCReply(reply.first, reply.second, encoding, AsyncCommand::kGetReply);
 }
 
 sup::dto::AnyValue AsyncInvokeServer::Invalidate(sup::dto::uint64 id)
 {
-  std::lock_guard<std::mutex> lk{m_mtx};
-  auto iter = m_invokes.find(id);
-  if (iter == m_invokes.end())
+  auto& shard = GetShard(id);
+  std::lock_guard<std::mutex> lk{shard.m_mtx};
+  auto iter = shard.m_invokes.find(id);
+  if (iter == shard.m_invokes.end())
   {
     return utils::CreateAsyncRPCReply(InvalidRequestIdentifierError, AsyncCommand::kInvalidate);
   }
-  iter->second.Invalidate();
+  AbandonRequest(shard, iter);
   if (iter->second.IsReadyForRemoval())
   {
-    (void)m_invokes.erase(iter);
+    EraseRequest(shard, iter);
+  }
+  else
+  {
+    // Still running: check again at the next clean up
+    shard.m_expirations.Push(id, m_clock.GetTimestamp());
   }
   return utils::CreateAsyncRPCReply(Success, AsyncCommand::kInvalidate);
 }
@@ -153,6 +523,369 @@ sup::dto::uint64 AsyncInvokeServer::GetRequestId()
   return ++m_last_id;
 }
 
+AsyncInvokeServer::RequestShard& AsyncInvokeServer::GetShard(sup::dto::uint64 id)
+{
+  return m_shards[id % kNumberOfShards];
+}
+
+std::shared_ptr<CompletionHandle> AsyncInvokeServer::GetCompletionHandle(sup::dto::uint64 id)
+{
+  auto& shard = GetShard(id);
+  std::lock_guard<std::mutex> lk{shard.m_mtx};
+  auto iter = shard.m_invokes.find(id);
+  if (iter == shard.m_invokes.end())
+  {
+    return {};
+  }
+  auto completion = iter->second.GetCompletionHandle();
+  TouchReply(shard, iter);
+  return completion;
+}
+
+bool AsyncInvokeServer::TryReserveRequest()
+{
+  if (!TryIncrementBelowLimit(m_active_requests, m_max_active_requests))
+  {
+    return false;
+  }
+  if (TryReserveRetainedRequest())
+  {
+    return true;
+  }
+  --m_active_requests;
+  return false;
+}
+
+bool AsyncInvokeServer::TryReserveRetainedRequest()
+{
+  if (TryIncrementBelowLimit(m_retained_requests, m_max_retained_requests))
+  {
+    return true;
+  }
+  // With a background clean up, an overloaded server should not also sweep on every request
+  if (m_background_cleanup)
+  {
+    return false;
+  }
+  // Try to make room by removing expired requests, only until there is room for one
+  const auto now = m_clock.GetTimestamp();
+  for (auto& shard : m_shards)
+  {
+    {
+      std::lock_guard<std::mutex> lk{shard.m_mtx};
+      RemoveExpiredRequests(shard, now);
+    }
+    if (TryIncrementBelowLimit(m_retained_requests, m_max_retained_requests))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void AsyncInvokeServer::ReleaseRequest()
+{
+  --m_active_requests;
+  --m_retained_requests;
+}
+
+sup::dto::uint64 AsyncInvokeServer::FindRequestKey(const std::string& key)
+{
+  std::lock_guard<std::mutex> lk{m_key_mtx};
+  auto iter = m_key_index.find(key);
+  return iter == m_key_index.end() ? 0 : iter->second;
+}
+
+sup::dto::uint64 AsyncInvokeServer::RegisterRequestKey(const std::string& key,
+                                                       sup::dto::uint64 id)
+{
+  std::lock_guard<std::mutex> lk{m_key_mtx};
+  auto result = m_key_index.emplace(key, id);
+  return result.first->second;
+}
+
+void AsyncInvokeServer::ReleaseRequestKey(RequestShard& shard, sup::dto::uint64 id)
+{
+  auto iter = shard.m_keys.find(id);
+  if (iter == shard.m_keys.end())
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lk{m_key_mtx};
+    auto key_iter = m_key_index.find(iter->second);
+    if (key_iter != m_key_index.end() && key_iter->second == id)
+    {
+      (void)m_key_index.erase(key_iter);
+    }
+  }
+  (void)shard.m_keys.erase(iter);
+}
+
+void AsyncInvokeServer::AbandonRequest(RequestShard& shard, RequestMap::iterator iter)
+{
+  if (!iter->second.Invalidate())
+  {
+    return;
+  }
+  // A task that is still queued in the scheduler is dropped right away, together with its input
+  auto queued_iter = shard.m_queued_tasks.find(iter->first);
+  if (queued_iter != shard.m_queued_tasks.end())
+  {
+    (void)m_scheduler.Withdraw(queued_iter->second);
+    (void)shard.m_queued_tasks.erase(queued_iter);
+  }
+  ++m_abandoned_requests;
+  // A retry with the same key needs to start over
+  ReleaseRequestKey(shard, iter->first);
+}
+
+bool AsyncInvokeServer::IsReplyBudgetExceeded() const
+{
+  return m_max_retained_reply_bytes > 0 &&
+         m_retained_reply_size.load() > m_max_retained_reply_bytes;
+}
+
+void AsyncInvokeServer::EnforceReplyBudget()
+{
+  if (!IsReplyBudgetExceeded())
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> eviction_lk{m_eviction_mtx};
+  while (IsReplyBudgetExceeded())
+  {
+    // The least recently accessed reply is at the head of one of the shards' eviction lists
+    RequestShard* oldest_shard = nullptr;
+    sup::dto::uint64 oldest_access = 0;
+    for (auto& shard : m_shards)
+    {
+      std::lock_guard<std::mutex> lk{shard.m_mtx};
+      TrackReadyReplies(shard);
+      if (shard.m_eviction_list.empty())
+      {
+        continue;
+      }
+      const auto last_access = shard.m_eviction_list.front().m_last_access;
+      if (oldest_shard == nullptr || last_access < oldest_access)
+      {
+        oldest_shard = &shard;
+        oldest_access = last_access;
+      }
+    }
+    if (oldest_shard == nullptr)
+    {
+      return;
+    }
+    std::lock_guard<std::mutex> lk{oldest_shard->m_mtx};
+    EvictOldestReply(*oldest_shard);
+  }
+}
+
+void AsyncInvokeServer::ReportReadyReply(sup::dto::uint64 id)
+{
+  auto& shard = GetShard(id);
+  std::lock_guard<std::mutex> lk{shard.m_ready_mtx};
+  shard.m_ready_ids.push_back(id);
+}
+
+void AsyncInvokeServer::TrackReadyReplies(RequestShard& shard)
+{
+  std::lock_guard<std::mutex> lk{shard.m_ready_mtx};
+  auto pending = shard.m_ready_ids.begin();
+  for (auto id : shard.m_ready_ids)
+  {
+    auto iter = shard.m_invokes.find(id);
+    if (iter == shard.m_invokes.end())
+    {
+      continue;
+    }
+    if (iter->second.GetReplySize() == 0)
+    {
+      // Reported just before the task stored the reply: try again next time
+      *pending++ = id;
+      continue;
+    }
+    // Requests can be accessed before their reply is ready, so search the position from the tail
+    const auto last_access = iter->second.GetLastAccess();
+    auto position = shard.m_eviction_list.end();
+    while (position != shard.m_eviction_list.begin()
+           && std::prev(position)->m_last_access > last_access)
+    {
+      --position;
+    }
+    shard.m_eviction_index[id] =
+      shard.m_eviction_list.insert(position, EvictionCandidate{ id, last_access });
+  }
+  (void)shard.m_ready_ids.erase(pending, shard.m_ready_ids.end());
+}
+
+void AsyncInvokeServer::TouchReply(RequestShard& shard, RequestMap::const_iterator iter)
+{
+  auto index_iter = shard.m_eviction_index.find(iter->first);
+  if (index_iter == shard.m_eviction_index.end())
+  {
+    return;
+  }
+  index_iter->second->m_last_access = iter->second.GetLastAccess();
+  shard.m_eviction_list.splice(shard.m_eviction_list.end(), shard.m_eviction_list,
+                               index_iter->second);
+}
+
+void AsyncInvokeServer::UntrackReply(RequestShard& shard, sup::dto::uint64 id)
+{
+  auto index_iter = shard.m_eviction_index.find(id);
+  if (index_iter == shard.m_eviction_index.end())
+  {
+    return;
+  }
+  (void)shard.m_eviction_list.erase(index_iter->second);
+  (void)shard.m_eviction_index.erase(index_iter);
+}
+
+void AsyncInvokeServer::EvictOldestReply(RequestShard& shard)
+{
+  if (shard.m_eviction_list.empty())
+  {
+    return;
+  }
+  const auto id = shard.m_eviction_list.front().m_id;
+  UntrackReply(shard, id);
+  auto iter = shard.m_invokes.find(id);
+  if (iter == shard.m_invokes.end())
+  {
+    return;
+  }
+  auto evicted_size = iter->second.EvictReply();
+  if (evicted_size > 0)
+  {
+    m_retained_reply_size -= evicted_size;
+    ++m_evicted_replies;
+  }
+}
+
+void AsyncInvokeServer::RemoveExpiredRequests(RequestShard& shard, sup::dto::uint64 now)
+{
+  for (auto id : shard.m_expirations.PopExpired(now))
+  {
+    auto iter = shard.m_invokes.find(id);
+    if (iter == shard.m_invokes.end())
+    {
+      // Already removed
+      continue;
+    }
+    if (iter->second.IsReadyForRemoval())
+    {
+      // Only counts as abandoned when it expired before its reply was retrieved
+      AbandonRequest(shard, iter);
+      EraseRequest(shard, iter);
+      continue;
+    }
+    auto deadline = iter->second.GetExpirationDeadline();
+    if (deadline > now)
+    {
+      // Accessed after being queued: requeue with the new deadline
+      shard.m_expirations.Push(id, deadline);
+      continue;
+    }
+    // Expired: cancel the request, which immediately finishes it when it did not start yet
+    AbandonRequest(shard, iter);
+    if (iter->second.IsReadyForRemoval())
+    {
+      EraseRequest(shard, iter);
+    }
+    else
+    {
+      // Still running: check again at the next clean up
+      shard.m_expirations.Push(id, now);
+    }
+  }
+}
+
+void AsyncInvokeServer::CompactExpirationQueue(RequestShard& shard)
+{
+  // Entries of removed requests stay in the queue until their deadline: rebuild the queue when
+  // these make up the majority of its entries.
+  auto queue_size = shard.m_expirations.GetSize();
+  if (queue_size < kMinCompactionSize || queue_size < 2 * shard.m_invokes.size())
+  {
+    return;
+  }
+  shard.m_expirations.Clear();
+  for (const auto& invoke : shard.m_invokes)
+  {
+    shard.m_expirations.Push(invoke.first, invoke.second.GetExpirationDeadline());
+  }
+}
+
+void AsyncInvokeServer::EraseRequest(RequestShard& shard, RequestMap::iterator iter)
+{
+  m_retained_reply_size -= iter->second.GetReplySize();
+  const auto timestamps = iter->second.GetTimestamps();
+  RecordLatencies(timestamps);
+  RecordCompletionTime(shard, iter->first, timestamps);
+  ReleaseRequestKey(shard, iter->first);
+  UntrackReply(shard, iter->first);
+  (void)shard.m_queued_tasks.erase(iter->first);
+  (void)shard.m_invokes.erase(iter);
+  --m_retained_requests;
+}
+
+void AsyncInvokeServer::RecordLatencies(const AsyncInvoke::Timestamps& timestamps)
+{
+  RecordStageLatency(m_queue_time, timestamps.m_accepted, timestamps.m_started);
+  RecordStageLatency(m_execution_time, timestamps.m_started, timestamps.m_completed);
+  RecordStageLatency(m_poll_delay, timestamps.m_completed, timestamps.m_first_ready);
+  RecordStageLatency(m_fetch_time, timestamps.m_completed, timestamps.m_fetched);
+}
+
+void AsyncInvokeServer::RecordCompletionTime(RequestShard& shard, sup::dto::uint64 id,
+                                             const AsyncInvoke::Timestamps& timestamps)
+{
+  auto iter = shard.m_shapes.find(id);
+  if (iter == shard.m_shapes.end())
+  {
+    return;
+  }
+  // Only requests whose reply was retrieved are known to have run to completion
+  if (timestamps.m_fetched != AsyncInvoke::kStageNotReached
+      && timestamps.m_completed != AsyncInvoke::kStageNotReached
+      && timestamps.m_completed >= timestamps.m_accepted)
+  {
+    m_completion_times.Record(iter->second, timestamps.m_completed - timestamps.m_accepted);
+  }
+  (void)shard.m_shapes.erase(iter);
+}
+
+double AsyncInvokeServer::GetRetryAfter(const std::string& shape, sup::dto::uint64 accepted) const
+{
+  if (!m_retry_after_hints)
+  {
+    return 0.0;
+  }
+  const auto estimate = m_completion_times.GetEstimate(shape);
+  if (estimate <= 0.0)
+  {
+    return 0.0;
+  }
+  const auto now = m_clock.GetTimestamp();
+  const auto elapsed_sec = now > accepted ? static_cast<double>(now - accepted) * 1e-9 : 0.0;
+  const auto retry_after = std::max(estimate - elapsed_sec, estimate * kOverdueRetryFraction);
+  // Each poll resets the expiration timer, but waiting longer than that would expire the request
+  return std::min(retry_after, 0.5 * m_expiration_sec);
+}
+
+double AsyncInvokeServer::GetRetryAfter(const RequestShard& shard,
+                                        RequestMap::const_iterator iter) const
+{
+  auto shape_iter = shard.m_shapes.find(iter->first);
+  if (shape_iter == shard.m_shapes.end())
+  {
+    return 0.0;
+  }
+  return GetRetryAfter(shape_iter->second, iter->second.GetTimestamps().m_accepted);
+}
+
 std::pair<bool, sup::dto::uint64> ExtractAsyncRequestId(const sup::dto::AnyValue& payload)
 {
   std::pair<bool, sup::dto::uint64> failure{ false, 0 };
@@ -168,6 +901,191 @@ std::pair<bool, sup::dto::uint64> ExtractAsyncRequestId(const sup::dto::AnyValue
   return { true, id_field.As<sup::dto::uint64>() };
 }
 
+double ExtractAsyncPollWait(const sup::dto::AnyValue& payload)
+{
+  if (!payload.HasField(constants::ASYNC_WAIT_FIELD_NAME))
+  {
+    return 0.0;
+  }
+  auto& wait_field = payload[constants::ASYNC_WAIT_FIELD_NAME];
+  if (wait_field.GetType() != sup::dto::Float64Type)
+  {
+    return 0.0;
+  }
+  return wait_field.As<sup::dto::float64>();
+}
+
+bool ExtractAsyncInlineReply(const sup::dto::AnyValue& payload)
+{
+  if (!payload.HasField(constants::ASYNC_INLINE_REPLY_FIELD_NAME))
+  {
+    return false;
+  }
+  auto& inline_field = payload[constants::ASYNC_INLINE_REPLY_FIELD_NAME];
+  return inline_field.GetType() == sup::dto::BooleanType && inline_field.As<sup::dto::boolean>();
+}
+
+namespace
+{
+InlineCompletionGate::InlineCompletionGate(AsyncCompletionCallback callback,
+                                           sup::dto::uint64 id)
+  : m_callback{std::move(callback)}
+  , m_id{id}
+  , m_mtx{}
+  , m_holding{true}
+  , m_answered_inline{false}
+  , m_completed{false}
+  , m_result{}
+{}
+
+void InlineCompletionGate::Complete(const ProtocolResult& result)
+{
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    if (m_answered_inline)
+    {
+      return;
+    }
+    if (m_holding)
+    {
+      m_completed = true;
+      m_result = result;
+      return;
+    }
+  }
+  m_callback(m_id, result);
+}
+
+void InlineCompletionGate::Release(bool answered_inline)
+{
+  ProtocolResult result;
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    m_holding = false;
+    m_answered_inline = answered_inline;
+    if (!m_completed || answered_inline)
+    {
+      return;
+    }
+    result = m_result;
+  }
+  try
+  {
+    m_callback(m_id, result);
+  }
+  catch(...)
+  {
+    // Notification is best effort: the reply is available anyway.
+  }
+}
+
+SequenceRecordingExecutor::SequenceRecordingExecutor(PriorityScheduler& scheduler,
+                                                     AsyncPriority priority)
+  : m_scheduler{scheduler}
+  , m_priority{priority}
+  , m_sequence{0}
+{}
+
+SequenceRecordingExecutor::~SequenceRecordingExecutor() = default;
+
+void SequenceRecordingExecutor::Submit(Task task)
+{
+  m_sequence = m_scheduler.Submit(std::move(task), m_priority);
+}
+
+std::size_t SequenceRecordingExecutor::GetSequence() const
+{
+  return m_sequence;
+}
+
+ProtocolRPCServerConfig CreateServerConfig(double expiration_sec,
+                                           std::shared_ptr<AsyncExecutor> executor)
+{
+  if (!executor)
+  {
+    throw InvalidOperationException("AsyncInvokeServer(): no executor provided");
+  }
+  ProtocolRPCServerConfig config{expiration_sec};
+  config.m_executor = std::move(executor);
+  return config;
+}
+
+std::shared_ptr<AsyncExecutor> GetAsyncExecutor(const ProtocolRPCServerConfig& config)
+{
+  if (config.m_executor)
+  {
+    return config.m_executor;
+  }
+  if (config.m_worker_pool_size > 0)
+  {
+    return config.m_work_stealing ? CreateWorkStealingPool(config.m_worker_pool_size)
+                                  : CreateWorkerPool(config.m_worker_pool_size);
+  }
+  return CreateThreadPerTaskExecutor();
+}
+
+std::shared_ptr<ReplySpillStore> CreateReplySpillStore(const ProtocolRPCServerConfig& config)
+{
+  if (config.m_reply_spill_threshold == 0)
+  {
+    return {};
+  }
+  return std::make_shared<ReplySpillStore>(config.m_reply_spill_threshold,
+                                           config.m_reply_spill_directory);
+}
+
+std::shared_ptr<SlabPool> CreateRequestPool(const ProtocolRPCServerConfig& config)
+{
+  if (!config.m_pooled_requests)
+  {
+    return {};
+  }
+  return std::make_shared<SlabPool>(kBlocksPerSlab);
+}
+
+bool TryIncrementBelowLimit(std::atomic<std::size_t>& counter, std::size_t limit)
+{
+  // A zero limit means unlimited
+  if (limit == 0)
+  {
+    ++counter;
+    return true;
+  }
+  auto current = counter.load();
+  while (current < limit)
+  {
+    if (counter.compare_exchange_weak(current, current + 1))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string GetRequestShape(const sup::dto::AnyValue& payload)
+{
+  // Requests without a function name share a single shape
+  if (!payload.HasField(FUNCTION_FIELD_NAME)
+      || payload[FUNCTION_FIELD_NAME].GetType() != sup::dto::StringType)
+  {
+    return {};
+  }
+  return payload[FUNCTION_FIELD_NAME].As<std::string>();
+}
+
+void RecordStageLatency(LatencyHistogram& histogram, sup::dto::uint64 begin,
+                        sup::dto::uint64 end)
+{
+  // Skip stages that were not reached, e.g. for requests that were abandoned
+  if (begin == AsyncInvoke::kStageNotReached || end == AsyncInvoke::kStageNotReached ||
+      end < begin)
+  {
+    return;
+  }
+  histogram.Record(end - begin);
+}
+}  // unnamed namespace
+
 }  // namespace protocol
 
 }  // namespace sup
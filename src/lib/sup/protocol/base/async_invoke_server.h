@@ -22,9 +22,24 @@
 #define SUP_PROTOCOL_ASYNC_INVOKE_SERVER_H_
 
 #include "async_invoke.h"
+#include "clock.h"
+#include "completion_time_estimator.h"
+#include "expiration_queue.h"
+#include "latency_histogram.h"
+#include "priority_scheduler.h"
 
+#include <sup/protocol/latency_distribution.h>
+#include <sup/protocol/protocol_rpc_server_config.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <list>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace sup
 {
@@ -33,17 +48,88 @@ namespace protocol
 /**
  * @brief This class manages multiple asynchronous calls of Protocol::Invoke for a specific protocol
  * object.
+ *
+ * @details The requests are stored in a fixed number of shards, selected by request identifier,
+ * each protected by its own mutex. Concurrent requests for different identifiers thus rarely
+ * contend for the same lock and the clean up of expired requests only locks one shard at a time.
+ * Each shard keeps its requests in a queue ordered by expiration deadline, so the cost of a clean
+ * up is proportional to the number of requests that actually expired. Invalidated and expired
+ * requests are cancelled: queued requests are dropped and running ones can stop early (see
+ * IsInvocationCancelled()). The server keeps count of such abandoned requests and of the memory
+ * held by replies that were not retrieved yet. When the latter exceeds the configured budget, the
+ * replies of the least recently accessed requests are evicted: retrieving them results in
+ * AsynchronousReplyEvicted. To this end, each shard keeps its ready replies in a list ordered by
+ * last access, so an eviction only compares the head of each list. Eviction happens while
+ * handling incoming requests and during the clean up of expired requests. Alternatively, large
+ * replies can be spilled to scratch files until they are retrieved.
+ *
+ * Optionally, the table entries and the internal state of the requests are allocated from a pool
+ * of reusable memory blocks per shard, avoiding most heap allocations per request under sustained
+ * load without making the shards contend for a shared allocator.
+ *
+ * When a request is removed, the durations of the stages in its lifecycle are added to lock-free
+ * latency histograms, which can be inspected and reset at any time.
+ *
+ * When enabled in the configuration, a poll can ask to be held until the reply is ready. The
+ * calling thread then waits on the completion signal of the request, without holding any lock.
+ * A poll can also ask to include the reply when it is ready, which retires the request without a
+ * separate request to retrieve the reply. Similarly, a new request can wait a short grace period
+ * for its reply and, when it is ready in time, answer with a normal synchronous reply instead of
+ * the request identifier. Finally, a completion callback from the configuration is called for each
+ * request as soon as its reply is ready.
+ *
+ * New requests can carry an idempotency key chosen by the client. The server keeps an index from
+ * key to request identifier, so a retried request (e.g. after its reply was lost) returns the
+ * identifier of the request that was already started instead of running the protocol again. A
+ * key is released together with its request: when the reply was retrieved or the request was
+ * abandoned.
+ *
+ * Optionally, the server keeps a moving average of the completion time of requests per called
+ * function and suggests the expected remaining time as the delay before the next poll.
  */
 class AsyncInvokeServer
 {
 public:
+  /**
+   * @brief Constructor that will launch a new thread for each asynchronous request.
+   *
+   * @param protocol Protocol to invoke.
+   * @param expiration_sec Time in seconds for an asynchronous invoke to become expired.
+   */
+  AsyncInvokeServer(Protocol& protocol, double expiration_sec);
+
   /**
    * @brief Constructor.
    *
    * @param protocol Protocol to invoke.
    * @param expiration_sec Time in seconds for an asynchronous invoke to become expired.
+   * @param executor Executor that will run the asynchronous calls to Protocol::Invoke.
+   * @throw InvalidOperationException when no executor was provided.
    */
-  explicit AsyncInvokeServer(Protocol& protocol, double expiration_sec);
+  AsyncInvokeServer(Protocol& protocol, double expiration_sec,
+                    std::shared_ptr<AsyncExecutor> executor);
+
+  /**
+   * @brief Constructor that takes its settings (expiration, executor and limits) from a server
+   * configuration.
+   *
+   * @param protocol Protocol to invoke.
+   * @param config Server configuration.
+   * @throw InvalidOperationException when spilling is enabled without a spill directory.
+   */
+  AsyncInvokeServer(Protocol& protocol, const ProtocolRPCServerConfig& config);
+
+  /**
+   * @brief Constructor that takes its settings from a server configuration and tracks expiration
+   * with the given clock instead of the one selected by the configuration.
+   *
+   * @param protocol Protocol to invoke.
+   * @param config Server configuration.
+   * @param clock Clock for expiration. It needs to outlive this object.
+   * @throw InvalidOperationException when spilling is enabled without a spill directory.
+   */
+  AsyncInvokeServer(Protocol& protocol, const ProtocolRPCServerConfig& config,
+                    const Clock& clock);
   ~AsyncInvokeServer();
 
   // No copy/move ctor/assignment:
@@ -65,7 +151,37 @@ public:
                                   AsyncCommand command);
 
   /**
-   * @brief Wait for a reply to become ready (mainly used to facilitate testing).
+   * @brief Handle the Protocol::Invoke for an asynchronous request with the given priority. The
+   * priority is only used for new requests. The payload is already assumed to be decoded.
+   *
+   * @param payload (possibly decoded) payload of the request.
+   * @param encoding Encoding to use for the reply.
+   * @param command Asynchronous command.
+   * @param priority Priority of a new request.
+   * @return Reply to be send back to the client.
+   */
+  sup::dto::AnyValue HandleInvoke(const sup::dto::AnyValue& payload, PayloadEncoding encoding,
+                                  AsyncCommand command, AsyncPriority priority);
+
+  /**
+   * @brief Handle the Protocol::Invoke for an asynchronous request with the given priority and
+   * idempotency key. Priority and key are only used for new requests. The payload is already
+   * assumed to be decoded.
+   *
+   * @param payload (possibly decoded) payload of the request.
+   * @param encoding Encoding to use for the reply.
+   * @param command Asynchronous command.
+   * @param priority Priority of a new request.
+   * @param key Idempotency key of a new request (empty for none).
+   * @return Reply to be send back to the client.
+   */
+  sup::dto::AnyValue HandleInvoke(const sup::dto::AnyValue& payload, PayloadEncoding encoding,
+                                  AsyncCommand command, AsyncPriority priority,
+                                  const std::string& key);
+
+  /**
+   * @brief Wait for a reply to become ready (mainly used to facilitate testing). The wait happens
+   * without holding any lock on the table of requests.
    *
    * @param id Identifier of the request.
    * @param seconds Timeout to wait.
@@ -78,18 +194,182 @@ public:
    */
   void CleanUpExpiredRequests();
 
+  /**
+   * @brief Get the number of asynchronous requests whose call to Protocol::Invoke has not finished
+   * yet.
+   *
+   * @return Number of active requests.
+   */
+  std::size_t GetNumberOfActiveRequests() const;
+
+  /**
+   * @brief Get the number of asynchronous requests that are currently retained by the server,
+   * i.e. still running or waiting for their reply to be retrieved.
+   *
+   * @return Number of retained requests.
+   */
+  std::size_t GetNumberOfRetainedRequests() const;
+
+  /**
+   * @brief Get the number of asynchronous requests that were abandoned, i.e. invalidated or
+   * expired before their reply was retrieved. This counter only increases.
+   *
+   * @return Number of abandoned requests.
+   */
+  std::size_t GetNumberOfAbandonedRequests() const;
+
+  /**
+   * @brief Get the approximate memory held by the replies of requests that are ready, but not
+   * retrieved yet. Replies of abandoned requests are released as soon as their task finishes.
+   *
+   * @return Approximate size in bytes of the retained replies.
+   */
+  std::size_t GetRetainedReplySize() const;
+
+  /**
+   * @brief Get the number of replies that were evicted to stay within the memory budget for
+   * retained replies. This counter only increases.
+   *
+   * @return Number of evicted replies.
+   */
+  std::size_t GetNumberOfEvictedReplies() const;
+
+  /**
+   * @brief Get the number of replies that were spilled to a scratch file. This counter only
+   * increases.
+   *
+   * @return Number of spilled replies.
+   */
+  std::size_t GetNumberOfSpilledReplies() const;
+
+  /**
+   * @brief Get the clock used for expiration.
+   *
+   * @return Clock of this server.
+   */
+  const Clock& GetClock() const;
+
+  /**
+   * @brief Get a snapshot of the latency histograms of the lifecycle stages of the requests that
+   * were removed since construction or the last reset.
+   *
+   * @return Latency statistics.
+   */
+  AsyncLatencyStatistics GetLatencyStatistics() const;
+
+  /**
+   * @brief Clear the latency histograms.
+   */
+  void ResetLatencyStatistics();
+
 private:
-  sup::dto::AnyValue NewRequest(const sup::dto::AnyValue& payload, PayloadEncoding encoding);
-  sup::dto::AnyValue Poll(sup::dto::uint64 id, PayloadEncoding encoding);
+  using RequestMap =
+    std::map<sup::dto::uint64, AsyncInvoke, std::less<sup::dto::uint64>,
+             PoolAllocator<std::pair<const sup::dto::uint64, AsyncInvoke>>>;
+  struct EvictionCandidate
+  {
+    sup::dto::uint64 m_id;
+    sup::dto::uint64 m_last_access;
+  };
+  using EvictionList = std::list<EvictionCandidate>;
+  struct RequestShard
+  {
+    // Requests whose reply became ready and that are not in the eviction list yet. These are
+    // reported by the executing tasks, which cannot take the shard's mutex. Declared first, since
+    // tasks still report while the requests are destroyed.
+    std::mutex m_ready_mtx;
+    std::vector<sup::dto::uint64> m_ready_ids;
+    std::mutex m_mtx;
+    // Shared with the requests, which may release their memory after the server is gone
+    std::shared_ptr<SlabPool> m_pool;
+    RequestMap m_invokes;
+    ExpirationQueue m_expirations;
+    // Idempotency keys of the requests in this shard that have one
+    std::map<sup::dto::uint64, std::string> m_keys;
+    // Request shapes used for the completion time estimates, when retry-after hints are enabled
+    std::map<sup::dto::uint64, std::string> m_shapes;
+    // Sequence numbers of the tasks that were queued in the priority scheduler, so the tasks of
+    // cancelled requests can be withdrawn
+    std::map<sup::dto::uint64, std::size_t> m_queued_tasks;
+    // Ready replies held in memory, from least to most recently accessed, when a memory budget
+    // for replies is configured
+    EvictionList m_eviction_list;
+    std::map<sup::dto::uint64, EvictionList::iterator> m_eviction_index;
+  };
+  static constexpr std::size_t kNumberOfShards = 16;
+  sup::dto::AnyValue NewRequest(const sup::dto::AnyValue& payload, PayloadEncoding encoding,
+                                AsyncPriority priority, const std::string& key);
+  RequestMap::iterator InsertRequest(RequestShard& shard, sup::dto::uint64 id,
+                                     const sup::dto::AnyValue& payload, AsyncPriority priority,
+                                     const std::string& key,
+                                     AsyncInvoke::FinishedCallback on_finished,
+                                     AsyncInvoke::CompletedCallback on_completed);
+  sup::dto::AnyValue CreateRetriedRequestReply(sup::dto::uint64 id, PayloadEncoding encoding);
+  sup::dto::AnyValue Poll(sup::dto::uint64 id, PayloadEncoding encoding, double wait_sec,
+                          bool inline_reply);
   sup::dto::AnyValue GetReply(sup::dto::uint64 id, PayloadEncoding encoding);
   sup::dto::AnyValue Invalidate(sup::dto::uint64 id);
   sup::dto::uint64 GetRequestId();
+  RequestShard& GetShard(sup::dto::uint64 id);
+  std::shared_ptr<CompletionHandle> GetCompletionHandle(sup::dto::uint64 id);
+  bool TryReserveRequest();
+  bool TryReserveRetainedRequest();
+  void ReleaseRequest();
+  sup::dto::uint64 FindRequestKey(const std::string& key);
+  sup::dto::uint64 RegisterRequestKey(const std::string& key, sup::dto::uint64 id);
+  void ReleaseRequestKey(RequestShard& shard, sup::dto::uint64 id);
+  void AbandonRequest(RequestShard& shard, RequestMap::iterator iter);
+  bool IsReplyBudgetExceeded() const;
+  void EnforceReplyBudget();
+  void ReportReadyReply(sup::dto::uint64 id);
+  void TrackReadyReplies(RequestShard& shard);
+  void TouchReply(RequestShard& shard, RequestMap::const_iterator iter);
+  void UntrackReply(RequestShard& shard, sup::dto::uint64 id);
+  void EvictOldestReply(RequestShard& shard);
+  void RemoveExpiredRequests(RequestShard& shard, sup::dto::uint64 now);
+  void CompactExpirationQueue(RequestShard& shard);
+  void EraseRequest(RequestShard& shard, RequestMap::iterator iter);
+  void RecordLatencies(const AsyncInvoke::Timestamps& timestamps);
+  void RecordCompletionTime(RequestShard& shard, sup::dto::uint64 id,
+                            const AsyncInvoke::Timestamps& timestamps);
+  double GetRetryAfter(const std::string& shape, sup::dto::uint64 accepted) const;
+  double GetRetryAfter(const RequestShard& shard, RequestMap::const_iterator iter) const;
 
   Protocol& m_protocol;
+  const Clock& m_clock;
   const double m_expiration_sec;
-  std::map<sup::dto::uint64, AsyncInvoke> m_invokes;
-  std::mutex m_mtx;
-  sup::dto::uint64 m_last_id;
+  const std::size_t m_max_active_requests;
+  const std::size_t m_max_retained_requests;
+  // Expired requests are removed by a background thread instead of on demand
+  const bool m_background_cleanup;
+  const double m_max_poll_wait_sec;
+  const double m_inline_grace_sec;
+  const bool m_retry_after_hints;
+  const std::size_t m_max_retained_reply_bytes;
+  const AsyncCompletionCallback m_completion_callback;
+  // Updated by the executing tasks, so these need to outlive the requests
+  std::atomic<std::size_t> m_active_requests;
+  std::atomic<std::size_t> m_retained_reply_size;
+  std::shared_ptr<ReplySpillStore> m_spill_store;
+  // The executor needs to outlive the requests, as these wait for their task to finish, and the
+  // scheduler, which waits until all its dispatch tasks ran (also those of cancelled requests)
+  std::shared_ptr<AsyncExecutor> m_executor;
+  PriorityScheduler m_scheduler;
+  std::array<RequestShard, kNumberOfShards> m_shards;
+  std::atomic<std::size_t> m_retained_requests;
+  std::atomic<std::size_t> m_abandoned_requests;
+  std::atomic<std::size_t> m_evicted_replies;
+  // Only one thread evicts replies at a time
+  std::mutex m_eviction_mtx;
+  LatencyHistogram m_queue_time;
+  LatencyHistogram m_execution_time;
+  LatencyHistogram m_poll_delay;
+  LatencyHistogram m_fetch_time;
+  CompletionTimeEstimator m_completion_times;
+  std::atomic<sup::dto::uint64> m_last_id;
+  // Locked after (never before) a shard's mutex
+  std::mutex m_key_mtx;
+  std::map<std::string, sup::dto::uint64> m_key_index;
 };
 
 /**
@@ -101,6 +381,22 @@ private:
  */
 std::pair<bool, sup::dto::uint64> ExtractAsyncRequestId(const sup::dto::AnyValue& payload);
 
+/**
+ * @brief Extract the time a poll may be held from the payload.
+ *
+ * @param payload Payload of the poll request.
+ * @return Requested wait time in seconds or zero if it was not present or invalid.
+ */
+double ExtractAsyncPollWait(const sup::dto::AnyValue& payload);
+
+/**
+ * @brief Check if a poll asks to include the reply when it is ready.
+ *
+ * @param payload Payload of the poll request.
+ * @return true if the inline reply flag is present and set.
+ */
+bool ExtractAsyncInlineReply(const sup::dto::AnyValue& payload);
+
 }  // namespace protocol
 
 }  // namespace sup
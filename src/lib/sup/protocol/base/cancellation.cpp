@@ -0,0 +1,52 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "cancellation_scope.h"
+
+#include <sup/protocol/cancellation.h>
+
+namespace sup
+{
+namespace protocol
+{
+namespace
+{
+thread_local const CompletionHandle* current_completion = nullptr;
+}  // unnamed namespace
+
+bool IsInvocationCancelled()
+{
+  return current_completion != nullptr && current_completion->IsCancelled();
+}
+
+CancellationScope::CancellationScope(const CompletionHandle& completion)
+  : m_previous{current_completion}
+{
+  current_completion = &completion;
+}
+
+CancellationScope::~CancellationScope()
+{
+  current_completion = m_previous;
+}
+
+}  // namespace protocol
+
+}  // namespace sup
@@ -0,0 +1,57 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_CANCELLATION_SCOPE_H_
+#define SUP_PROTOCOL_CANCELLATION_SCOPE_H_
+
+#include "completion_handle.h"
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief RAII class that makes the cancellation state of an asynchronous request available to
+ * IsInvocationCancelled() on the current thread, for as long as it is in scope.
+ *
+ * @note Scopes can be nested (e.g. when an executor runs tasks inline): the previous state is
+ * restored on destruction.
+ */
+class CancellationScope
+{
+public:
+  explicit CancellationScope(const CompletionHandle& completion);
+  ~CancellationScope();
+
+  // No copy/move ctor/assignment:
+  CancellationScope(const CancellationScope&) = delete;
+  CancellationScope(CancellationScope&&) = delete;
+  CancellationScope& operator=(const CancellationScope&) = delete;
+  CancellationScope& operator=(CancellationScope&&) = delete;
+
+private:
+  const CompletionHandle* m_previous;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_CANCELLATION_SCOPE_H_
@@ -0,0 +1,112 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "clock.h"
+
+#include "timing_utils.h"
+
+#include <chrono>
+
+#include <time.h>
+
+namespace
+{
+using namespace sup::protocol;
+
+class SteadyClock : public Clock
+{
+public:
+  SteadyClock() = default;
+  ~SteadyClock() override = default;
+
+  sup::dto::uint64 GetTimestamp() const override;
+};
+
+class CoarseClock : public Clock
+{
+public:
+  CoarseClock() = default;
+  ~CoarseClock() override = default;
+
+  sup::dto::uint64 GetTimestamp() const override;
+};
+}  // unnamed namespace
+
+namespace sup
+{
+namespace protocol
+{
+
+Clock::~Clock() = default;
+
+const Clock& GetSteadyClock()
+{
+  static SteadyClock clock{};
+  return clock;
+}
+
+const Clock& GetCoarseClock()
+{
+  static CoarseClock clock{};
+  return clock;
+}
+
+VirtualClock::VirtualClock()
+  : m_timestamp{0}
+{}
+
+VirtualClock::~VirtualClock() = default;
+
+sup::dto::uint64 VirtualClock::GetTimestamp() const
+{
+  return m_timestamp.load();
+}
+
+void VirtualClock::Advance(double seconds)
+{
+  m_timestamp += utils::ToNanoseconds(seconds);
+}
+
+}  // namespace protocol
+
+}  // namespace sup
+
+namespace
+{
+sup::dto::uint64 SteadyClock::GetTimestamp() const
+{
+  auto now = std::chrono::steady_clock::now();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+  return static_cast<sup::dto::uint64>(ns);
+}
+
+sup::dto::uint64 CoarseClock::GetTimestamp() const
+{
+#ifdef CLOCK_MONOTONIC_COARSE
+  struct timespec ts;
+  if (::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) == 0)
+  {
+    return static_cast<sup::dto::uint64>(ts.tv_sec) * 1000000000u +
+           static_cast<sup::dto::uint64>(ts.tv_nsec);
+  }
+#endif
+  return GetSteadyClock().GetTimestamp();
+}
+}  // unnamed namespace
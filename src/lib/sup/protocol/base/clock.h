@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_CLOCK_H_
+#define SUP_PROTOCOL_CLOCK_H_
+
+#include <sup/dto/basic_scalar_types.h>
+
+#include <atomic>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Source of monotonic timestamps for timeout handling.
+ *
+ * @details Timestamps are expressed in nanoseconds from an unspecified epoch, so they are only
+ * meaningful when compared to timestamps from the same clock.
+ *
+ * @note Implementations need to be threadsafe.
+ */
+class Clock
+{
+public:
+  virtual ~Clock();
+
+  /**
+   * @brief Get the current timestamp of this clock.
+   *
+   * @return Timestamp in nanoseconds.
+   */
+  virtual sup::dto::uint64 GetTimestamp() const = 0;
+};
+
+/**
+ * @brief Get a clock that reads the steady system clock, which does not jump when the wall clock
+ * time is adjusted.
+ *
+ * @return Steady clock with static storage duration.
+ */
+const Clock& GetSteadyClock();
+
+/**
+ * @brief Get a steady clock that returns the time of the last scheduler tick when the platform
+ * supports it (CLOCK_MONOTONIC_COARSE). This is much cheaper to read than GetSteadyClock(), at the
+ * expense of a resolution of a few milliseconds. Otherwise it behaves like GetSteadyClock().
+ *
+ * @return Coarse clock with static storage duration.
+ */
+const Clock& GetCoarseClock();
+
+/**
+ * @brief Clock that only advances when told to, for deterministic tests and benchmarks.
+ */
+class VirtualClock : public Clock
+{
+public:
+  /**
+   * @brief Constructor. The clock starts at timestamp zero.
+   */
+  VirtualClock();
+  ~VirtualClock() override;
+
+  VirtualClock(const VirtualClock& other) = delete;
+  VirtualClock& operator=(const VirtualClock& other) = delete;
+  VirtualClock(VirtualClock&&) = delete;
+  VirtualClock& operator=(VirtualClock&&) = delete;
+
+  sup::dto::uint64 GetTimestamp() const override;
+
+  /**
+   * @brief Move the clock forward.
+   *
+   * @param seconds Time in seconds to add to the current timestamp.
+   */
+  void Advance(double seconds);
+
+private:
+  std::atomic<sup::dto::uint64> m_timestamp;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_CLOCK_H_
@@ -0,0 +1,155 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "completion_handle.h"
+
+#include <chrono>
+
+namespace sup
+{
+namespace protocol
+{
+
+CompletionHandle::CompletionHandle()
+  : m_mtx{}
+  , m_cv{}
+  , m_ready{false}
+  , m_task_state{TaskState::kQueued}
+  , m_cancelled{false}
+  , m_reply_size{0}
+  , m_reply{ Success, {} }
+  , m_spilled_payload{}
+{}
+
+CompletionHandle::~CompletionHandle() = default;
+
+void CompletionHandle::SetReply(Reply reply, std::size_t reply_size)
+{
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    if (m_ready.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+    m_reply = std::move(reply);
+    m_reply_size.store(reply_size, std::memory_order_relaxed);
+    m_ready.store(true, std::memory_order_release);
+  }
+  m_cv.notify_all();
+}
+
+void CompletionHandle::SetReply(const ProtocolResult& result,
+                                std::unique_ptr<SpilledValue> payload)
+{
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    if (m_ready.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+    m_reply = Reply{ result, {} };
+    m_spilled_payload = std::move(payload);
+    m_reply_size.store(0, std::memory_order_relaxed);
+    m_ready.store(true, std::memory_order_release);
+  }
+  m_cv.notify_all();
+}
+
+bool CompletionHandle::IsReady() const
+{
+  return m_ready.load(std::memory_order_acquire);
+}
+
+bool CompletionHandle::WaitForReady(double seconds) const
+{
+  if (IsReady())
+  {
+    return true;
+  }
+  auto duration = std::chrono::duration<double>(seconds);
+  std::unique_lock<std::mutex> lk{m_mtx};
+  return m_cv.wait_for(lk, duration, [this](){ return IsReady(); });
+}
+
+void CompletionHandle::Wait() const
+{
+  if (IsReady())
+  {
+    return;
+  }
+  std::unique_lock<std::mutex> lk{m_mtx};
+  m_cv.wait(lk, [this](){ return IsReady(); });
+}
+
+CompletionHandle::Reply CompletionHandle::TakeReply()
+{
+  Reply reply{ Success, {} };
+  std::unique_ptr<SpilledValue> spilled_payload;
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    reply = std::move(m_reply);
+    spilled_payload = std::move(m_spilled_payload);
+  }
+  // Loading can take a while for large payloads, so it is done without blocking waiters
+  if (spilled_payload)
+  {
+    reply.second = spilled_payload->Load();
+  }
+  return reply;
+}
+
+std::size_t CompletionHandle::ReplaceReply(Reply reply)
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  if (!m_ready.load(std::memory_order_relaxed))
+  {
+    return 0;
+  }
+  m_reply = std::move(reply);
+  m_spilled_payload.reset();
+  return m_reply_size.exchange(0, std::memory_order_relaxed);
+}
+
+std::size_t CompletionHandle::GetReplySize() const
+{
+  return IsReady() ? m_reply_size.load(std::memory_order_relaxed) : 0;
+}
+
+bool CompletionHandle::TryStart()
+{
+  auto expected = TaskState::kQueued;
+  return m_task_state.compare_exchange_strong(expected, TaskState::kStarted);
+}
+
+bool CompletionHandle::Cancel()
+{
+  m_cancelled.store(true, std::memory_order_release);
+  auto expected = TaskState::kQueued;
+  return m_task_state.compare_exchange_strong(expected, TaskState::kDropped);
+}
+
+bool CompletionHandle::IsCancelled() const
+{
+  return m_cancelled.load(std::memory_order_acquire);
+}
+
+}  // namespace protocol
+
+}  // namespace sup
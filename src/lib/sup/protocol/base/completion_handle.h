@@ -0,0 +1,176 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_COMPLETION_HANDLE_H_
+#define SUP_PROTOCOL_COMPLETION_HANDLE_H_
+
+#include "reply_spill_store.h"
+
+#include <sup/protocol/protocol_result.h>
+
+#include <sup/dto/anyvalue.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Shared state between an asynchronous task that calls Protocol::Invoke and the owner of
+ * its reply. It replaces the use of std::future, so that the task can be run by any AsyncExecutor.
+ *
+ * @details The handle is shared (through std::shared_ptr) between the task, the AsyncInvoke that
+ * owns the reply and any thread that waits for completion. Waiters can thus keep the handle alive
+ * and wait on it without holding any lock on the table of requests.
+ *
+ * The handle also carries the cancellation state of the task: the owner can cancel the task at
+ * any time. A task that did not start yet will then never start, while a running task can check
+ * IsCancelled() (see IsInvocationCancelled()) to stop early.
+ *
+ * @note This class is threadsafe. The reply can only be set once.
+ */
+class CompletionHandle
+{
+public:
+  using Reply = std::pair<ProtocolResult, sup::dto::AnyValue>;
+
+  CompletionHandle();
+  ~CompletionHandle();
+
+  // No copy/move ctor/assignment:
+  CompletionHandle(const CompletionHandle&) = delete;
+  CompletionHandle(CompletionHandle&&) = delete;
+  CompletionHandle& operator=(const CompletionHandle&) = delete;
+  CompletionHandle& operator=(CompletionHandle&&) = delete;
+
+  /**
+   * @brief Store the reply and wake up all waiting threads.
+   *
+   * @param reply Reply of the asynchronous task.
+   * @param reply_size Approximate memory held by the reply, for accounting by the owner.
+   */
+  void SetReply(Reply reply, std::size_t reply_size);
+
+  /**
+   * @brief Store a reply whose payload was spilled out of memory and wake up all waiting threads.
+   * The payload is only loaded again by TakeReply. Since it is not held in memory, the reply is
+   * accounted as holding no memory.
+   *
+   * @param result Result of the asynchronous task.
+   * @param payload Spilled payload of the asynchronous task.
+   */
+  void SetReply(const ProtocolResult& result, std::unique_ptr<SpilledValue> payload);
+
+  /**
+   * @brief Check if the reply was set. This only reads an atomic flag and never blocks.
+   *
+   * @return true if the reply was set.
+   */
+  bool IsReady() const;
+
+  /**
+   * @brief Wait for the reply to be set within the given timeout.
+   *
+   * @param seconds Timeout in seconds.
+   * @return true if the reply was set.
+   */
+  bool WaitForReady(double seconds) const;
+
+  /**
+   * @brief Wait without timeout for the reply to be set.
+   */
+  void Wait() const;
+
+  /**
+   * @brief Move the reply out of this object. Only meaningful when IsReady() returns true. A
+   * spilled payload is loaded back into memory and its scratch file released.
+   *
+   * @return Reply of the asynchronous task.
+   */
+  Reply TakeReply();
+
+  /**
+   * @brief Replace a reply that was already set, e.g. to release the memory it holds. This does
+   * nothing when the reply was not set yet.
+   *
+   * @param reply Replacement reply, which is accounted as holding no memory.
+   * @return Approximate size of the replaced reply in bytes.
+   */
+  std::size_t ReplaceReply(Reply reply);
+
+  /**
+   * @brief Get the approximate memory held by the reply, as passed to SetReply. This does not
+   * change when the reply is taken, so owners can release exactly what they accounted for. It is
+   * reset by ReplaceReply.
+   *
+   * @return Approximate reply size in bytes or zero if the reply was not set yet.
+   */
+  std::size_t GetReplySize() const;
+
+  /**
+   * @brief Mark the task as started. Called by the task before doing any work.
+   *
+   * @return true if the task can run; false if it was cancelled before it started.
+   */
+  bool TryStart();
+
+  /**
+   * @brief Cancel the task. A task that did not start yet will never start. In that case, the
+   * caller takes over the responsibility to set the reply.
+   *
+   * @return true if the task had not started yet.
+   */
+  bool Cancel();
+
+  /**
+   * @brief Check if the task was cancelled. This only reads an atomic flag and never blocks.
+   *
+   * @return true if the task was cancelled.
+   */
+  bool IsCancelled() const;
+
+private:
+  enum class TaskState
+  {
+    kQueued = 0,
+    kStarted,
+    kDropped
+  };
+  mutable std::mutex m_mtx;
+  mutable std::condition_variable m_cv;
+  std::atomic<bool> m_ready;
+  std::atomic<TaskState> m_task_state;
+  std::atomic<bool> m_cancelled;
+  std::atomic<std::size_t> m_reply_size;
+  Reply m_reply;
+  std::unique_ptr<SpilledValue> m_spilled_payload;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_COMPLETION_HANDLE_H_
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "completion_time_estimator.h"
+
+#include <sup/protocol/exceptions.h>
+
+namespace sup
+{
+namespace protocol
+{
+
+CompletionTimeEstimator::CompletionTimeEstimator(double smoothing, std::size_t max_shapes)
+  : m_smoothing{smoothing}
+  , m_max_shapes{max_shapes}
+  , m_mtx{}
+  , m_estimates{}
+{
+  if (smoothing <= 0.0 || smoothing > 1.0)
+  {
+    throw InvalidOperationException(
+      "CompletionTimeEstimator(): smoothing factor must be in the interval (0, 1]");
+  }
+}
+
+CompletionTimeEstimator::~CompletionTimeEstimator() = default;
+
+void CompletionTimeEstimator::Record(const std::string& shape, sup::dto::uint64 duration_ns)
+{
+  const auto duration_sec = static_cast<double>(duration_ns) * 1e-9;
+  std::lock_guard<std::mutex> lk{m_mtx};
+  auto iter = m_estimates.find(shape);
+  if (iter == m_estimates.end())
+  {
+    if (m_estimates.size() < m_max_shapes)
+    {
+      (void)m_estimates.emplace(shape, duration_sec);
+    }
+    return;
+  }
+  iter->second += m_smoothing * (duration_sec - iter->second);
+}
+
+double CompletionTimeEstimator::GetEstimate(const std::string& shape) const
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  auto iter = m_estimates.find(shape);
+  return iter == m_estimates.end() ? 0.0 : iter->second;
+}
+
+std::size_t CompletionTimeEstimator::GetNumberOfShapes() const
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  return m_estimates.size();
+}
+
+}  // namespace protocol
+
+}  // namespace sup
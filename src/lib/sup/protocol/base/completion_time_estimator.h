@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_COMPLETION_TIME_ESTIMATOR_H_
+#define SUP_PROTOCOL_COMPLETION_TIME_ESTIMATOR_H_
+
+#include <sup/dto/basic_scalar_types.h>
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Exponentially weighted moving average of the completion time of requests, tracked
+ * separately for each request shape (e.g. the name of the called function).
+ *
+ * @details Each new completion time moves the estimate of its shape by the given smoothing factor
+ * towards that time. The first completion time of a shape becomes its initial estimate. To bound
+ * the memory used, completion times of new shapes are ignored once the maximum number of shapes
+ * is tracked.
+ */
+class CompletionTimeEstimator
+{
+public:
+  /**
+   * @brief Constructor.
+   *
+   * @param smoothing Weight of a new completion time, between zero (exclusive) and one.
+   * @param max_shapes Maximum number of tracked request shapes.
+   *
+   * @throws InvalidOperationException when the smoothing factor is out of range.
+   */
+  CompletionTimeEstimator(double smoothing, std::size_t max_shapes);
+  ~CompletionTimeEstimator();
+
+  CompletionTimeEstimator(const CompletionTimeEstimator& other) = delete;
+  CompletionTimeEstimator& operator=(const CompletionTimeEstimator& other) = delete;
+  CompletionTimeEstimator(CompletionTimeEstimator&&) = delete;
+  CompletionTimeEstimator& operator=(CompletionTimeEstimator&&) = delete;
+
+  /**
+   * @brief Update the estimate of a request shape with a new completion time.
+   *
+   * @param shape Request shape.
+   * @param duration_ns Completion time in nanoseconds.
+   */
+  void Record(const std::string& shape, sup::dto::uint64 duration_ns);
+
+  /**
+   * @brief Get the estimated completion time of a request shape.
+   *
+   * @param shape Request shape.
+   * @return Estimated completion time in seconds (zero when the shape is not tracked).
+   */
+  double GetEstimate(const std::string& shape) const;
+
+  /**
+   * @brief Get the number of tracked request shapes.
+   */
+  std::size_t GetNumberOfShapes() const;
+
+private:
+  const double m_smoothing;
+  const std::size_t m_max_shapes;
+  mutable std::mutex m_mtx;
+  std::map<std::string, double> m_estimates;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_COMPLETION_TIME_ESTIMATOR_H_
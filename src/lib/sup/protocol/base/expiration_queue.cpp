@@ -0,0 +1,71 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "expiration_queue.h"
+
+#include <algorithm>
+
+namespace sup
+{
+namespace protocol
+{
+
+ExpirationQueue::ExpirationQueue()
+  : m_heap{}
+{}
+
+ExpirationQueue::~ExpirationQueue() = default;
+
+void ExpirationQueue::Push(sup::dto::uint64 id, sup::dto::uint64 deadline)
+{
+  m_heap.push_back({ deadline, id });
+  std::push_heap(m_heap.begin(), m_heap.end(), &ExpirationQueue::IsLater);
+}
+
+std::vector<sup::dto::uint64> ExpirationQueue::PopExpired(sup::dto::uint64 now)
+{
+  std::vector<sup::dto::uint64> result;
+  while (!m_heap.empty() && m_heap.front().m_deadline <= now)
+  {
+    result.push_back(m_heap.front().m_id);
+    std::pop_heap(m_heap.begin(), m_heap.end(), &ExpirationQueue::IsLater);
+    m_heap.pop_back();
+  }
+  return result;
+}
+
+std::size_t ExpirationQueue::GetSize() const
+{
+  return m_heap.size();
+}
+
+void ExpirationQueue::Clear()
+{
+  m_heap.clear();
+}
+
+bool ExpirationQueue::IsLater(const Entry& left, const Entry& right)
+{
+  return left.m_deadline > right.m_deadline;
+}
+
+}  // namespace protocol
+
+}  // namespace sup
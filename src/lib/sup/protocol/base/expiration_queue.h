@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_EXPIRATION_QUEUE_H_
+#define SUP_PROTOCOL_EXPIRATION_QUEUE_H_
+
+#include <sup/dto/basic_scalar_types.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Min-heap of request identifiers, ordered by their expiration deadline.
+ *
+ * @details The queue allows finding the requests that may have expired without inspecting all
+ * requests. Entries are not updated when a request is accessed or removed: clients need to check
+ * the actual state of the popped identifiers and push them again with a new deadline if needed.
+ *
+ * @note This class is not threadsafe.
+ */
+class ExpirationQueue
+{
+public:
+  ExpirationQueue();
+  ~ExpirationQueue();
+
+  ExpirationQueue(const ExpirationQueue& other) = delete;
+  ExpirationQueue& operator=(const ExpirationQueue& other) = delete;
+  ExpirationQueue(ExpirationQueue&&) = delete;
+  ExpirationQueue& operator=(ExpirationQueue&&) = delete;
+
+  /**
+   * @brief Add a request identifier with its deadline.
+   *
+   * @param id Request identifier.
+   * @param deadline Timestamp in nanoseconds after which the request needs to be checked.
+   */
+  void Push(sup::dto::uint64 id, sup::dto::uint64 deadline);
+
+  /**
+   * @brief Remove all entries whose deadline has passed.
+   *
+   * @param now Current timestamp in nanoseconds.
+   * @return Identifiers of the removed entries, in order of their deadline.
+   */
+  std::vector<sup::dto::uint64> PopExpired(sup::dto::uint64 now);
+
+  /**
+   * @brief Get the number of entries, including those of requests that no longer exist.
+   *
+   * @return Number of entries.
+   */
+  std::size_t GetSize() const;
+
+  /**
+   * @brief Remove all entries.
+   */
+  void Clear();
+
+private:
+  struct Entry
+  {
+    sup::dto::uint64 m_deadline;
+    sup::dto::uint64 m_id;
+  };
+  static bool IsLater(const Entry& left, const Entry& right);
+  std::vector<Entry> m_heap;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_EXPIRATION_QUEUE_H_
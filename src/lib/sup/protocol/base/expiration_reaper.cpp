@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "expiration_reaper.h"
+
+#include <sup/protocol/exceptions.h>
+
+#include <utility>
+
+namespace sup
+{
+namespace protocol
+{
+
+ExpirationReaper::ExpirationReaper(CleanUpFunction cleanup, double interval_sec)
+  : m_cleanup{std::move(cleanup)}
+  , m_interval{interval_sec}
+  , m_halt{false}
+  , m_mtx{}
+  , m_cv{}
+  , m_thread{}
+{
+  if (!(interval_sec > 0.0))
+  {
+    throw InvalidOperationException(
+      "ExpirationReaper(): clean up interval must be larger than zero");
+  }
+  m_thread = std::thread{&ExpirationReaper::Run, this};
+}
+
+ExpirationReaper::~ExpirationReaper()
+{
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    m_halt = true;
+  }
+  m_cv.notify_one();
+  m_thread.join();
+}
+
+void ExpirationReaper::Run()
+{
+  std::unique_lock<std::mutex> lk{m_mtx};
+  while (!m_cv.wait_for(lk, m_interval, [this](){ return m_halt; }))
+  {
+    lk.unlock();
+    try
+    {
+      m_cleanup();
+    }
+    catch(...)
+    {
+      // Ignore to keep the reaper alive.
+    }
+    lk.lock();
+  }
+}
+
+}  // namespace protocol
+
+}  // namespace sup
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_EXPIRATION_REAPER_H_
+#define SUP_PROTOCOL_EXPIRATION_REAPER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief This class runs a clean up function periodically on a dedicated background thread. It
+ * allows a server to remove expired requests without burdening the threads that handle requests.
+ */
+class ExpirationReaper
+{
+public:
+  using CleanUpFunction = std::function<void()>;
+
+  /**
+   * @brief Constructor that immediately launches the background thread.
+   *
+   * @param cleanup Function to call periodically.
+   * @param interval_sec Time in seconds between consecutive calls of the clean up function.
+   * @throw InvalidOperationException when the interval is not strictly positive.
+   */
+  ExpirationReaper(CleanUpFunction cleanup, double interval_sec);
+
+  /**
+   * @brief Destructor. Stops and joins the background thread.
+   */
+  ~ExpirationReaper();
+
+  ExpirationReaper(const ExpirationReaper& other) = delete;
+  ExpirationReaper& operator=(const ExpirationReaper& other) = delete;
+  ExpirationReaper(ExpirationReaper&&) = delete;
+  ExpirationReaper& operator=(ExpirationReaper&&) = delete;
+
+private:
+  void Run();
+  CleanUpFunction m_cleanup;
+  std::chrono::duration<double> m_interval;
+  bool m_halt;
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::thread m_thread;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_EXPIRATION_REAPER_H_
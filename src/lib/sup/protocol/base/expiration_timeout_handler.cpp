@@ -21,29 +21,42 @@
 #include "expiration_timeout_handler.h"
 #include "timing_utils.h"
 
+#include <limits>
+
+namespace
+{
+// Marks that no clean up was done yet, since steady clocks can start at any value
+const sup::dto::uint64 kNoCleanUpYet = std::numeric_limits<sup::dto::uint64>::max();
+}  // unnamed namespace
+
 namespace sup
 {
 namespace protocol
 {
 ExpirationTimeoutHandler::ExpirationTimeoutHandler(double cleanup_sec)
-  : m_last_timestamp{0}
+  : ExpirationTimeoutHandler{cleanup_sec, GetSteadyClock()}
+{}
+
+ExpirationTimeoutHandler::ExpirationTimeoutHandler(double cleanup_sec, const Clock& clock)
+  : m_clock{clock}
+  , m_last_timestamp{kNoCleanUpYet}
   , m_cleanup_ns{utils::ToNanoseconds(cleanup_sec)}
-  , m_mtx{}
 {}
 
 ExpirationTimeoutHandler::~ExpirationTimeoutHandler() = default;
 
 bool ExpirationTimeoutHandler::IsCleanUpNeeded()
 {
-  std::lock_guard<std::mutex> lk{m_mtx};
-  auto now = utils::GetCurrentTimestamp();
-  auto passed_ns = now - m_last_timestamp;
-  if (passed_ns > m_cleanup_ns)
+  auto now = m_clock.GetTimestamp();
+  auto last_timestamp = m_last_timestamp.load();
+  // Another thread may have registered a later clean up in the meantime
+  if (last_timestamp != kNoCleanUpYet &&
+      (now < last_timestamp || now - last_timestamp <= m_cleanup_ns))
   {
-    m_last_timestamp = now;
-    return true;
+    return false;
   }
-  return false;
+  // Only the thread that succeeds in updating the timestamp needs to clean up
+  return m_last_timestamp.compare_exchange_strong(last_timestamp, now);
 }
 
 }  // namespace protocol
@@ -21,9 +21,11 @@
 #ifndef SUP_PROTOCOL_EXPIRATION_TIMEOUT_HANDLER_H_
 #define SUP_PROTOCOL_EXPIRATION_TIMEOUT_HANDLER_H_
 
+#include "clock.h"
+
 #include <sup/dto/basic_scalar_types.h>
 
-#include <mutex>
+#include <atomic>
 
 namespace sup
 {
@@ -32,6 +34,9 @@ namespace protocol
 /**
  * @brief This class manages the expiration timeouts for a server. It can be used to not try to
  * cleanup resources on each and every request, but only when a certain time has expired.
+ *
+ * @note This class is lock-free: when multiple threads query it concurrently, only one of them
+ * will be told to clean up.
  */
 class ExpirationTimeoutHandler
 {
@@ -43,6 +48,15 @@ public:
    * @param cleanup_sec Minimum time to wait between consecutive cleanup operations in the server.
    */
   explicit ExpirationTimeoutHandler(double cleanup_sec);
+
+  /**
+   * @brief Constructor.
+   *
+   * @param cleanup_sec Minimum time to wait between consecutive cleanup operations in the server.
+   * @param clock Clock to measure the time between cleanup operations. It needs to outlive this
+   * object.
+   */
+  ExpirationTimeoutHandler(double cleanup_sec, const Clock& clock);
   ~ExpirationTimeoutHandler();
 
   ExpirationTimeoutHandler(const ExpirationTimeoutHandler& other) = delete;
@@ -60,9 +74,9 @@ public:
   bool IsCleanUpNeeded();
 
 private:
-  sup::dto::uint64 m_last_timestamp;
+  const Clock& m_clock;
+  std::atomic<sup::dto::uint64> m_last_timestamp;
   sup::dto::uint64 m_cleanup_ns;
-  std::mutex m_mtx;
 };
 
 }  // namespace protocol
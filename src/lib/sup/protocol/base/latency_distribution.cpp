@@ -0,0 +1,128 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/latency_distribution.h>
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+double ToSeconds(sup::dto::uint64 ns);
+}  // unnamed namespace
+
+namespace sup
+{
+namespace protocol
+{
+
+LatencyDistribution::LatencyDistribution()
+  : m_bucket_counts{}
+  , m_count{0}
+  , m_total_ns{0}
+  , m_min_ns{0}
+  , m_max_ns{0}
+{}
+
+LatencyDistribution::LatencyDistribution(std::vector<sup::dto::uint64> bucket_counts,
+                                         sup::dto::uint64 total_ns, sup::dto::uint64 min_ns,
+                                         sup::dto::uint64 max_ns)
+  : m_bucket_counts{std::move(bucket_counts)}
+  , m_count{std::accumulate(m_bucket_counts.begin(), m_bucket_counts.end(), sup::dto::uint64{0})}
+  , m_total_ns{total_ns}
+  , m_min_ns{min_ns}
+  , m_max_ns{max_ns}
+{}
+
+LatencyDistribution::~LatencyDistribution() = default;
+
+LatencyDistribution::LatencyDistribution(const LatencyDistribution&) = default;
+
+LatencyDistribution& LatencyDistribution::operator=(const LatencyDistribution&) & = default;
+
+LatencyDistribution::LatencyDistribution(LatencyDistribution&&) noexcept = default;
+
+LatencyDistribution& LatencyDistribution::operator=(LatencyDistribution&&) & noexcept = default;
+
+sup::dto::uint64 LatencyDistribution::GetCount() const
+{
+  return m_count;
+}
+
+double LatencyDistribution::GetMean() const
+{
+  if (m_count == 0)
+  {
+    return 0.0;
+  }
+  return ToSeconds(m_total_ns) / static_cast<double>(m_count);
+}
+
+double LatencyDistribution::GetMinimum() const
+{
+  return ToSeconds(m_min_ns);
+}
+
+double LatencyDistribution::GetMaximum() const
+{
+  return ToSeconds(m_max_ns);
+}
+
+double LatencyDistribution::GetPercentile(double fraction) const
+{
+  if (m_count == 0)
+  {
+    return 0.0;
+  }
+  if (fraction <= 0.0)
+  {
+    return GetMinimum();
+  }
+  fraction = std::min(fraction, 1.0);
+  auto rank = static_cast<sup::dto::uint64>(std::ceil(fraction * static_cast<double>(m_count)));
+  sup::dto::uint64 cumulative = 0;
+  for (std::size_t idx = 0; idx < m_bucket_counts.size(); ++idx)
+  {
+    cumulative += m_bucket_counts[idx];
+    if (cumulative >= rank)
+    {
+      // The bucket bound can exceed the recorded values
+      auto bound = std::min(GetLatencyBucketUpperBound(idx), m_max_ns);
+      return ToSeconds(std::max(bound, m_min_ns));
+    }
+  }
+  return ToSeconds(m_max_ns);
+}
+
+}  // namespace protocol
+
+}  // namespace sup
+
+namespace
+{
+double ToSeconds(sup::dto::uint64 ns)
+{
+  return static_cast<double>(ns) * 1e-9;
+}
+}  // unnamed namespace
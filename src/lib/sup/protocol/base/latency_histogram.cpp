@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "latency_histogram.h"
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+const sup::dto::uint64 kSubBucketCount =
+  sup::dto::uint64{1} << sup::protocol::kLatencySubBucketBits;
+
+const sup::dto::uint64 kNoMinimum = std::numeric_limits<sup::dto::uint64>::max();
+
+std::size_t GetMostSignificantBit(sup::dto::uint64 value);
+}  // unnamed namespace
+
+namespace sup
+{
+namespace protocol
+{
+
+std::size_t GetLatencyBucketIndex(sup::dto::uint64 latency_ns)
+{
+  // Small latencies each have their own bucket
+  if (latency_ns < kSubBucketCount)
+  {
+    return static_cast<std::size_t>(latency_ns);
+  }
+  const auto shift = GetMostSignificantBit(latency_ns) - kLatencySubBucketBits;
+  const auto sub_bucket = static_cast<std::size_t>(latency_ns >> shift) - kSubBucketCount;
+  return ((shift + 1) << kLatencySubBucketBits) + sub_bucket;
+}
+
+sup::dto::uint64 GetLatencyBucketUpperBound(std::size_t index)
+{
+  if (index < kSubBucketCount)
+  {
+    return index;
+  }
+  const auto shift = (index >> kLatencySubBucketBits) - 1;
+  const auto sub_bucket = index & (kSubBucketCount - 1);
+  const auto lower_bound = (kSubBucketCount + sub_bucket) << shift;
+  return lower_bound + ((sup::dto::uint64{1} << shift) - 1);
+}
+
+LatencyHistogram::LatencyHistogram()
+  : m_buckets{}
+  , m_total_ns{0}
+  , m_min_ns{kNoMinimum}
+  , m_max_ns{0}
+{
+  for (auto& bucket : m_buckets)
+  {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+LatencyHistogram::~LatencyHistogram() = default;
+
+void LatencyHistogram::Record(sup::dto::uint64 latency_ns)
+{
+  m_buckets[GetLatencyBucketIndex(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+  m_total_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+  auto current_min = m_min_ns.load(std::memory_order_relaxed);
+  while (latency_ns < current_min &&
+         !m_min_ns.compare_exchange_weak(current_min, latency_ns, std::memory_order_relaxed))
+  {}
+  auto current_max = m_max_ns.load(std::memory_order_relaxed);
+  while (latency_ns > current_max &&
+         !m_max_ns.compare_exchange_weak(current_max, latency_ns, std::memory_order_relaxed))
+  {}
+}
+
+LatencyDistribution LatencyHistogram::GetSnapshot() const
+{
+  std::vector<sup::dto::uint64> bucket_counts;
+  bucket_counts.reserve(kNumberOfLatencyBuckets);
+  for (const auto& bucket : m_buckets)
+  {
+    bucket_counts.push_back(bucket.load(std::memory_order_relaxed));
+  }
+  auto min_ns = m_min_ns.load(std::memory_order_relaxed);
+  return LatencyDistribution{std::move(bucket_counts), m_total_ns.load(std::memory_order_relaxed),
+                             min_ns == kNoMinimum ? 0 : min_ns,
+                             m_max_ns.load(std::memory_order_relaxed)};
+}
+
+void LatencyHistogram::Reset()
+{
+  for (auto& bucket : m_buckets)
+  {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  m_total_ns.store(0, std::memory_order_relaxed);
+  m_min_ns.store(kNoMinimum, std::memory_order_relaxed);
+  m_max_ns.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace protocol
+
+}  // namespace sup
+
+namespace
+{
+std::size_t GetMostSignificantBit(sup::dto::uint64 value)
+{
+  std::size_t result = 0;
+  while (value >>= 1)
+  {
+    ++result;
+  }
+  return result;
+}
+}  // unnamed namespace
@@ -0,0 +1,110 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_LATENCY_HISTOGRAM_H_
+#define SUP_PROTOCOL_LATENCY_HISTOGRAM_H_
+
+#include <sup/protocol/latency_distribution.h>
+
+#include <sup/dto/basic_scalar_types.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Number of linear sub-buckets in each power of two is 2^kLatencySubBucketBits.
+ */
+const std::size_t kLatencySubBucketBits = 4;
+
+/**
+ * @brief Number of buckets needed to cover all 64 bit latencies in nanoseconds.
+ */
+const std::size_t kNumberOfLatencyBuckets = (64 - kLatencySubBucketBits + 1)
+                                            << kLatencySubBucketBits;
+
+/**
+ * @brief Get the index of the bucket that contains the given latency.
+ *
+ * @param latency_ns Latency in nanoseconds.
+ * @return Bucket index.
+ */
+std::size_t GetLatencyBucketIndex(sup::dto::uint64 latency_ns);
+
+/**
+ * @brief Get the largest latency that falls in the given bucket.
+ *
+ * @param index Bucket index.
+ * @return Latency in nanoseconds.
+ */
+sup::dto::uint64 GetLatencyBucketUpperBound(std::size_t index);
+
+/**
+ * @brief Histogram of latencies that can be updated concurrently without locking.
+ *
+ * @note Taking a snapshot or resetting while latencies are recorded is safe, but the result may
+ * only partially contain the concurrently recorded latencies.
+ */
+class LatencyHistogram
+{
+public:
+  LatencyHistogram();
+  ~LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram& other) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram& other) = delete;
+  LatencyHistogram(LatencyHistogram&&) = delete;
+  LatencyHistogram& operator=(LatencyHistogram&&) = delete;
+
+  /**
+   * @brief Add a latency to the histogram.
+   *
+   * @param latency_ns Latency in nanoseconds.
+   */
+  void Record(sup::dto::uint64 latency_ns);
+
+  /**
+   * @brief Get a copy of the current state of the histogram.
+   *
+   * @return Latency distribution.
+   */
+  LatencyDistribution GetSnapshot() const;
+
+  /**
+   * @brief Remove all recorded latencies.
+   */
+  void Reset();
+
+private:
+  std::array<std::atomic<sup::dto::uint64>, kNumberOfLatencyBuckets> m_buckets;
+  std::atomic<sup::dto::uint64> m_total_ns;
+  std::atomic<sup::dto::uint64> m_min_ns;
+  std::atomic<sup::dto::uint64> m_max_ns;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_LATENCY_HISTOGRAM_H_
@@ -30,7 +30,13 @@ namespace sup
 namespace protocol
 {
 PollingTimeoutHandler::PollingTimeoutHandler(double timeout_sec, double polling_interval_sec)
-  : m_start_timestamp{utils::GetCurrentTimestamp()}
+  : PollingTimeoutHandler{timeout_sec, polling_interval_sec, GetSteadyClock()}
+{}
+
+PollingTimeoutHandler::PollingTimeoutHandler(double timeout_sec, double polling_interval_sec,
+                                             const Clock& clock)
+  : m_clock{&clock}
+  , m_start_timestamp{clock.GetTimestamp()}
   , m_timeout_duration_ns{utils::ToNanoseconds(timeout_sec)}
   , m_polling_interval_ns{utils::ToNanoseconds(polling_interval_sec)}
 {}
@@ -49,14 +55,34 @@ PollingTimeoutHandler& PollingTimeoutHandler::operator=(
 
 bool PollingTimeoutHandler::Wait()
 {
-  auto now = utils::GetCurrentTimestamp();
+  return WaitFor(m_polling_interval_ns);
+}
+
+bool PollingTimeoutHandler::Wait(double interval_sec)
+{
+  return WaitFor(utils::ToNanoseconds(interval_sec));
+}
+
+double PollingTimeoutHandler::GetRemainingTime() const
+{
+  auto passed_ns = m_clock->GetTimestamp() - m_start_timestamp;
+  if (passed_ns >= m_timeout_duration_ns)
+  {
+    return 0.0;
+  }
+  return static_cast<double>(m_timeout_duration_ns - passed_ns) * 1e-9;
+}
+
+bool PollingTimeoutHandler::WaitFor(sup::dto::uint64 interval_ns)
+{
+  auto now = m_clock->GetTimestamp();
   auto passed_ns = now - m_start_timestamp;
   if (passed_ns > m_timeout_duration_ns)
   {
     return false;
   }
   // Do not sleep so long as to pass the timeout threshold:
-  auto sleep_time = std::min(m_polling_interval_ns, m_timeout_duration_ns - passed_ns);
+  auto sleep_time = std::min(interval_ns, m_timeout_duration_ns - passed_ns);
   std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_time));
   return true;
 }
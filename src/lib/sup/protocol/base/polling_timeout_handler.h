@@ -21,6 +21,8 @@
 #ifndef SUP_PROTOCOL_POLLING_TIMEOUT_HANDLER_H_
 #define SUP_PROTOCOL_POLLING_TIMEOUT_HANDLER_H_
 
+#include "clock.h"
+
 #include <sup/dto/basic_scalar_types.h>
 
 namespace sup
@@ -43,6 +45,17 @@ public:
    * @param polling_interval_sec Time to wait between polls to check if the reply is ready
    */
   PollingTimeoutHandler(double timeout_sec, double polling_interval_sec);
+
+  /**
+   * @brief Constructor. During construction, the current time of the given clock will be
+   * registered to allow the object to know when the timeout was exceeded.
+   *
+   * @param timeout_sec Maximum time to wait for the reply to become ready (in seconds).
+   * @param polling_interval_sec Time to wait between polls to check if the reply is ready
+   * @param clock Clock to measure the timeout. It needs to outlive this object. The waits between
+   * polls always take real time.
+   */
+  PollingTimeoutHandler(double timeout_sec, double polling_interval_sec, const Clock& clock);
   ~PollingTimeoutHandler();
 
   PollingTimeoutHandler(const PollingTimeoutHandler& other);
@@ -57,7 +70,26 @@ public:
    */
   bool Wait();
 
+  /**
+   * @brief Wait for the given interval instead of the configured polling interval, e.g. when the
+   * server suggested when to poll next.
+   *
+   * @param interval_sec Time to wait in seconds (limited by the remaining time).
+   * @return true if the timeout was not exceeded yet.
+   */
+  bool Wait(double interval_sec);
+
+  /**
+   * @brief Get the time left before the timeout is exceeded.
+   *
+   * @return Remaining time in seconds (zero when the timeout was exceeded).
+   */
+  double GetRemainingTime() const;
+
 private:
+  bool WaitFor(sup::dto::uint64 interval_ns);
+
+  const Clock* m_clock;
   sup::dto::uint64 m_start_timestamp;
   sup::dto::uint64 m_timeout_duration_ns;
   sup::dto::uint64 m_polling_interval_ns;
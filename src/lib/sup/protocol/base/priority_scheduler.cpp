@@ -0,0 +1,256 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "priority_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace sup
+{
+namespace protocol
+{
+namespace
+{
+std::size_t PriorityToIndex(AsyncPriority priority);
+}  // unnamed namespace
+
+PriorityScheduler::PriorityScheduler(AsyncExecutor& executor, std::size_t max_skips)
+  : m_executor{executor}
+  , m_max_skips{max_skips}
+  , m_queues{}
+  , m_n_urgent_tasks{0}
+  , m_skipped{}
+  , m_priority_executors{{ {*this, AsyncPriority::kLow},
+                           {*this, AsyncPriority::kNormal},
+                           {*this, AsyncPriority::kHigh} }}
+  , m_next_sequence{1}
+  , m_pending_dispatches{0}
+  , m_mtx{}
+  , m_cv{}
+{}
+
+PriorityScheduler::~PriorityScheduler()
+{
+  // Queued dispatch tasks reference this object
+  std::unique_lock<std::mutex> lk{m_mtx};
+  m_cv.wait(lk, [this](){ return m_pending_dispatches == 0; });
+}
+
+std::size_t PriorityScheduler::Submit(AsyncExecutor::Task task, AsyncPriority priority)
+{
+  const auto queue_idx = PriorityToIndex(priority);
+  // Nothing to overtake: bypass the queues
+  if (queue_idx == kNormalPriorityIndex && m_n_urgent_tasks.load() == 0)
+  {
+    m_executor.Submit(std::move(task));
+    return 0;
+  }
+  std::size_t sequence = 0;
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    sequence = m_next_sequence++;
+    m_queues[queue_idx].push_back(QueuedTask{ sequence, std::move(task) });
+    if (queue_idx >= kNormalPriorityIndex)
+    {
+      ++m_n_urgent_tasks;
+    }
+    ++m_pending_dispatches;
+  }
+  try
+  {
+    // Every queued task gets its own dispatch task, so no task is left behind.
+    m_executor.Submit([this]() { Dispatch(); });
+  }
+  catch(...)
+  {
+    if (TryRemoveTask(queue_idx, sequence))
+    {
+      throw;
+    }
+    // The dispatch task of another task already ran this one, so now another queued task lacks
+    // a dispatch task: run it here instead.
+    RunNextTask();
+  }
+  return sequence;
+}
+
+bool PriorityScheduler::Withdraw(std::size_t sequence)
+{
+  // Declared first, so the task is destroyed after releasing the lock
+  AsyncExecutor::Task task{};
+  std::lock_guard<std::mutex> lk{m_mtx};
+  for (std::size_t idx = 0; idx < kNumberOfPriorities; ++idx)
+  {
+    if (TryEraseTask(idx, sequence, task))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+AsyncExecutor& PriorityScheduler::GetExecutor(AsyncPriority priority)
+{
+  return m_priority_executors[PriorityToIndex(priority)];
+}
+
+void PriorityScheduler::Dispatch()
+{
+  try
+  {
+    RunNextTask();
+  }
+  catch(...)
+  {
+    FinishDispatch();
+    throw;
+  }
+  FinishDispatch();
+}
+
+void PriorityScheduler::RunNextTask()
+{
+  AsyncExecutor::Task task{};
+  if (TryPopNextTask(task))
+  {
+    task();
+  }
+}
+
+bool PriorityScheduler::TryPopNextTask(AsyncExecutor::Task& task)
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  auto selected = SelectQueue();
+  if (selected == kNumberOfPriorities)
+  {
+    return false;
+  }
+  // Lower priority queues that still contain tasks were skipped once more
+  for (std::size_t idx = 0; idx < selected; ++idx)
+  {
+    if (!m_queues[idx].empty())
+    {
+      ++m_skipped[idx];
+    }
+  }
+  m_skipped[selected] = 0;
+  task = std::move(m_queues[selected].front().m_task);
+  m_queues[selected].pop_front();
+  if (selected >= kNormalPriorityIndex)
+  {
+    --m_n_urgent_tasks;
+  }
+  return true;
+}
+
+bool PriorityScheduler::TryRemoveTask(std::size_t queue_idx, std::size_t sequence)
+{
+  AsyncExecutor::Task task{};
+  std::lock_guard<std::mutex> lk{m_mtx};
+  // This dispatch task was never submitted
+  --m_pending_dispatches;
+  m_cv.notify_all();
+  return TryEraseTask(queue_idx, sequence, task);
+}
+
+bool PriorityScheduler::TryEraseTask(std::size_t queue_idx, std::size_t sequence,
+                                     AsyncExecutor::Task& task)
+{
+  // Sequence numbers increase within each queue
+  auto& queue = m_queues[queue_idx];
+  auto iter = std::lower_bound(queue.begin(), queue.end(), sequence,
+                               [](const QueuedTask& queued, std::size_t value) {
+                                 return queued.m_sequence < value;
+                               });
+  if (iter == queue.end() || iter->m_sequence != sequence)
+  {
+    return false;
+  }
+  task = std::move(iter->m_task);
+  (void)queue.erase(iter);
+  if (queue_idx >= kNormalPriorityIndex)
+  {
+    --m_n_urgent_tasks;
+  }
+  return true;
+}
+
+void PriorityScheduler::FinishDispatch()
+{
+  // Notify while holding the lock, since the scheduler may be destroyed right after
+  std::lock_guard<std::mutex> lk{m_mtx};
+  --m_pending_dispatches;
+  m_cv.notify_all();
+}
+
+std::size_t PriorityScheduler::SelectQueue() const
+{
+  // Queues that were skipped too often go first, starting with the lowest priority
+  for (std::size_t idx = 0; idx < kNumberOfPriorities; ++idx)
+  {
+    if (!m_queues[idx].empty() && m_skipped[idx] >= m_max_skips)
+    {
+      return idx;
+    }
+  }
+  for (std::size_t idx = kNumberOfPriorities; idx > 0; --idx)
+  {
+    if (!m_queues[idx - 1].empty())
+    {
+      return idx - 1;
+    }
+  }
+  return kNumberOfPriorities;
+}
+
+PriorityScheduler::PriorityExecutor::PriorityExecutor(PriorityScheduler& scheduler,
+                                                      AsyncPriority priority)
+  : m_scheduler{scheduler}
+  , m_priority{priority}
+{}
+
+PriorityScheduler::PriorityExecutor::~PriorityExecutor() = default;
+
+void PriorityScheduler::PriorityExecutor::Submit(Task task)
+{
+  m_scheduler.Submit(std::move(task), m_priority);
+}
+
+namespace
+{
+std::size_t PriorityToIndex(AsyncPriority priority)
+{
+  switch (priority)
+  {
+  case AsyncPriority::kLow:
+    return 0;
+  case AsyncPriority::kHigh:
+    return 2;
+  default:
+    break;
+  }
+  return 1;
+}
+}  // unnamed namespace
+
+}  // namespace protocol
+
+}  // namespace sup
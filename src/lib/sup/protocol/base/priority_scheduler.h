@@ -0,0 +1,154 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_PRIORITY_SCHEDULER_H_
+#define SUP_PROTOCOL_PRIORITY_SCHEDULER_H_
+
+#include <sup/protocol/async_executor.h>
+#include <sup/protocol/protocol_rpc.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Scheduler that orders tasks by priority before handing them to an executor.
+ *
+ * @details Each submitted task is queued according to its priority and a dispatch task is submitted
+ * to the underlying executor. When such a dispatch task runs, it executes the queued task with the
+ * highest priority. As a consequence, the priority only matters when the executor cannot run all
+ * tasks immediately (e.g. a worker pool with all workers busy).
+ *
+ * Tasks with normal priority are submitted straight to the executor when no tasks of normal or
+ * high priority are queued. In the common case where priorities are not used, this avoids the
+ * shared queues and their mutex, so the executor's own queues (e.g. the per-worker queues of a
+ * work-stealing pool) are used directly. Such tasks are no longer overtaken by tasks with a high
+ * priority that are submitted later.
+ *
+ * To protect lower priorities from starvation, a non-empty priority queue that was passed over a
+ * given number of times in a row will be served next, regardless of the higher priority tasks.
+ *
+ * @note The dispatch tasks reference the scheduler, so its destructor blocks until the executor
+ * has run all of them. The executor therefore needs to outlive the scheduler and keep running
+ * tasks until then, which also holds for executors provided by the application.
+ */
+class PriorityScheduler
+{
+public:
+  /**
+   * @brief Constructor.
+   *
+   * @param executor Executor that will run the tasks.
+   * @param max_skips Maximum number of times a non-empty priority queue can be passed over in
+   * favour of a higher priority queue.
+   */
+  PriorityScheduler(AsyncExecutor& executor, std::size_t max_skips);
+  ~PriorityScheduler();
+
+  // No copy/move ctor/assignment:
+  PriorityScheduler(const PriorityScheduler&) = delete;
+  PriorityScheduler(PriorityScheduler&&) = delete;
+  PriorityScheduler& operator=(const PriorityScheduler&) = delete;
+  PriorityScheduler& operator=(PriorityScheduler&&) = delete;
+
+  /**
+   * @brief Submit a task with the given priority.
+   *
+   * @param task Task to execute.
+   * @param priority Priority of the task.
+   * @return Sequence number of the queued task, which can be used to withdraw it, or zero if the
+   * task was submitted straight to the executor.
+   *
+   * @throws Any exception thrown by the executor when submitting the dispatch task. The task is
+   * then not queued.
+   */
+  std::size_t Submit(AsyncExecutor::Task task, AsyncPriority priority);
+
+  /**
+   * @brief Remove a queued task that was not dispatched yet, releasing the task (and everything it
+   * holds) right away. Its dispatch task stays with the executor and will run another queued task
+   * or nothing at all.
+   *
+   * @param sequence Sequence number returned by Submit().
+   * @return true if the task was still queued and is now removed.
+   */
+  bool Withdraw(std::size_t sequence);
+
+  /**
+   * @brief Get an executor that submits its tasks to this scheduler with a fixed priority.
+   *
+   * @param priority Priority of the tasks submitted to the returned executor.
+   * @return Executor for the given priority.
+   */
+  AsyncExecutor& GetExecutor(AsyncPriority priority);
+
+private:
+  class PriorityExecutor : public AsyncExecutor
+  {
+  public:
+    PriorityExecutor(PriorityScheduler& scheduler, AsyncPriority priority);
+    ~PriorityExecutor() override;
+
+    void Submit(Task task) override;
+  private:
+    PriorityScheduler& m_scheduler;
+    AsyncPriority m_priority;
+  };
+  struct QueuedTask
+  {
+    std::size_t m_sequence;
+    AsyncExecutor::Task m_task;
+  };
+  static constexpr std::size_t kNumberOfPriorities = 3;
+  static constexpr std::size_t kNormalPriorityIndex = 1;
+  void Dispatch();
+  void RunNextTask();
+  bool TryPopNextTask(AsyncExecutor::Task& task);
+  bool TryRemoveTask(std::size_t queue_idx, std::size_t sequence);
+  bool TryEraseTask(std::size_t queue_idx, std::size_t sequence, AsyncExecutor::Task& task);
+  void FinishDispatch();
+  std::size_t SelectQueue() const;
+
+  AsyncExecutor& m_executor;
+  const std::size_t m_max_skips;
+  std::array<std::deque<QueuedTask>, kNumberOfPriorities> m_queues;
+  // Number of queued tasks with normal or high priority, read without holding the lock
+  std::atomic<std::size_t> m_n_urgent_tasks;
+  std::array<std::size_t, kNumberOfPriorities> m_skipped;
+  std::array<PriorityExecutor, kNumberOfPriorities> m_priority_executors;
+  std::size_t m_next_sequence;
+  // Dispatch tasks that were submitted to the executor and did not finish yet
+  std::size_t m_pending_dispatches;
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_PRIORITY_SCHEDULER_H_
@@ -50,7 +50,9 @@ enum ProtocolStatus : sup::dto::uint32
   INVALID_ASYNCHROUNOUS_OPERATION,
   SERVER_PROTOCOL_EXCEPTION,
   CLIENT_TRANSPORT_EXCEPTION,
-  ASYNCHRONOUS_PROTOCOL_TIMEOUT
+  ASYNCHRONOUS_PROTOCOL_TIMEOUT,
+  SERVER_BUSY,
+  ASYNCHRONOUS_REPLY_EVICTED
 };
 }  // namespace status
 
@@ -115,7 +117,9 @@ std::string ProtocolResultToString(const ProtocolResult& result)
       {status::INVALID_ASYNCHROUNOUS_OPERATION, "InvalidAsynchronousOperationError"},
       {status::SERVER_PROTOCOL_EXCEPTION, "ServerProtocolException"},
       {status::CLIENT_TRANSPORT_EXCEPTION, "ClientTransportException"},
-      {status::ASYNCHRONOUS_PROTOCOL_TIMEOUT, "AsynchronousProtocolTimeout"}};
+      {status::ASYNCHRONOUS_PROTOCOL_TIMEOUT, "AsynchronousProtocolTimeout"},
+      {status::SERVER_BUSY, "ServerBusy"},
+      {status::ASYNCHRONOUS_REPLY_EVICTED, "AsynchronousReplyEvicted"}};
   auto it = results.find(result.GetValue());
   if (it != results.end())
   {
@@ -145,6 +149,8 @@ const ProtocolResult InvalidAsynchronousOperationError{status::INVALID_ASYNCHROU
 const ProtocolResult ServerProtocolException{status::SERVER_PROTOCOL_EXCEPTION};
 const ProtocolResult ClientTransportException{status::CLIENT_TRANSPORT_EXCEPTION};
 const ProtocolResult AsynchronousProtocolTimeout{status::ASYNCHRONOUS_PROTOCOL_TIMEOUT};
+const ProtocolResult ServerBusy{status::SERVER_BUSY};
+const ProtocolResult AsynchronousReplyEvicted{status::ASYNCHRONOUS_REPLY_EVICTED};
 
 }  // namespace protocol
 
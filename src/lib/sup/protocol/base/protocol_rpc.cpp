@@ -96,6 +96,18 @@ bool CheckRequestFormat(const sup::dto::AnyValue& request)
   {
     return false;
   }
+  // Only check type of async priority field when present
+  if (!ValidateMemberTypeIfPresent(request, constants::ASYNC_PRIORITY_FIELD_NAME,
+                                   sup::dto::UnsignedInteger32Type))
+  {
+    return false;
+  }
+  // Only check type of async idempotency key field when present
+  if (!ValidateMemberTypeIfPresent(request, constants::ASYNC_KEY_FIELD_NAME,
+                                   sup::dto::StringType))
+  {
+    return false;
+  }
   if (!request.HasField(constants::REQUEST_PAYLOAD))
   {
     return false;
@@ -162,10 +174,59 @@ sup::dto::AnyValue CreateAsyncRPCRequest(const sup::dto::AnyValue& payload,
   return request;
 }
 
+sup::dto::AnyValue CreateAsyncRPCRequest(const sup::dto::AnyValue& payload,
+                                         PayloadEncoding encoding, AsyncPriority priority)
+{
+  auto request = CreateAsyncRPCRequest(payload, encoding);
+  // Only add the priority field when needed, so normal requests are understood by older servers
+  if (priority != AsyncPriority::kNormal)
+  {
+    (void)request.AddMember(constants::ASYNC_PRIORITY_FIELD_NAME,
+                            static_cast<sup::dto::uint32>(priority));
+  }
+  return request;
+}
+
+sup::dto::AnyValue CreateAsyncRPCRequest(const sup::dto::AnyValue& payload,
+                                         PayloadEncoding encoding, AsyncPriority priority,
+                                         const std::string& key)
+{
+  auto request = CreateAsyncRPCRequest(payload, encoding, priority);
+  if (!key.empty())
+  {
+    (void)request.AddMember(constants::ASYNC_KEY_FIELD_NAME,
+                            sup::dto::AnyValue{ sup::dto::StringType, key });
+  }
+  return request;
+}
+
 sup::dto::AnyValue CreateAsyncRPCPoll(sup::dto::uint64 id, PayloadEncoding encoding)
+{
+  return CreateAsyncRPCPoll(id, encoding, 0.0);
+}
+
+sup::dto::AnyValue CreateAsyncRPCPoll(sup::dto::uint64 id, PayloadEncoding encoding,
+                                      double wait_sec)
+{
+  return CreateAsyncRPCPoll(id, encoding, wait_sec, false);
+}
+
+sup::dto::AnyValue CreateAsyncRPCPoll(sup::dto::uint64 id, PayloadEncoding encoding,
+                                      double wait_sec, bool inline_reply)
 {
   sup::dto::AnyValue request = sup::dto::EmptyStruct(constants::REQUEST_TYPE_NAME);
   auto payload = CreateRequestIdPayload(id);
+  // Only add optional fields when needed, so plain polls stay identical to older clients
+  if (wait_sec > 0.0)
+  {
+    (void)payload.AddMember(constants::ASYNC_WAIT_FIELD_NAME,
+                            sup::dto::AnyValue{ sup::dto::Float64Type, wait_sec });
+  }
+  if (inline_reply)
+  {
+    (void)payload.AddMember(constants::ASYNC_INLINE_REPLY_FIELD_NAME,
+                            sup::dto::AnyValue{ sup::dto::BooleanType, true });
+  }
   AddRPCPayload(request, payload, constants::REQUEST_PAYLOAD, encoding);
   (void)request.AddMember(constants::ASYNC_COMMAND_FIELD_NAME,
                           static_cast<sup::dto::uint32>(AsyncCommand::kPoll));
@@ -234,18 +295,66 @@ sup::dto::AnyValue CreateAsyncRPCReply(const sup::protocol::ProtocolResult& resu
 
 sup::dto::AnyValue CreateAsyncRPCNewRequestReply(sup::dto::uint64 id, PayloadEncoding encoding)
 {
-  const sup::dto::AnyValue reply_payload = {{
+  return CreateAsyncRPCNewRequestReply(id, encoding, 0.0);
+}
+
+sup::dto::AnyValue CreateAsyncRPCNewRequestReply(sup::dto::uint64 id, PayloadEncoding encoding,
+                                                 double max_wait_sec)
+{
+  return CreateAsyncRPCNewRequestReply(id, encoding, max_wait_sec, 0.0);
+}
+
+sup::dto::AnyValue CreateAsyncRPCNewRequestReply(sup::dto::uint64 id, PayloadEncoding encoding,
+                                                 double max_wait_sec, double retry_after_sec)
+{
+  sup::dto::AnyValue reply_payload = {{
     { constants::ASYNC_ID_FIELD_NAME, { sup::dto::UnsignedInteger64Type, id }}
   }};
+  if (max_wait_sec > 0.0)
+  {
+    (void)reply_payload.AddMember(constants::ASYNC_MAX_WAIT_FIELD_NAME,
+                                  sup::dto::AnyValue{ sup::dto::Float64Type, max_wait_sec });
+  }
+  if (retry_after_sec > 0.0)
+  {
+    (void)reply_payload.AddMember(constants::ASYNC_RETRY_AFTER_FIELD_NAME,
+                                  sup::dto::AnyValue{ sup::dto::Float64Type, retry_after_sec });
+  }
   return utils::CreateAsyncRPCReply(Success, reply_payload, encoding,
                                     AsyncCommand::kInitialRequest);
 }
 
 sup::dto::AnyValue CreateAsyncRPCPollReply(bool is_ready, PayloadEncoding encoding)
 {
-  const sup::dto::AnyValue reply_payload = {{
+  return CreateAsyncRPCPollReply(is_ready, encoding, 0.0);
+}
+
+sup::dto::AnyValue CreateAsyncRPCPollReply(bool is_ready, PayloadEncoding encoding,
+                                           double retry_after_sec)
+{
+  sup::dto::AnyValue reply_payload = {{
     { constants::ASYNC_READY_FIELD_NAME, { sup::dto::BooleanType, dto::AnyValue{is_ready} }}
   }};
+  if (retry_after_sec > 0.0)
+  {
+    (void)reply_payload.AddMember(constants::ASYNC_RETRY_AFTER_FIELD_NAME,
+                                  sup::dto::AnyValue{ sup::dto::Float64Type, retry_after_sec });
+  }
+  return utils::CreateAsyncRPCReply(Success, reply_payload, encoding, AsyncCommand::kPoll);
+}
+
+sup::dto::AnyValue CreateAsyncRPCPollReply(const sup::protocol::ProtocolResult& result,
+                                           const sup::dto::AnyValue& payload,
+                                           PayloadEncoding encoding)
+{
+  sup::dto::AnyValue reply_payload = {{
+    { constants::ASYNC_READY_FIELD_NAME, { sup::dto::BooleanType, true }},
+    { constants::REPLY_RESULT, { sup::dto::UnsignedInteger32Type, result.GetValue() }}
+  }};
+  if (!sup::dto::IsEmptyValue(payload))
+  {
+    (void)reply_payload.AddMember(constants::REPLY_PAYLOAD, payload);
+  }
   return utils::CreateAsyncRPCReply(Success, reply_payload, encoding, AsyncCommand::kPoll);
 }
 
@@ -469,6 +578,63 @@ std::pair<bool, AsyncCommand> GetAsyncInfo(const sup::dto::AnyValue& packet)
   return { false, AsyncCommand::kInitialRequest };
 }
 
+AsyncPriority GetAsyncPriority(const sup::dto::AnyValue& packet)
+{
+  if (!packet.HasField(constants::ASYNC_PRIORITY_FIELD_NAME) ||
+      packet[constants::ASYNC_PRIORITY_FIELD_NAME].GetType() != sup::dto::UnsignedInteger32Type)
+  {
+    return AsyncPriority::kNormal;
+  }
+  auto priority_nr = packet[constants::ASYNC_PRIORITY_FIELD_NAME].As<sup::dto::uint32>();
+  if (priority_nr > static_cast<sup::dto::uint32>(AsyncPriority::kHigh))
+  {
+    return AsyncPriority::kNormal;
+  }
+  return static_cast<AsyncPriority>(priority_nr);
+}
+
+std::string GetAsyncRequestKey(const sup::dto::AnyValue& packet)
+{
+  if (!packet.HasField(constants::ASYNC_KEY_FIELD_NAME) ||
+      packet[constants::ASYNC_KEY_FIELD_NAME].GetType() != sup::dto::StringType)
+  {
+    return {};
+  }
+  return packet[constants::ASYNC_KEY_FIELD_NAME].As<std::string>();
+}
+
+double GetAsyncMaxPollWait(const sup::dto::AnyValue& packet, PayloadEncoding encoding)
+{
+  auto payload_result = utils::TryExtractRPCReplyPayload(packet, encoding);
+  if (!payload_result.first)
+  {
+    return 0.0;
+  }
+  const auto& payload = payload_result.second;
+  if (!payload.HasField(constants::ASYNC_MAX_WAIT_FIELD_NAME) ||
+      payload[constants::ASYNC_MAX_WAIT_FIELD_NAME].GetType() != sup::dto::Float64Type)
+  {
+    return 0.0;
+  }
+  return payload[constants::ASYNC_MAX_WAIT_FIELD_NAME].As<sup::dto::float64>();
+}
+
+double GetAsyncRetryAfter(const sup::dto::AnyValue& packet, PayloadEncoding encoding)
+{
+  auto payload_result = utils::TryExtractRPCReplyPayload(packet, encoding);
+  if (!payload_result.first)
+  {
+    return 0.0;
+  }
+  const auto& payload = payload_result.second;
+  if (!payload.HasField(constants::ASYNC_RETRY_AFTER_FIELD_NAME) ||
+      payload[constants::ASYNC_RETRY_AFTER_FIELD_NAME].GetType() != sup::dto::Float64Type)
+  {
+    return 0.0;
+  }
+  return payload[constants::ASYNC_RETRY_AFTER_FIELD_NAME].As<sup::dto::float64>();
+}
+
 }  // namespace utils
 
 }  // namespace protocol
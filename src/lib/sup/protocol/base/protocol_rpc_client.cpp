@@ -19,6 +19,7 @@
  ******************************************************************************/
 
 #include "polling_timeout_handler.h"
+#include "stage_timers.h"
 
 #include <sup/dto/anyvalue_helper.h>
 #include <sup/protocol/async_invocation.h>
@@ -26,25 +27,44 @@
 #include <sup/protocol/protocol_rpc.h>
 #include <sup/protocol/protocol_rpc_client.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+
 namespace sup
 {
 namespace protocol
 {
 namespace
 {
+const std::size_t kNumberOfClientStages =
+  static_cast<std::size_t>(RPCClientStage::kPayloadDecoding) + 1;
+
+// Lower bound on the delay suggested by the server, to avoid polling in a tight loop
+const double kMinRetryAfterSec = 1e-3;
+
+std::string CreateIdempotencyKey();
+bool WaitForNextPoll(PollingTimeoutHandler& polling_handler, double retry_after_sec);
 std::pair<bool, sup::dto::AnyValue> TryGetPayload(const sup::dto::AnyValue& reply);
-ProtocolResult HandleSyncInvokeReply(const sup::dto::AnyValue& reply, sup::dto::AnyValue& output);
+ProtocolResult HandleSyncInvokeReply(const sup::dto::AnyValue& reply, sup::dto::AnyValue& output,
+                                     PayloadEncoding encoding, StageTimer& timer);
 }  // unnamed namespace
 
 ProtocolRPCClient::ProtocolRPCClient(sup::dto::AnyFunctor& any_functor, PayloadEncoding encoding)
-    : m_any_functor{any_functor}, m_config{encoding}
+    : m_any_functor{any_functor}, m_config{encoding}, m_stage_timers{}
 {
 }
 
 ProtocolRPCClient::ProtocolRPCClient(sup::dto::AnyFunctor& any_functor,
                                      ProtocolRPCClientConfig config)
-    : m_any_functor{any_functor}, m_config{config}
+    : m_any_functor{any_functor}, m_config{config}, m_stage_timers{}
 {
+  if (m_config.m_stage_timing)
+  {
+    m_stage_timers = std::make_unique<StageTimers>(kNumberOfClientStages);
+  }
 }
 
 ProtocolRPCClient::~ProtocolRPCClient() = default;
@@ -106,10 +126,31 @@ ProtocolResult ProtocolRPCClient::Service(const sup::dto::AnyValue& input,
   return result;
 }
 
+LatencyDistribution ProtocolRPCClient::GetStageLatency(RPCClientStage stage,
+                                                       PayloadEncoding encoding) const
+{
+  if (!m_stage_timers)
+  {
+    return {};
+  }
+  return m_stage_timers->GetSnapshot(static_cast<std::size_t>(stage), encoding);
+}
+
+void ProtocolRPCClient::ResetStageLatencies()
+{
+  if (m_stage_timers)
+  {
+    m_stage_timers->Reset();
+  }
+}
+
 ProtocolResult ProtocolRPCClient::HandleSyncInvoke(const sup::dto::AnyValue& input,
                                                    sup::dto::AnyValue& output)
 {
-  auto request = utils::CreateRPCRequest(input, m_config.m_encoding);
+  StageTimer timer{m_stage_timers.get()};
+  const auto encoding = m_config.m_encoding;
+  auto request = utils::CreateRPCRequest(input, encoding);
+  timer.EndStage(RPCClientStage::kRequestEncoding, encoding);
   sup::dto::AnyValue reply;
   try
   {
@@ -119,24 +160,49 @@ ProtocolResult ProtocolRPCClient::HandleSyncInvoke(const sup::dto::AnyValue& inp
   {
     return ClientTransportException;
   }
-  return HandleSyncInvokeReply(reply, output);
+  timer.EndStage(RPCClientStage::kTransport, encoding);
+  return HandleSyncInvokeReply(reply, output, encoding, timer);
 }
 
 ProtocolResult ProtocolRPCClient::HandleAsyncInvoke(const sup::dto::AnyValue& input,
                                                     sup::dto::AnyValue& output)
 {
-  AsyncInvocation invocation{m_any_functor, m_config.m_encoding};
+  // Without retries, there is no need for the server to index the request by key
+  const auto key = m_config.m_start_retries > 0 ? CreateIdempotencyKey() : std::string{};
+  AsyncInvocation invocation{m_any_functor, m_config.m_encoding, m_config.m_priority, key};
+  PollingTimeoutHandler polling_handler{m_config.m_timeout_sec, m_config.m_polling_interval_sec};
   auto start_result = invocation.Start(input);
+  // Back off and retry while the server is busy or the request may have been lost. Thanks to the
+  // key, a lost request that did reach the server is not started again.
+  std::size_t n_start_retries = 0;
+  while (start_result == ServerBusy
+         || (start_result == ClientTransportException
+             && n_start_retries++ < m_config.m_start_retries))
+  {
+    if (!polling_handler.Wait())
+    {
+      return start_result;
+    }
+    start_result = invocation.Start(input);
+  }
   if (start_result != Success)
   {
     return start_result;
   }
   if (!invocation.IsSynchronous())
   {
-    PollingTimeoutHandler polling_handler{m_config.m_timeout_sec, m_config.m_polling_interval_sec};
+    // When the server supports it, let it hold each poll until the reply is ready
+    const bool long_poll = invocation.GetMaxPollWait() > 0.0;
+    // Do not poll before the server expects the reply to be ready
+    if (!long_poll && invocation.GetRetryAfter() > 0.0
+        && !WaitForNextPoll(polling_handler, invocation.GetRetryAfter()))
+    {
+      return AsynchronousProtocolTimeout;
+    }
     while (true)
     {
-      auto poll_result = invocation.PollOnce();
+      const auto remaining_sec = polling_handler.GetRemainingTime();
+      auto poll_result = long_poll ? invocation.PollOnce(remaining_sec) : invocation.PollOnce();
       if (poll_result.first != Success)
       {
         return poll_result.first;
@@ -145,7 +211,14 @@ ProtocolResult ProtocolRPCClient::HandleAsyncInvoke(const sup::dto::AnyValue& in
       {
         break;
       }
-      if (!polling_handler.Wait())
+      // A poll that was held as long as requested already waited on the server side: only check
+      // the timeout. A server can also answer a held poll early (e.g. when it does not hold polls
+      // at all), in which case the client still waits before polling again.
+      const auto requested_sec = std::min(remaining_sec, invocation.GetMaxPollWait());
+      const bool was_held = long_poll
+                            && remaining_sec - polling_handler.GetRemainingTime() >= requested_sec;
+      if (was_held ? polling_handler.GetRemainingTime() <= 0.0
+                   : !WaitForNextPoll(polling_handler, invocation.GetRetryAfter()))
       {
         return AsynchronousProtocolTimeout;
       }
@@ -157,6 +230,28 @@ ProtocolResult ProtocolRPCClient::HandleAsyncInvoke(const sup::dto::AnyValue& in
 namespace
 {
 
+std::string CreateIdempotencyKey()
+{
+  // The random prefix keeps the keys of different client processes apart
+  static const std::string prefix = []() {
+    std::random_device device;
+    const std::uint64_t high = device();
+    return std::to_string((high << 32) | device());
+  }();
+  static std::atomic<std::uint64_t> counter{0};
+  return prefix + "-" + std::to_string(++counter);
+}
+
+bool WaitForNextPoll(PollingTimeoutHandler& polling_handler, double retry_after_sec)
+{
+  // Follow the suggestion of the server when it gave one
+  if (retry_after_sec > 0.0)
+  {
+    return polling_handler.Wait(std::max(retry_after_sec, kMinRetryAfterSec));
+  }
+  return polling_handler.Wait();
+}
+
 std::pair<bool, sup::dto::AnyValue> TryGetPayload(const sup::dto::AnyValue& reply)
 {
   std::pair<bool, sup::dto::AnyValue> failure{false, {}};
@@ -178,7 +273,8 @@ std::pair<bool, sup::dto::AnyValue> TryGetPayload(const sup::dto::AnyValue& repl
   return {true, payload_result.second};
 }
 
-ProtocolResult HandleSyncInvokeReply(const sup::dto::AnyValue& reply, sup::dto::AnyValue& output)
+ProtocolResult HandleSyncInvokeReply(const sup::dto::AnyValue& reply, sup::dto::AnyValue& output,
+                                     PayloadEncoding encoding, StageTimer& timer)
 {
   if (!utils::CheckReplyFormat(reply))
   {
@@ -190,6 +286,7 @@ ProtocolResult HandleSyncInvokeReply(const sup::dto::AnyValue& reply, sup::dto::
     return ClientTransportDecodingError;
   }
   auto result = result_info.second;
+  timer.EndStage(RPCClientStage::kReplyCheck, encoding);
   if (result == Success)
   {
     auto payload_info = TryGetPayload(reply);
@@ -202,6 +299,7 @@ ProtocolResult HandleSyncInvokeReply(const sup::dto::AnyValue& reply, sup::dto::
     {
       return ClientTransportDecodingError;
     }
+    timer.EndStage(RPCClientStage::kPayloadDecoding, encoding);
   }
   return result;
 }
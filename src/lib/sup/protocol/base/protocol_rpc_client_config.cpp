@@ -30,6 +30,9 @@ ProtocolRPCClientConfig::ProtocolRPCClientConfig()
   , m_async{false}
   , m_timeout_sec{}
   , m_polling_interval_sec{}
+  , m_priority{AsyncPriority::kNormal}
+  , m_start_retries{2}
+  , m_stage_timing{false}
 {}
 
 ProtocolRPCClientConfig::ProtocolRPCClientConfig(PayloadEncoding encoding)
@@ -37,6 +40,9 @@ ProtocolRPCClientConfig::ProtocolRPCClientConfig(PayloadEncoding encoding)
   , m_async{false}
   , m_timeout_sec{}
   , m_polling_interval_sec{}
+  , m_priority{AsyncPriority::kNormal}
+  , m_start_retries{2}
+  , m_stage_timing{false}
 {}
 
 ProtocolRPCClientConfig::ProtocolRPCClientConfig(PayloadEncoding encoding, double timeout_sec,
@@ -45,6 +51,9 @@ ProtocolRPCClientConfig::ProtocolRPCClientConfig(PayloadEncoding encoding, doubl
   , m_async{true}
   , m_timeout_sec{timeout_sec}
   , m_polling_interval_sec{polling_interval_sec}
+  , m_priority{AsyncPriority::kNormal}
+  , m_start_retries{2}
+  , m_stage_timing{false}
 {}
 
 ProtocolRPCClientConfig::~ProtocolRPCClientConfig() = default;
@@ -22,7 +22,10 @@
 #include <sup/protocol/exceptions.h>
 
 #include <sup/protocol/base/async_invoke_server.h>
+#include <sup/protocol/base/expiration_reaper.h>
 #include <sup/protocol/base/expiration_timeout_handler.h>
+#include <sup/protocol/base/reply_cache.h>
+#include <sup/protocol/base/stage_timers.h>
 
 #include <sup/dto/anyvalue_helper.h>
 #include <memory>
@@ -31,6 +34,13 @@ namespace sup
 {
 namespace protocol
 {
+namespace
+{
+const std::size_t kNumberOfServerStages =
+  static_cast<std::size_t>(RPCServerStage::kReplyEncoding) + 1;
+// Bounds the memory for constant service replies, in case the predicate matches many queries
+const std::size_t kMaxConstantServiceReplies = 16;
+}  // unnamed namespace
 
 ProtocolRPCServer::ProtocolRPCServer(Protocol& protocol)
   : ProtocolRPCServer{protocol, ProtocolRPCServerConfig{}}
@@ -38,18 +48,53 @@ ProtocolRPCServer::ProtocolRPCServer(Protocol& protocol)
 
 ProtocolRPCServer::ProtocolRPCServer(Protocol& protocol, ProtocolRPCServerConfig config)
   : m_protocol{protocol}
-  , m_async_server{std::make_unique<AsyncInvokeServer>(m_protocol, config.m_expiration_sec)}
-  , m_expiration_handler{std::make_unique<ExpirationTimeoutHandler>(config.m_expiration_sec / 2.0)}
-{}
+  , m_async_server{std::make_unique<AsyncInvokeServer>(m_protocol, config)}
+  , m_expiration_handler{}
+  , m_reaper{}
+  , m_reply_cache{}
+  , m_cacheable{config.m_cacheable}
+  , m_service_cache{}
+  , m_constant_service{config.m_constant_service}
+  , m_stage_timers{}
+{
+  if (config.m_cleanup_interval_sec > 0.0)
+  {
+    auto cleanup = [this]() { m_async_server->CleanUpExpiredRequests(); };
+    m_reaper = std::make_unique<ExpirationReaper>(cleanup, config.m_cleanup_interval_sec);
+  }
+  else
+  {
+    m_expiration_handler =
+      std::make_unique<ExpirationTimeoutHandler>(config.m_expiration_sec / 2.0,
+                                                 m_async_server->GetClock());
+  }
+  if (config.m_reply_cache_size > 0 && m_cacheable)
+  {
+    m_reply_cache = std::make_unique<ReplyCache>(config.m_reply_cache_size,
+                                                 config.m_reply_cache_bytes,
+                                                 config.m_reply_cache_ttl_sec,
+                                                 m_async_server->GetClock());
+  }
+  if (m_constant_service)
+  {
+    m_service_cache = std::make_unique<ReplyCache>(kMaxConstantServiceReplies, 0, 0.0);
+  }
+  if (config.m_stage_timing)
+  {
+    m_stage_timers = std::make_unique<StageTimers>(kNumberOfServerStages);
+  }
+}
 
 ProtocolRPCServer::~ProtocolRPCServer() = default;
 
 sup::dto::AnyValue ProtocolRPCServer::operator()(const sup::dto::AnyValue& input)
 {
-  if (m_expiration_handler->IsCleanUpNeeded())
+  // Only clean up inline when there is no background reaper
+  if (m_expiration_handler && m_expiration_handler->IsCleanUpNeeded())
   {
     m_async_server->CleanUpExpiredRequests();
   }
+  StageTimer timer{m_stage_timers.get()};
   auto encoding_result = utils::TryGetPacketEncoding(input);
   if (!encoding_result.first)
   {
@@ -60,27 +105,111 @@ sup::dto::AnyValue ProtocolRPCServer::operator()(const sup::dto::AnyValue& input
   {
     return HandleServiceRequest(input, encoding);
   }
-  return HandleInvokeRequest(input, encoding);
+  // Only synchronous invokes are timed, which is only known after decoding the payload
+  timer.HoldStage(RPCServerStage::kEncodingDetection);
+  return HandleInvokeRequest(input, encoding, timer);
+}
+
+std::size_t ProtocolRPCServer::GetNumberOfAbandonedRequests() const
+{
+  return m_async_server->GetNumberOfAbandonedRequests();
+}
+
+std::size_t ProtocolRPCServer::GetRetainedReplySize() const
+{
+  return m_async_server->GetRetainedReplySize();
+}
+
+std::size_t ProtocolRPCServer::GetNumberOfEvictedReplies() const
+{
+  return m_async_server->GetNumberOfEvictedReplies();
+}
+
+std::size_t ProtocolRPCServer::GetNumberOfSpilledReplies() const
+{
+  return m_async_server->GetNumberOfSpilledReplies();
+}
+
+AsyncLatencyStatistics ProtocolRPCServer::GetAsyncLatencyStatistics() const
+{
+  return m_async_server->GetLatencyStatistics();
+}
+
+void ProtocolRPCServer::ResetAsyncLatencyStatistics()
+{
+  m_async_server->ResetLatencyStatistics();
+}
+
+std::size_t ProtocolRPCServer::GetReplyCacheHits() const
+{
+  return m_reply_cache ? m_reply_cache->GetNumberOfHits() : 0;
+}
+
+std::size_t ProtocolRPCServer::GetReplyCacheMisses() const
+{
+  return m_reply_cache ? m_reply_cache->GetNumberOfMisses() : 0;
+}
+
+std::size_t ProtocolRPCServer::GetConstantServiceReplyHits() const
+{
+  return m_service_cache ? m_service_cache->GetNumberOfHits() : 0;
+}
+
+LatencyDistribution ProtocolRPCServer::GetStageLatency(RPCServerStage stage,
+                                                       PayloadEncoding encoding) const
+{
+  if (!m_stage_timers)
+  {
+    return {};
+  }
+  return m_stage_timers->GetSnapshot(static_cast<std::size_t>(stage), encoding);
+}
+
+void ProtocolRPCServer::ResetStageLatencies()
+{
+  if (m_stage_timers)
+  {
+    m_stage_timers->Reset();
+  }
 }
 
 sup::dto::AnyValue ProtocolRPCServer::HandleInvokeRequest(const sup::dto::AnyValue& request,
-                                                          PayloadEncoding encoding)
+                                                          PayloadEncoding encoding,
+                                                          StageTimer& timer)
 {
   if (!utils::CheckRequestFormat(request))
   {
     return utils::CreateRPCReply(ServerTransportDecodingError);
   }
+  timer.HoldStage(RPCServerStage::kRequestCheck);
   auto payload_result = utils::TryExtractRPCRequestPayload(request, encoding);
   if (!payload_result.first)
   {
     return utils::CreateRPCReply(ServerTransportDecodingError);
   }
   auto payload = payload_result.second;
+  timer.HoldStage(RPCServerStage::kPayloadDecoding);
   auto async_info = utils::GetAsyncInfo(request);
+  // Other asynchronous commands only carry a request identifier
+  const bool is_invoke = !async_info.first || async_info.second == AsyncCommand::kInitialRequest;
+  std::string cache_key{};
+  if (is_invoke && IsCacheable(payload))
+  {
+    cache_key = GetReplyCacheKey(payload, encoding);
+    auto cached = m_reply_cache->Find(cache_key);
+    if (cached.first)
+    {
+      // Also a new asynchronous request can be answered synchronously
+      return cached.second;
+    }
+  }
   if (async_info.first)
   {
-    return m_async_server->HandleInvoke(payload, encoding, async_info.second);
+    return m_async_server->HandleInvoke(payload, encoding, async_info.second,
+                                        utils::GetAsyncPriority(request),
+                                        utils::GetAsyncRequestKey(request));
   }
+  timer.RecordHeldStages(encoding);
   sup::dto::AnyValue output;
   ProtocolResult result = Success;
   try
@@ -91,7 +220,14 @@ sup::dto::AnyValue ProtocolRPCServer::HandleInvokeRequest(const sup::dto::AnyVal
   {
     return utils::CreateRPCReply(ServerProtocolException);
   }
-  return utils::CreateRPCReply(result, output, encoding);
+  timer.EndStage(RPCServerStage::kInvoke, encoding);
+  auto reply = utils::CreateRPCReply(result, output, encoding);
+  timer.EndStage(RPCServerStage::kReplyEncoding, encoding);
+  if (!cache_key.empty() && result == Success)
+  {
+    m_reply_cache->Insert(cache_key, reply);
+  }
+  return reply;
 }
 
 sup::dto::AnyValue ProtocolRPCServer::HandleServiceRequest(const sup::dto::AnyValue& request,
@@ -103,6 +239,16 @@ sup::dto::AnyValue ProtocolRPCServer::HandleServiceRequest(const sup::dto::AnyVa
     return utils::CreateRPCReply(ServerTransportDecodingError);
   }
   auto payload = payload_result.second;
+  std::string cache_key{};
+  if (IsConstantService(payload))
+  {
+    cache_key = GetReplyCacheKey(payload, encoding);
+    auto cached = m_service_cache->Find(cache_key);
+    if (cached.first)
+    {
+      return cached.second;
+    }
+  }
   sup::dto::AnyValue output;
   ProtocolResult result = Success;
   try
@@ -113,7 +259,45 @@ sup::dto::AnyValue ProtocolRPCServer::HandleServiceRequest(const sup::dto::AnyVa
   {
     return utils::CreateServiceReply(ServerProtocolException);
   }
-  return utils::CreateServiceReply(result, output, encoding);
+  auto reply = utils::CreateServiceReply(result, output, encoding);
+  // Failures are not cached, since the protocol may not be able to answer yet
+  if (!cache_key.empty() && result == Success)
+  {
+    m_service_cache->Insert(cache_key, reply);
+  }
+  return reply;
+}
+
+bool ProtocolRPCServer::IsCacheable(const sup::dto::AnyValue& payload) const
+{
+  if (!m_reply_cache)
+  {
+    return false;
+  }
+  try
+  {
+    return m_cacheable(payload);
+  }
+  catch(...)
+  {
+    return false;
+  }
+}
+
+bool ProtocolRPCServer::IsConstantService(const sup::dto::AnyValue& payload) const
+{
+  if (!m_service_cache)
+  {
+    return false;
+  }
+  try
+  {
+    return m_constant_service(payload);
+  }
+  catch(...)
+  {
+    return false;
+  }
 }
 
 }  // namespace protocol
@@ -27,10 +27,54 @@ namespace protocol
 
 ProtocolRPCServerConfig::ProtocolRPCServerConfig()
   : m_expiration_sec{1800.0}
+  , m_coarse_clock{false}
+  , m_worker_pool_size{0}
+  , m_work_stealing{false}
+  , m_executor{}
+  , m_max_priority_skips{4}
+  , m_max_active_requests{0}
+  , m_max_retained_requests{0}
+  , m_max_retained_reply_bytes{0}
+  , m_pooled_requests{false}
+  , m_reply_spill_threshold{0}
+  , m_reply_spill_directory{}
+  , m_cleanup_interval_sec{0.0}
+  , m_max_poll_wait_sec{0.0}
+  , m_inline_grace_sec{0.0}
+  , m_retry_after_hints{false}
+  , m_completion_callback{}
+  , m_reply_cache_size{0}
+  , m_reply_cache_bytes{0}
+  , m_reply_cache_ttl_sec{0.0}
+  , m_cacheable{}
+  , m_constant_service{}
+  , m_stage_timing{false}
 {}
 
 ProtocolRPCServerConfig::ProtocolRPCServerConfig(double expiration_sec)
   : m_expiration_sec{expiration_sec}
+  , m_coarse_clock{false}
+  , m_worker_pool_size{0}
+  , m_work_stealing{false}
+  , m_executor{}
+  , m_max_priority_skips{4}
+  , m_max_active_requests{0}
+  , m_max_retained_requests{0}
+  , m_max_retained_reply_bytes{0}
+  , m_pooled_requests{false}
+  , m_reply_spill_threshold{0}
+  , m_reply_spill_directory{}
+  , m_cleanup_interval_sec{0.0}
+  , m_max_poll_wait_sec{0.0}
+  , m_inline_grace_sec{0.0}
+  , m_retry_after_hints{false}
+  , m_completion_callback{}
+  , m_reply_cache_size{0}
+  , m_reply_cache_bytes{0}
+  , m_reply_cache_ttl_sec{0.0}
+  , m_cacheable{}
+  , m_constant_service{}
+  , m_stage_timing{false}
 {}
 
 ProtocolRPCServerConfig::~ProtocolRPCServerConfig() = default;
@@ -47,7 +91,9 @@ ProtocolRPCServerConfig& ProtocolRPCServerConfig::operator=(
 
 bool ValidateProtocolRPCServerConfig(const ProtocolRPCServerConfig& cfg)
 {
-  return cfg.m_expiration_sec > 0.0;
+  return cfg.m_expiration_sec > 0.0 && cfg.m_cleanup_interval_sec >= 0.0
+         && cfg.m_max_poll_wait_sec >= 0.0 && cfg.m_inline_grace_sec >= 0.0
+         && cfg.m_reply_cache_ttl_sec >= 0.0;
 }
 
 }  // namespace protocol
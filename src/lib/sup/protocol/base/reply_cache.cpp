@@ -0,0 +1,150 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "reply_cache.h"
+
+#include "anyvalue_utils.h"
+#include "timing_utils.h"
+
+#include <sup/protocol/exceptions.h>
+
+#include <sup/dto/anyvalue_helper.h>
+
+#include <iterator>
+
+namespace sup
+{
+namespace protocol
+{
+
+ReplyCache::ReplyCache(std::size_t max_entries, std::size_t max_bytes, double ttl_sec)
+  : ReplyCache{max_entries, max_bytes, ttl_sec, GetSteadyClock()}
+{}
+
+ReplyCache::ReplyCache(std::size_t max_entries, std::size_t max_bytes, double ttl_sec,
+                       const Clock& clock)
+  : m_max_entries{max_entries}
+  , m_max_bytes{max_bytes}
+  , m_ttl_ns{utils::ToNanoseconds(ttl_sec)}
+  , m_clock{clock}
+  , m_mtx{}
+  , m_entries{}
+  , m_index{}
+  , m_total_bytes{0}
+  , m_hits{0}
+  , m_misses{0}
+{
+  if (m_max_entries == 0)
+  {
+    throw InvalidOperationException("ReplyCache(): maximum number of entries must be larger "
+                                    "than zero");
+  }
+}
+
+ReplyCache::~ReplyCache() = default;
+
+std::pair<bool, sup::dto::AnyValue> ReplyCache::Find(const std::string& key)
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  auto index_iter = m_index.find(key);
+  if (index_iter == m_index.end())
+  {
+    ++m_misses;
+    return { false, {} };
+  }
+  auto iter = index_iter->second;
+  if (m_ttl_ns > 0 && m_clock.GetTimestamp() > iter->m_deadline)
+  {
+    Erase(iter);
+    ++m_misses;
+    return { false, {} };
+  }
+  m_entries.splice(m_entries.begin(), m_entries, iter);
+  ++m_hits;
+  return { true, iter->m_reply };
+}
+
+void ReplyCache::Insert(const std::string& key, const sup::dto::AnyValue& reply)
+{
+  const auto bytes = key.size() + GetApproximateSize(reply);
+  if (m_max_bytes > 0 && bytes > m_max_bytes)
+  {
+    return;
+  }
+  const auto deadline = m_clock.GetTimestamp() + m_ttl_ns;
+  std::lock_guard<std::mutex> lk{m_mtx};
+  auto index_iter = m_index.find(key);
+  if (index_iter != m_index.end())
+  {
+    Erase(index_iter->second);
+  }
+  // Evict least recently used entries until the new one fits
+  while (!m_entries.empty() && (m_entries.size() >= m_max_entries ||
+                                (m_max_bytes > 0 && m_total_bytes + bytes > m_max_bytes)))
+  {
+    Erase(std::prev(m_entries.end()));
+  }
+  m_entries.push_front(Entry{ key, reply, bytes, deadline });
+  m_index[key] = m_entries.begin();
+  m_total_bytes += bytes;
+}
+
+std::size_t ReplyCache::GetSize() const
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  return m_entries.size();
+}
+
+std::size_t ReplyCache::GetTotalBytes() const
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  return m_total_bytes;
+}
+
+std::size_t ReplyCache::GetNumberOfHits() const
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  return m_hits;
+}
+
+std::size_t ReplyCache::GetNumberOfMisses() const
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  return m_misses;
+}
+
+void ReplyCache::Erase(EntryList::iterator iter)
+{
+  m_total_bytes -= iter->m_bytes;
+  (void)m_index.erase(iter->m_key);
+  (void)m_entries.erase(iter);
+}
+
+std::string GetReplyCacheKey(const sup::dto::AnyValue& input, PayloadEncoding encoding)
+{
+  auto binary = sup::dto::AnyValueToBinary(input);
+  std::string key(1, static_cast<char>(utils::EncodingToInteger(encoding)));
+  (void)key.append(binary.begin(), binary.end());
+  return key;
+}
+
+}  // namespace protocol
+
+}  // namespace sup
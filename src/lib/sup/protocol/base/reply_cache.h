@@ -0,0 +1,153 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_REPLY_CACHE_H_
+#define SUP_PROTOCOL_REPLY_CACHE_H_
+
+#include "clock.h"
+
+#include <sup/protocol/protocol_rpc.h>
+
+#include <sup/dto/anyvalue.h>
+#include <sup/dto/basic_scalar_types.h>
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Cache of encoded reply packets, keyed on the (decoded) input of the call that produced
+ * them.
+ *
+ * @details Entries expire after a fixed time to live. When adding an entry exceeds the maximum
+ * number of entries or the maximum total size, the least recently used entries are evicted. The
+ * size of an entry is estimated from its key and the leaf values of the reply packet.
+ *
+ * @note This class is threadsafe.
+ */
+class ReplyCache
+{
+public:
+  /**
+   * @brief Constructor that measures the time to live with the steady clock.
+   *
+   * @param max_entries Maximum number of entries (must be larger than zero).
+   * @param max_bytes Maximum total size of the entries in bytes. Zero means unlimited.
+   * @param ttl_sec Time to live of each entry in seconds. Zero means entries do not expire.
+   */
+  ReplyCache(std::size_t max_entries, std::size_t max_bytes, double ttl_sec);
+
+  /**
+   * @brief Constructor.
+   *
+   * @param max_entries Maximum number of entries (must be larger than zero).
+   * @param max_bytes Maximum total size of the entries in bytes. Zero means unlimited.
+   * @param ttl_sec Time to live of each entry in seconds. Zero means entries do not expire.
+   * @param clock Clock for the time to live. It needs to outlive this object.
+   */
+  ReplyCache(std::size_t max_entries, std::size_t max_bytes, double ttl_sec, const Clock& clock);
+  ~ReplyCache();
+
+  ReplyCache(const ReplyCache& other) = delete;
+  ReplyCache& operator=(const ReplyCache& other) = delete;
+  ReplyCache(ReplyCache&&) = delete;
+  ReplyCache& operator=(ReplyCache&&) = delete;
+
+  /**
+   * @brief Look up the reply for the given key. A found entry becomes the most recently used one.
+   * Each call counts as either a hit or a miss.
+   *
+   * @param key Cache key (see GetReplyCacheKey).
+   * @return The first member indicates if a valid entry was found and, if so, the second member
+   * contains its reply packet.
+   */
+  std::pair<bool, sup::dto::AnyValue> Find(const std::string& key);
+
+  /**
+   * @brief Add or replace the reply for the given key. An entry that is larger than the maximum
+   * total size is not added.
+   *
+   * @param key Cache key (see GetReplyCacheKey).
+   * @param reply Reply packet to cache.
+   */
+  void Insert(const std::string& key, const sup::dto::AnyValue& reply);
+
+  /**
+   * @brief Get the number of entries, including expired entries that were not evicted yet.
+   *
+   * @return Number of entries.
+   */
+  std::size_t GetSize() const;
+
+  /**
+   * @brief Get the approximate total size of the entries.
+   *
+   * @return Total size in bytes.
+   */
+  std::size_t GetTotalBytes() const;
+
+  std::size_t GetNumberOfHits() const;
+
+  std::size_t GetNumberOfMisses() const;
+
+private:
+  struct Entry
+  {
+    std::string m_key;
+    sup::dto::AnyValue m_reply;
+    std::size_t m_bytes;
+    sup::dto::uint64 m_deadline;
+  };
+  using EntryList = std::list<Entry>;
+  void Erase(EntryList::iterator iter);
+  const std::size_t m_max_entries;
+  const std::size_t m_max_bytes;
+  const sup::dto::uint64 m_ttl_ns;
+  const Clock& m_clock;
+  mutable std::mutex m_mtx;
+  // Ordered from most to least recently used
+  EntryList m_entries;
+  std::unordered_map<std::string, EntryList::iterator> m_index;
+  std::size_t m_total_bytes;
+  std::size_t m_hits;
+  std::size_t m_misses;
+};
+
+/**
+ * @brief Create a cache key for the given input and the encoding of its reply.
+ *
+ * @param input Decoded input of the call.
+ * @param encoding Encoding of the cached reply packet.
+ * @return Cache key.
+ */
+std::string GetReplyCacheKey(const sup::dto::AnyValue& input, PayloadEncoding encoding);
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_REPLY_CACHE_H_
@@ -0,0 +1,170 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "reply_spill_store.h"
+
+#include <sup/protocol/exceptions.h>
+
+#include <sup/dto/anyvalue_helper.h>
+
+#include <cerrno>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+const std::string kScratchFileTemplate = "sup-protocol-reply-XXXXXX";
+
+bool WriteAll(int fd, const sup::dto::uint8* data, std::size_t size);
+}  // unnamed namespace
+
+namespace sup
+{
+namespace protocol
+{
+
+SpilledValue::SpilledValue(const sup::dto::AnyValue& value, const std::string& directory)
+  : m_data{nullptr}
+  , m_size{0}
+{
+  auto binary = sup::dto::AnyValueToBinary(value);
+  m_size = binary.size();
+  std::string path = directory + "/" + kScratchFileTemplate;
+  std::vector<char> path_buffer(path.begin(), path.end());
+  path_buffer.push_back('\0');
+  const int fd = ::mkstemp(path_buffer.data());
+  if (fd < 0)
+  {
+    const std::string error = "SpilledValue(): could not create scratch file in " + directory;
+    throw InvalidOperationException(error);
+  }
+  // Nobody else needs to open the file: it is removed as soon as it is unmapped and closed
+  (void)::unlink(path_buffer.data());
+  // Writing through a mapping would raise SIGBUS when the file system is full
+  if (!WriteAll(fd, binary.data(), m_size))
+  {
+    (void)::close(fd);
+    throw InvalidOperationException("SpilledValue(): could not write scratch file");
+  }
+  // Zero sized mappings are not allowed
+  if (m_size > 0)
+  {
+    m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  (void)::close(fd);
+  if (m_data == MAP_FAILED)
+  {
+    m_data = nullptr;
+    throw InvalidOperationException("SpilledValue(): could not map scratch file");
+  }
+}
+
+SpilledValue::~SpilledValue()
+{
+  Release();
+}
+
+std::size_t SpilledValue::GetSize() const
+{
+  return m_size;
+}
+
+sup::dto::AnyValue SpilledValue::Load() const
+{
+  const auto begin = static_cast<const sup::dto::uint8*>(m_data);
+  const std::vector<sup::dto::uint8> binary(begin, begin + m_size);
+  return sup::dto::AnyValueFromBinary(binary);
+}
+
+void SpilledValue::Release()
+{
+  if (m_data != nullptr)
+  {
+    (void)::munmap(m_data, m_size);
+    m_data = nullptr;
+  }
+}
+
+ReplySpillStore::ReplySpillStore(std::size_t threshold, const std::string& directory)
+  : m_threshold{threshold}
+  , m_directory{directory}
+  , m_spilled_values{0}
+{
+  if (m_directory.empty())
+  {
+    throw InvalidOperationException("ReplySpillStore(): no spill directory provided");
+  }
+}
+
+ReplySpillStore::~ReplySpillStore() = default;
+
+bool ReplySpillStore::ShouldSpill(std::size_t reply_size) const
+{
+  return reply_size > m_threshold;
+}
+
+std::unique_ptr<SpilledValue> ReplySpillStore::Spill(const sup::dto::AnyValue& value)
+{
+  std::unique_ptr<SpilledValue> result;
+  try
+  {
+    result = std::make_unique<SpilledValue>(value, m_directory);
+  }
+  catch(const std::exception&)
+  {
+    return {};
+  }
+  ++m_spilled_values;
+  return result;
+}
+
+std::size_t ReplySpillStore::GetNumberOfSpilledValues() const
+{
+  return m_spilled_values.load();
+}
+
+}  // namespace protocol
+
+}  // namespace sup
+
+namespace
+{
+bool WriteAll(int fd, const sup::dto::uint8* data, std::size_t size)
+{
+  std::size_t written = 0;
+  while (written < size)
+  {
+    const auto result = ::pwrite(fd, data + written, size - written,
+                                 static_cast<off_t>(written));
+    if (result < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (result <= 0)
+    {
+      return false;
+    }
+    written += static_cast<std::size_t>(result);
+  }
+  return true;
+}
+}  // unnamed namespace
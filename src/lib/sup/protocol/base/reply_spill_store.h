@@ -0,0 +1,143 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_REPLY_SPILL_STORE_H_
+#define SUP_PROTOCOL_REPLY_SPILL_STORE_H_
+
+#include <sup/dto/anyvalue.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Binary serialization of an AnyValue, kept in a memory mapped scratch file instead of on
+ * the heap.
+ *
+ * @details The scratch file is unlinked right after its creation, so it disappears together with
+ * this object, even when the application does not shut down cleanly. The value is written with
+ * regular file I/O, so a full file system results in an error instead of a signal, and only then
+ * mapped read-only. The file descriptor is closed right after mapping: the mapping keeps the file
+ * alive and spilled values do not consume file descriptors.
+ */
+class SpilledValue
+{
+public:
+  /**
+   * @brief Constructor.
+   *
+   * @param value Value to serialize into the scratch file.
+   * @param directory Directory in which to create the scratch file.
+   *
+   * @throws InvalidOperationException when the scratch file could not be created, written or
+   * mapped.
+   */
+  SpilledValue(const sup::dto::AnyValue& value, const std::string& directory);
+  ~SpilledValue();
+
+  SpilledValue(const SpilledValue& other) = delete;
+  SpilledValue& operator=(const SpilledValue& other) = delete;
+  SpilledValue(SpilledValue&&) = delete;
+  SpilledValue& operator=(SpilledValue&&) = delete;
+
+  /**
+   * @brief Get the size of the serialized value in the scratch file.
+   *
+   * @return Size in bytes.
+   */
+  std::size_t GetSize() const;
+
+  /**
+   * @brief Deserialize the value from the mapping.
+   *
+   * @return Copy of the spilled value.
+   */
+  sup::dto::AnyValue Load() const;
+
+private:
+  void Release();
+  void* m_data;
+  std::size_t m_size;
+};
+
+/**
+ * @brief Policy for moving large replies of asynchronous requests out of memory until they are
+ * retrieved.
+ *
+ * @note This class is threadsafe.
+ */
+class ReplySpillStore
+{
+public:
+  /**
+   * @brief Constructor.
+   *
+   * @param threshold Replies with an approximate size above this number of bytes are spilled.
+   * @param directory Directory for the scratch files.
+   * @throw InvalidOperationException when the directory is empty.
+   */
+  ReplySpillStore(std::size_t threshold, const std::string& directory);
+  ~ReplySpillStore();
+
+  ReplySpillStore(const ReplySpillStore& other) = delete;
+  ReplySpillStore& operator=(const ReplySpillStore& other) = delete;
+  ReplySpillStore(ReplySpillStore&&) = delete;
+  ReplySpillStore& operator=(ReplySpillStore&&) = delete;
+
+  /**
+   * @brief Check if a reply of the given size needs to be spilled.
+   *
+   * @param reply_size Approximate size of the reply in bytes (see GetApproximateSize).
+   * @return true if the reply should be spilled.
+   */
+  bool ShouldSpill(std::size_t reply_size) const;
+
+  /**
+   * @brief Spill the given value to a new scratch file.
+   *
+   * @param value Value to spill.
+   * @return Spilled value or an empty pointer if spilling failed, e.g. because the disk is full.
+   * The caller then needs to keep the value in memory.
+   */
+  std::unique_ptr<SpilledValue> Spill(const sup::dto::AnyValue& value);
+
+  /**
+   * @brief Get the number of values that were successfully spilled. This counter only increases.
+   *
+   * @return Number of spilled values.
+   */
+  std::size_t GetNumberOfSpilledValues() const;
+
+private:
+  const std::size_t m_threshold;
+  const std::string m_directory;
+  std::atomic<std::size_t> m_spilled_values;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_REPLY_SPILL_STORE_H_
@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "slab_pool.h"
+
+#include <sup/protocol/exceptions.h>
+
+#include <new>
+
+namespace sup
+{
+namespace protocol
+{
+namespace
+{
+std::size_t GetSizeClass(std::size_t size);
+void* AllocateUnpooled(std::size_t size, std::size_t alignment);
+void DeallocateUnpooled(void* ptr, std::size_t alignment) noexcept;
+}  // unnamed namespace
+
+SlabPool::SlabPool(std::size_t blocks_per_slab)
+  : m_blocks_per_slab{blocks_per_slab}
+  , m_free_lists{}
+  , m_slabs{}
+  , m_blocks_in_use{0}
+  , m_mtx{}
+{
+  if (blocks_per_slab == 0)
+  {
+    throw InvalidOperationException(
+      "SlabPool(): number of blocks per slab must be larger than zero");
+  }
+}
+
+SlabPool::~SlabPool()
+{
+  for (auto slab : m_slabs)
+  {
+    ::operator delete(slab);
+  }
+}
+
+void* SlabPool::Allocate(std::size_t size, std::size_t alignment)
+{
+  if (!IsPooled(size, alignment))
+  {
+    return AllocateUnpooled(size, alignment);
+  }
+  const auto size_class = GetSizeClass(size);
+  std::lock_guard<std::mutex> lk{m_mtx};
+  if (m_free_lists[size_class] == nullptr)
+  {
+    AllocateSlab(size_class);
+  }
+  auto block = m_free_lists[size_class];
+  m_free_lists[size_class] = block->m_next;
+  ++m_blocks_in_use;
+  return block;
+}
+
+void SlabPool::Deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept
+{
+  if (ptr == nullptr)
+  {
+    return;
+  }
+  if (!IsPooled(size, alignment))
+  {
+    DeallocateUnpooled(ptr, alignment);
+    return;
+  }
+  const auto size_class = GetSizeClass(size);
+  auto block = static_cast<FreeBlock*>(ptr);
+  std::lock_guard<std::mutex> lk{m_mtx};
+  block->m_next = m_free_lists[size_class];
+  m_free_lists[size_class] = block;
+  --m_blocks_in_use;
+}
+
+std::size_t SlabPool::GetNumberOfSlabs() const
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  return m_slabs.size();
+}
+
+std::size_t SlabPool::GetNumberOfBlocksInUse() const
+{
+  return m_blocks_in_use.load();
+}
+
+bool SlabPool::IsPooled(std::size_t size, std::size_t alignment)
+{
+  return size > 0 && size <= kMaxSlabBlockSize && alignment <= kSlabBlockGranularity;
+}
+
+void SlabPool::AllocateSlab(std::size_t size_class)
+{
+  const auto block_size = (size_class + 1) * kSlabBlockGranularity;
+  auto slab = static_cast<unsigned char*>(::operator new(block_size * m_blocks_per_slab));
+  try
+  {
+    m_slabs.push_back(slab);
+  }
+  catch(...)
+  {
+    ::operator delete(slab);
+    throw;
+  }
+  // Thread the new blocks onto the (empty) free list, keeping them in address order
+  FreeBlock* next = nullptr;
+  for (std::size_t idx = m_blocks_per_slab; idx > 0; --idx)
+  {
+    auto block = reinterpret_cast<FreeBlock*>(slab + (idx - 1) * block_size);
+    block->m_next = next;
+    next = block;
+  }
+  m_free_lists[size_class] = next;
+}
+
+namespace
+{
+std::size_t GetSizeClass(std::size_t size)
+{
+  return (size - 1) / SlabPool::kSlabBlockGranularity;
+}
+
+void* AllocateUnpooled(std::size_t size, std::size_t alignment)
+{
+  if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+  {
+    return ::operator new(size, std::align_val_t{alignment});
+  }
+  return ::operator new(size);
+}
+
+void DeallocateUnpooled(void* ptr, std::size_t alignment) noexcept
+{
+  if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+  {
+    ::operator delete(ptr, std::align_val_t{alignment});
+    return;
+  }
+  ::operator delete(ptr);
+}
+}  // unnamed namespace
+
+}  // namespace protocol
+
+}  // namespace sup
@@ -0,0 +1,186 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_SLAB_POOL_H_
+#define SUP_PROTOCOL_SLAB_POOL_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Thread safe pool of small memory blocks that are reused after deallocation.
+ *
+ * @details Blocks are grouped in size classes that are multiples of kSlabBlockGranularity bytes.
+ * Each size class keeps a free list of blocks and, when it runs empty, carves a new slab with a
+ * fixed number of blocks out of a single allocation. In steady state, allocating and
+ * deallocating blocks therefore does not touch the heap. Requests that are larger than
+ * kMaxSlabBlockSize or need a stronger alignment than kSlabBlockGranularity are forwarded to the
+ * global operator new and delete.
+ *
+ * @note The memory of the slabs is only released when the pool is destroyed, so the pool retains
+ * the memory needed at peak usage.
+ */
+class SlabPool
+{
+public:
+  /**
+   * @brief Constructor.
+   *
+   * @param blocks_per_slab Number of blocks allocated at once when a size class runs empty.
+   *
+   * @throws InvalidOperationException when the number of blocks per slab is zero.
+   */
+  explicit SlabPool(std::size_t blocks_per_slab);
+  ~SlabPool();
+
+  SlabPool(const SlabPool& other) = delete;
+  SlabPool& operator=(const SlabPool& other) = delete;
+  SlabPool(SlabPool&&) = delete;
+  SlabPool& operator=(SlabPool&&) = delete;
+
+  /**
+   * @brief Allocate a block of memory.
+   *
+   * @param size Size of the block in bytes.
+   * @param alignment Required alignment of the block.
+   * @return Pointer to the block.
+   *
+   * @throws std::bad_alloc when no memory could be allocated.
+   */
+  void* Allocate(std::size_t size, std::size_t alignment);
+
+  /**
+   * @brief Return a block of memory to the pool.
+   *
+   * @param ptr Pointer to the block, as returned by Allocate.
+   * @param size Size of the block in bytes, as passed to Allocate.
+   * @param alignment Alignment of the block, as passed to Allocate.
+   */
+  void Deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept;
+
+  /**
+   * @brief Get the number of slabs allocated by the pool so far.
+   */
+  std::size_t GetNumberOfSlabs() const;
+
+  /**
+   * @brief Get the number of blocks that were allocated from the pool and not returned yet.
+   */
+  std::size_t GetNumberOfBlocksInUse() const;
+
+  static constexpr std::size_t kSlabBlockGranularity = alignof(std::max_align_t);
+  static constexpr std::size_t kMaxSlabBlockSize = 1024;
+
+private:
+  struct FreeBlock
+  {
+    FreeBlock* m_next;
+  };
+  static constexpr std::size_t kNumberOfSizeClasses = kMaxSlabBlockSize / kSlabBlockGranularity;
+  static bool IsPooled(std::size_t size, std::size_t alignment);
+  void AllocateSlab(std::size_t size_class);
+
+  const std::size_t m_blocks_per_slab;
+  std::array<FreeBlock*, kNumberOfSizeClasses> m_free_lists;
+  std::vector<void*> m_slabs;
+  std::atomic<std::size_t> m_blocks_in_use;
+  mutable std::mutex m_mtx;
+};
+
+/**
+ * @brief Standard allocator that takes its memory from a shared SlabPool. Each copy (also when
+ * rebound to another type) keeps the pool alive, so containers and shared pointers created with it
+ * can safely outlive the original owner of the pool. A default constructed allocator, i.e.
+ * without pool, uses the global operator new and delete.
+ */
+template <typename T>
+class PoolAllocator
+{
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  PoolAllocator() noexcept = default;
+
+  explicit PoolAllocator(std::shared_ptr<SlabPool> pool) noexcept
+    : m_pool{std::move(pool)}
+  {}
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>& other) noexcept
+    : m_pool{other.GetPool()}
+  {}
+
+  T* allocate(std::size_t n)
+  {
+    if (!m_pool)
+    {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T*>(m_pool->Allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, std::size_t n) noexcept
+  {
+    if (!m_pool)
+    {
+      ::operator delete(ptr);
+      return;
+    }
+    m_pool->Deallocate(ptr, n * sizeof(T), alignof(T));
+  }
+
+  const std::shared_ptr<SlabPool>& GetPool() const noexcept
+  {
+    return m_pool;
+  }
+
+private:
+  std::shared_ptr<SlabPool> m_pool;
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>& left, const PoolAllocator<U>& right) noexcept
+{
+  return left.GetPool() == right.GetPool();
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>& left, const PoolAllocator<U>& right) noexcept
+{
+  return !(left == right);
+}
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_SLAB_POOL_H_
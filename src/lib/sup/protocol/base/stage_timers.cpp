@@ -0,0 +1,117 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "stage_timers.h"
+
+#include "clock.h"
+
+namespace
+{
+const std::size_t kNumberOfEncodings = 2;
+}  // unnamed namespace
+
+namespace sup
+{
+namespace protocol
+{
+
+StageTimers::StageTimers(std::size_t n_stages)
+  : m_n_stages{n_stages}
+  , m_histograms(n_stages * kNumberOfEncodings)
+{}
+
+StageTimers::~StageTimers() = default;
+
+void StageTimers::Record(std::size_t stage, PayloadEncoding encoding,
+                         sup::dto::uint64 latency_ns)
+{
+  const auto idx = GetIndex(stage, encoding);
+  if (idx < m_histograms.size())
+  {
+    m_histograms[idx].Record(latency_ns);
+  }
+}
+
+LatencyDistribution StageTimers::GetSnapshot(std::size_t stage, PayloadEncoding encoding) const
+{
+  const auto idx = GetIndex(stage, encoding);
+  if (idx >= m_histograms.size())
+  {
+    return {};
+  }
+  return m_histograms[idx].GetSnapshot();
+}
+
+void StageTimers::Reset()
+{
+  for (auto& histogram : m_histograms)
+  {
+    histogram.Reset();
+  }
+}
+
+std::size_t StageTimers::GetIndex(std::size_t stage, PayloadEncoding encoding) const
+{
+  const auto encoding_idx = static_cast<std::size_t>(encoding);
+  if (stage >= m_n_stages || encoding_idx >= kNumberOfEncodings)
+  {
+    return m_histograms.size();
+  }
+  return encoding_idx * m_n_stages + stage;
+}
+
+StageTimer::StageTimer(StageTimers* timers)
+  : m_timers{timers}
+  , m_stage_start{timers != nullptr ? GetSteadyClock().GetTimestamp() : 0}
+  , m_held_stages{}
+  , m_n_held_stages{0}
+{}
+
+StageTimer::~StageTimer() = default;
+
+void StageTimer::EndStage(std::size_t stage, PayloadEncoding encoding)
+{
+  const auto now = GetSteadyClock().GetTimestamp();
+  m_timers->Record(stage, encoding, now - m_stage_start);
+  m_stage_start = now;
+}
+
+void StageTimer::RecordHeldStages(PayloadEncoding encoding)
+{
+  for (std::size_t i = 0; i < m_n_held_stages; ++i)
+  {
+    m_timers->Record(m_held_stages[i].first, encoding, m_held_stages[i].second);
+  }
+  m_n_held_stages = 0;
+}
+
+void StageTimer::HoldStage(std::size_t stage)
+{
+  const auto now = GetSteadyClock().GetTimestamp();
+  if (m_n_held_stages < kMaxHeldStages)
+  {
+    m_held_stages[m_n_held_stages++] = { stage, now - m_stage_start };
+  }
+  m_stage_start = now;
+}
+
+}  // namespace protocol
+
+}  // namespace sup
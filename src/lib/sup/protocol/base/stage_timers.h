@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_STAGE_TIMERS_H_
+#define SUP_PROTOCOL_STAGE_TIMERS_H_
+
+#include "latency_histogram.h"
+
+#include <sup/protocol/latency_distribution.h>
+#include <sup/protocol/protocol_rpc.h>
+
+#include <sup/dto/basic_scalar_types.h>
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Latency histograms for a fixed number of consecutive stages, per payload encoding.
+ *
+ * @note This class is threadsafe.
+ */
+class StageTimers
+{
+public:
+  /**
+   * @brief Constructor.
+   *
+   * @param n_stages Number of stages.
+   */
+  explicit StageTimers(std::size_t n_stages);
+  ~StageTimers();
+
+  StageTimers(const StageTimers& other) = delete;
+  StageTimers& operator=(const StageTimers& other) = delete;
+  StageTimers(StageTimers&&) = delete;
+  StageTimers& operator=(StageTimers&&) = delete;
+
+  /**
+   * @brief Add the latency of a stage. Unknown stages or encodings are ignored.
+   *
+   * @param stage Index of the stage.
+   * @param encoding Payload encoding of the request.
+   * @param latency_ns Latency in nanoseconds.
+   */
+  void Record(std::size_t stage, PayloadEncoding encoding, sup::dto::uint64 latency_ns);
+
+  /**
+   * @brief Get a snapshot of the latencies of a stage.
+   *
+   * @param stage Index of the stage.
+   * @param encoding Payload encoding of the requests.
+   * @return Latency distribution (empty for unknown stages or encodings).
+   */
+  LatencyDistribution GetSnapshot(std::size_t stage, PayloadEncoding encoding) const;
+
+  /**
+   * @brief Remove all recorded latencies.
+   */
+  void Reset();
+
+private:
+  // Returns the number of histograms for unknown stages or encodings
+  std::size_t GetIndex(std::size_t stage, PayloadEncoding encoding) const;
+  const std::size_t m_n_stages;
+  std::vector<LatencyHistogram> m_histograms;
+};
+
+/**
+ * @brief Measures consecutive stages of a single call, each stage ending where the previous one
+ * ended. When constructed without timers, it does not even read the clock.
+ *
+ * Stages can also be held until it is known whether the call needs to be timed at all: these are
+ * only recorded by RecordHeldStages() and dropped otherwise.
+ */
+class StageTimer
+{
+public:
+  /**
+   * @brief Constructor that starts the first stage.
+   *
+   * @param timers Histograms to record into or nullptr to disable timing.
+   */
+  explicit StageTimer(StageTimers* timers);
+  ~StageTimer();
+
+  StageTimer(const StageTimer& other) = delete;
+  StageTimer& operator=(const StageTimer& other) = delete;
+  StageTimer(StageTimer&&) = delete;
+  StageTimer& operator=(StageTimer&&) = delete;
+
+  /**
+   * @brief End the current stage, record its latency and start the next stage.
+   *
+   * @param stage Stage that ended.
+   * @param encoding Payload encoding of the call.
+   */
+  template <typename Stage>
+  void EndStage(Stage stage, PayloadEncoding encoding)
+  {
+    if (m_timers != nullptr)
+    {
+      EndStage(static_cast<std::size_t>(stage), encoding);
+    }
+  }
+
+  /**
+   * @brief End the current stage and start the next stage, but keep the latency of the ended stage
+   * until RecordHeldStages() is called. Stages beyond kMaxHeldStages are dropped.
+   *
+   * @param stage Stage that ended.
+   */
+  template <typename Stage>
+  void HoldStage(Stage stage)
+  {
+    if (m_timers != nullptr)
+    {
+      HoldStage(static_cast<std::size_t>(stage));
+    }
+  }
+
+  /**
+   * @brief Record the latencies of the held stages.
+   *
+   * @param encoding Payload encoding of the call.
+   */
+  void RecordHeldStages(PayloadEncoding encoding);
+
+  static constexpr std::size_t kMaxHeldStages = 4;
+
+private:
+  void EndStage(std::size_t stage, PayloadEncoding encoding);
+  void HoldStage(std::size_t stage);
+  StageTimers* m_timers;
+  sup::dto::uint64 m_stage_start;
+  std::array<std::pair<std::size_t, sup::dto::uint64>, kMaxHeldStages> m_held_stages;
+  std::size_t m_n_held_stages;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_STAGE_TIMERS_H_
@@ -20,7 +20,8 @@
 
 #include "timing_utils.h"
 
-#include <chrono>
+#include "clock.h"
+
 #include <cmath>
 
 namespace sup
@@ -32,9 +33,7 @@ namespace utils
 
 sup::dto::uint64 GetCurrentTimestamp()
 {
-  auto now = std::chrono::system_clock::now();
-  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
-  return static_cast<sup::dto::uint64>(ns);
+  return GetSteadyClock().GetTimestamp();
 }
 
 sup::dto::uint64 ToNanoseconds(double seconds)
@@ -29,6 +29,11 @@ namespace protocol
 {
 namespace utils
 {
+/**
+ * @brief Get the current timestamp of the steady clock (see GetSteadyClock()).
+ *
+ * @return Timestamp in nanoseconds.
+ */
 sup::dto::uint64 GetCurrentTimestamp();
 
 sup::dto::uint64 ToNanoseconds(double seconds);
@@ -0,0 +1,186 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "work_stealing_pool.h"
+
+#include <sup/protocol/exceptions.h>
+
+#include <utility>
+
+namespace
+{
+struct WorkerIdentity
+{
+  const void* m_pool;
+  std::size_t m_idx;
+};
+
+// Identifies the pool and queue index of the current thread, if it is a worker thread
+thread_local WorkerIdentity tl_worker_identity{nullptr, 0};
+}  // unnamed namespace
+
+namespace sup
+{
+namespace protocol
+{
+
+WorkStealingPool::WorkStealingPool(std::size_t n_threads)
+  : m_queues{}
+  , m_next_queue{0}
+  , m_pending{0}
+  , m_sleeping{0}
+  , m_halt{false}
+  , m_sleep_mtx{}
+  , m_sleep_cv{}
+  , m_threads{}
+{
+  if (n_threads == 0)
+  {
+    throw InvalidOperationException(
+      "WorkStealingPool(): number of threads must be larger than zero");
+  }
+  for (std::size_t idx = 0; idx < n_threads; ++idx)
+  {
+    m_queues.push_back(std::make_unique<WorkerQueue>());
+  }
+  m_threads.reserve(n_threads);
+  for (std::size_t idx = 0; idx < n_threads; ++idx)
+  {
+    m_threads.emplace_back(&WorkStealingPool::RunWorker, this, idx);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+  {
+    std::lock_guard<std::mutex> lk{m_sleep_mtx};
+    m_halt = true;
+  }
+  m_sleep_cv.notify_all();
+  for (auto& thread : m_threads)
+  {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::Submit(Task task)
+{
+  std::size_t idx = 0;
+  if (tl_worker_identity.m_pool == this)
+  {
+    idx = tl_worker_identity.m_idx;
+  }
+  else
+  {
+    idx = m_next_queue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+  }
+  // Increment the pending count first, so it never underflows when the task is taken immediately
+  ++m_pending;
+  {
+    auto& queue = *m_queues[idx];
+    std::lock_guard<std::mutex> lk{queue.m_mtx};
+    queue.m_tasks.push_back(std::move(task));
+  }
+  // Only touch the shared mutex when a worker may be sleeping
+  if (m_sleeping > 0)
+  {
+    {
+      std::lock_guard<std::mutex> lk{m_sleep_mtx};
+    }
+    m_sleep_cv.notify_one();
+  }
+}
+
+std::size_t WorkStealingPool::GetNumberOfThreads() const
+{
+  return m_threads.size();
+}
+
+void WorkStealingPool::RunWorker(std::size_t idx)
+{
+  tl_worker_identity = WorkerIdentity{this, idx};
+  while (true)
+  {
+    Task task{};
+    if (TryPopOwnTask(idx, task) || TryStealTask(idx, task))
+    {
+      --m_pending;
+      try
+      {
+        task();
+      }
+      catch(...)
+      {
+        // Tasks are not supposed to throw: ignore to keep the worker alive.
+      }
+      continue;
+    }
+    // Only stop when all submitted tasks were handled
+    if (m_halt && m_pending == 0)
+    {
+      return;
+    }
+    WaitForTasks();
+  }
+}
+
+bool WorkStealingPool::TryPopOwnTask(std::size_t idx, Task& task)
+{
+  auto& queue = *m_queues[idx];
+  std::lock_guard<std::mutex> lk{queue.m_mtx};
+  if (queue.m_tasks.empty())
+  {
+    return false;
+  }
+  task = std::move(queue.m_tasks.front());
+  queue.m_tasks.pop_front();
+  return true;
+}
+
+bool WorkStealingPool::TryStealTask(std::size_t idx, Task& task)
+{
+  const auto n_queues = m_queues.size();
+  for (std::size_t offset = 1; offset < n_queues; ++offset)
+  {
+    auto& queue = *m_queues[(idx + offset) % n_queues];
+    std::unique_lock<std::mutex> lk{queue.m_mtx, std::try_to_lock};
+    if (!lk.owns_lock() || queue.m_tasks.empty())
+    {
+      continue;
+    }
+    // Steal from the opposite end of the owner
+    task = std::move(queue.m_tasks.back());
+    queue.m_tasks.pop_back();
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::WaitForTasks()
+{
+  std::unique_lock<std::mutex> lk{m_sleep_mtx};
+  ++m_sleeping;
+  m_sleep_cv.wait(lk, [this](){ return m_halt || m_pending > 0; });
+  --m_sleeping;
+}
+
+}  // namespace protocol
+
+}  // namespace sup
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_WORK_STEALING_POOL_H_
+#define SUP_PROTOCOL_WORK_STEALING_POOL_H_
+
+#include <sup/protocol/async_executor.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Executor with a fixed number of worker threads, each owning its own task queue. Idle
+ * workers steal tasks from the queues of the other workers.
+ *
+ * @details Tasks submitted from outside the pool are distributed round-robin over the worker
+ * queues, while tasks submitted from a worker thread are put on that worker's own queue. Compared
+ * to WorkerPool, this avoids a single queue (and mutex) that is shared between all submitting and
+ * executing threads.
+ *
+ * @note On destruction, all tasks that were already submitted are still executed before the
+ * worker threads are joined.
+ */
+class WorkStealingPool : public AsyncExecutor
+{
+public:
+  /**
+   * @brief Constructor that immediately launches all worker threads.
+   *
+   * @param n_threads Number of worker threads.
+   * @throw InvalidOperationException when the number of threads is zero.
+   */
+  explicit WorkStealingPool(std::size_t n_threads);
+  ~WorkStealingPool() override;
+
+  void Submit(Task task) override;
+
+  /**
+   * @brief Retrieve the number of worker threads.
+   *
+   * @return Number of worker threads.
+   */
+  std::size_t GetNumberOfThreads() const;
+
+private:
+  struct WorkerQueue
+  {
+    std::mutex m_mtx;
+    std::deque<Task> m_tasks;
+  };
+  void RunWorker(std::size_t idx);
+  bool TryPopOwnTask(std::size_t idx, Task& task);
+  bool TryStealTask(std::size_t idx, Task& task);
+  void WaitForTasks();
+  std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+  std::atomic<std::size_t> m_next_queue;
+  std::atomic<std::size_t> m_pending;
+  std::atomic<std::size_t> m_sleeping;
+  std::atomic<bool> m_halt;
+  std::mutex m_sleep_mtx;
+  std::condition_variable m_sleep_cv;
+  std::vector<std::thread> m_threads;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_WORK_STEALING_POOL_H_
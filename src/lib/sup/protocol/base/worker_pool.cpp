@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "worker_pool.h"
+
+#include <sup/protocol/exceptions.h>
+
+#include <utility>
+
+namespace sup
+{
+namespace protocol
+{
+
+WorkerPool::WorkerPool(std::size_t n_threads)
+  : m_tasks{}
+  , m_halt{false}
+  , m_mtx{}
+  , m_cv{}
+  , m_threads{}
+{
+  if (n_threads == 0)
+  {
+    throw InvalidOperationException("WorkerPool(): number of threads must be larger than zero");
+  }
+  m_threads.reserve(n_threads);
+  for (std::size_t idx = 0; idx < n_threads; ++idx)
+  {
+    m_threads.emplace_back(&WorkerPool::RunWorker, this);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    m_halt = true;
+  }
+  m_cv.notify_all();
+  for (auto& thread : m_threads)
+  {
+    thread.join();
+  }
+}
+
+void WorkerPool::Submit(Task task)
+{
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    m_tasks.push_back(std::move(task));
+  }
+  m_cv.notify_one();
+}
+
+std::size_t WorkerPool::GetNumberOfThreads() const
+{
+  return m_threads.size();
+}
+
+void WorkerPool::RunWorker()
+{
+  while (true)
+  {
+    Task task{};
+    {
+      std::unique_lock<std::mutex> lk{m_mtx};
+      m_cv.wait(lk, [this](){ return m_halt || !m_tasks.empty(); });
+      // Only stop when all submitted tasks were handled
+      if (m_tasks.empty())
+      {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    try
+    {
+      task();
+    }
+    catch(...)
+    {
+      // Tasks are not supposed to throw: ignore to keep the worker alive.
+    }
+  }
+}
+
+ThreadPerTaskExecutor::ThreadPerTaskExecutor() = default;
+
+ThreadPerTaskExecutor::~ThreadPerTaskExecutor() = default;
+
+void ThreadPerTaskExecutor::Submit(Task task)
+{
+  auto func = [task = std::move(task)]() {
+    try
+    {
+      task();
+    }
+    catch(...)
+    {
+      // Tasks are not supposed to throw: ignore to avoid terminating the application.
+    }
+  };
+  std::thread{func}.detach();
+}
+
+}  // namespace protocol
+
+}  // namespace sup
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_WORKER_POOL_H_
+#define SUP_PROTOCOL_WORKER_POOL_H_
+
+#include <sup/protocol/async_executor.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Executor with a fixed number of worker threads that take their tasks from a single
+ * shared queue.
+ *
+ * @note On destruction, all tasks that were already submitted are still executed before the
+ * worker threads are joined.
+ */
+class WorkerPool : public AsyncExecutor
+{
+public:
+  /**
+   * @brief Constructor that immediately launches all worker threads.
+   *
+   * @param n_threads Number of worker threads.
+   * @throw InvalidOperationException when the number of threads is zero.
+   */
+  explicit WorkerPool(std::size_t n_threads);
+  ~WorkerPool() override;
+
+  void Submit(Task task) override;
+
+  /**
+   * @brief Retrieve the number of worker threads.
+   *
+   * @return Number of worker threads.
+   */
+  std::size_t GetNumberOfThreads() const;
+
+private:
+  void RunWorker();
+  std::deque<Task> m_tasks;
+  bool m_halt;
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::vector<std::thread> m_threads;
+};
+
+/**
+ * @brief Executor that launches a new detached thread for each submitted task.
+ */
+class ThreadPerTaskExecutor : public AsyncExecutor
+{
+public:
+  ThreadPerTaskExecutor();
+  ~ThreadPerTaskExecutor() override;
+
+  void Submit(Task task) override;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_WORKER_POOL_H_
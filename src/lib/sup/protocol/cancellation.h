@@ -0,0 +1,45 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_CANCELLATION_H_
+#define SUP_PROTOCOL_CANCELLATION_H_
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Check if the asynchronous request that is being handled on the current thread was
+ * cancelled, i.e. the client invalidated it or it expired.
+ *
+ * @details Since nobody will use the reply of a cancelled request, long running implementations
+ * of Protocol::Invoke can check this regularly and return early to free the thread (and memory)
+ * for other requests. The returned result of such a call is ignored.
+ *
+ * @return true if the current asynchronous request was cancelled. Always false when not called
+ * from within Protocol::Invoke for an asynchronous request.
+ */
+bool IsInvocationCancelled();
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_CANCELLATION_H_
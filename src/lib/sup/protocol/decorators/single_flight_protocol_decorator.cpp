@@ -0,0 +1,175 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/single_flight_protocol_decorator.h>
+
+#include <sup/protocol/cancellation.h>
+
+#include <sup/dto/anyvalue.h>
+#include <sup/dto/anyvalue_helper.h>
+
+#include <exception>
+#include <utility>
+
+namespace sup
+{
+namespace protocol
+{
+
+struct SingleFlightProtocolDecorator::FlightResult
+{
+  ProtocolResult m_result;
+  sup::dto::AnyValue m_output;
+};
+
+SingleFlightProtocolDecorator::SingleFlightProtocolDecorator(Protocol& protocol)
+  : SingleFlightProtocolDecorator(protocol, {})
+{}
+
+SingleFlightProtocolDecorator::SingleFlightProtocolDecorator(Protocol& protocol,
+                                                             CoalescePredicate coalescable)
+  : m_protocol{protocol}
+  , m_coalescable{std::move(coalescable)}
+  , m_mtx{}
+  , m_flights{}
+  , m_coalesced_calls{0}
+  , m_leading_calls{0}
+{}
+
+SingleFlightProtocolDecorator::~SingleFlightProtocolDecorator() = default;
+
+ProtocolResult SingleFlightProtocolDecorator::Invoke(const sup::dto::AnyValue& input,
+                                                     sup::dto::AnyValue& output)
+{
+  if (!IsCoalescable(input))
+  {
+    return m_protocol.Invoke(input, output);
+  }
+  const auto binary = sup::dto::AnyValueToBinary(input);
+  const std::string key(binary.begin(), binary.end());
+  while (true)
+  {
+    FlightPromise promise{};
+    Flight flight{};
+    {
+      std::lock_guard<std::mutex> lk{m_mtx};
+      auto iter = m_flights.find(key);
+      if (iter == m_flights.end())
+      {
+        (void)m_flights.emplace(key, promise.get_future().share());
+      }
+      else
+      {
+        flight = iter->second;
+      }
+    }
+    if (!flight.valid())
+    {
+      return Lead(key, promise, input, output);
+    }
+    // Rethrows when the leader threw
+    auto flight_result = flight.get();
+    if (flight_result)
+    {
+      ++m_coalesced_calls;
+      output = flight_result->m_output;
+      return flight_result->m_result;
+    }
+    // The leader was cancelled: try again
+  }
+}
+
+ProtocolResult SingleFlightProtocolDecorator::Service(const sup::dto::AnyValue& input,
+                                                      sup::dto::AnyValue& output)
+{
+  return m_protocol.Service(input, output);
+}
+
+std::size_t SingleFlightProtocolDecorator::GetNumberOfCoalescedCalls() const
+{
+  return m_coalesced_calls.load();
+}
+
+std::size_t SingleFlightProtocolDecorator::GetNumberOfLeadingCalls() const
+{
+  return m_leading_calls.load();
+}
+
+std::size_t SingleFlightProtocolDecorator::GetNumberOfCallsInFlight() const
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  return m_flights.size();
+}
+
+bool SingleFlightProtocolDecorator::IsCoalescable(const sup::dto::AnyValue& input) const
+{
+  if (!m_coalescable)
+  {
+    return true;
+  }
+  try
+  {
+    return m_coalescable(input);
+  }
+  catch(...)
+  {
+    return false;
+  }
+}
+
+ProtocolResult SingleFlightProtocolDecorator::Lead(const std::string& key, FlightPromise& promise,
+                                                   const sup::dto::AnyValue& input,
+                                                   sup::dto::AnyValue& output)
+{
+  ++m_leading_calls;
+  ProtocolResult result = Success;
+  try
+  {
+    result = m_protocol.Invoke(input, output);
+  }
+  catch(...)
+  {
+    Land(key);
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+  // Calls that join from now on start a new flight, since this one may already be outdated
+  Land(key);
+  if (IsInvocationCancelled())
+  {
+    // The output of a cancelled call is not meaningful: let the waiting calls retry
+    promise.set_value(nullptr);
+  }
+  else
+  {
+    promise.set_value(std::make_shared<const FlightResult>(FlightResult{ result, output }));
+  }
+  return result;
+}
+
+void SingleFlightProtocolDecorator::Land(const std::string& key)
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  (void)m_flights.erase(key);
+}
+
+}  // namespace protocol
+
+}  // namespace sup
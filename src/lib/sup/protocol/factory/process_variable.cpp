@@ -76,7 +76,7 @@ bool WaitForVariableValue(ProcessVariable& var, const sup::dto::AnyValue& value,
   auto pred = [&result]() {
     return result;
   };
-  auto finish = std::chrono::system_clock::now() + std::chrono::duration<double>(timeout_sec);
+  auto finish = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout_sec);
   while (true)
   {
     std::unique_lock<std::mutex> lk(mtx);
@@ -42,12 +42,12 @@ void TryFetchVariable(const ProcessVariable& var, sup::dto::AnyValue& output)
 bool BusyWaitForValue(const ProcessVariable& var, const sup::dto::AnyValue& expected_value,
                       double timeout_sec)
 {
-  auto end_time = std::chrono::system_clock::now() + std::chrono::duration<double>(timeout_sec);
+  auto end_time = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout_sec);
   sup::dto::AnyValue current;
   TryFetchVariable(var, current);
   while (current != expected_value)
   {
-    if (std::chrono::system_clock::now() > end_time)
+    if (std::chrono::steady_clock::now() > end_time)
     {
       return false;
     }
@@ -0,0 +1,152 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_LATENCY_DISTRIBUTION_H_
+#define SUP_PROTOCOL_LATENCY_DISTRIBUTION_H_
+
+#include <sup/dto/basic_scalar_types.h>
+
+#include <vector>
+
+namespace sup
+{
+namespace protocol
+{
+/**
+ * @brief Snapshot of a latency histogram.
+ *
+ * @details Latencies are counted in logarithmic buckets, each power of two being split in 16
+ * linear sub-buckets. Percentiles are thus accurate to about 6% of their value, over the whole
+ * range of latencies.
+ */
+class LatencyDistribution
+{
+public:
+  /**
+   * @brief Construct an empty distribution.
+   */
+  LatencyDistribution();
+
+  /**
+   * @brief Constructor.
+   *
+   * @param bucket_counts Number of latencies in each bucket.
+   * @param total_ns Sum of all latencies in nanoseconds.
+   * @param min_ns Smallest latency in nanoseconds.
+   * @param max_ns Largest latency in nanoseconds.
+   */
+  LatencyDistribution(std::vector<sup::dto::uint64> bucket_counts, sup::dto::uint64 total_ns,
+                      sup::dto::uint64 min_ns, sup::dto::uint64 max_ns);
+  ~LatencyDistribution();
+
+  LatencyDistribution(const LatencyDistribution& other);
+  LatencyDistribution& operator=(const LatencyDistribution& other) &;
+  LatencyDistribution(LatencyDistribution&&) noexcept;
+  LatencyDistribution& operator=(LatencyDistribution&&) & noexcept;
+
+  /**
+   * @brief Get the number of recorded latencies.
+   *
+   * @return Number of latencies.
+   */
+  sup::dto::uint64 GetCount() const;
+
+  /**
+   * @brief Get the average latency.
+   *
+   * @return Average latency in seconds (zero when empty).
+   */
+  double GetMean() const;
+
+  /**
+   * @brief Get the smallest recorded latency.
+   *
+   * @return Smallest latency in seconds (zero when empty).
+   */
+  double GetMinimum() const;
+
+  /**
+   * @brief Get the largest recorded latency.
+   *
+   * @return Largest latency in seconds (zero when empty).
+   */
+  double GetMaximum() const;
+
+  /**
+   * @brief Get the latency below which the given fraction of the recorded latencies falls.
+   *
+   * @param fraction Fraction between zero and one, e.g. 0.99 for the 99th percentile.
+   * @return Latency in seconds (zero when empty).
+   */
+  double GetPercentile(double fraction) const;
+
+private:
+  std::vector<sup::dto::uint64> m_bucket_counts;
+  sup::dto::uint64 m_count;
+  sup::dto::uint64 m_total_ns;
+  sup::dto::uint64 m_min_ns;
+  sup::dto::uint64 m_max_ns;
+};
+
+/**
+ * @brief Latency distributions of the stages in the lifecycle of asynchronous requests.
+ *
+ * @details Each distribution only contains the requests that reached the end of its stage:
+ *   - Queue time: from accepting the request until its call to Protocol::Invoke started;
+ *   - Execution time: from the start until the end of the call to Protocol::Invoke;
+ *   - Poll delay: from the end of the call until a poll first found the reply ready;
+ *   - Fetch time: from the end of the call until the reply was retrieved.
+ */
+struct AsyncLatencyStatistics
+{
+  LatencyDistribution m_queue_time;
+  LatencyDistribution m_execution_time;
+  LatencyDistribution m_poll_delay;
+  LatencyDistribution m_fetch_time;
+};
+
+/**
+ * @brief Stages of handling a synchronous request in ProtocolRPCServer.
+ */
+enum class RPCServerStage : sup::dto::uint32
+{
+  kEncodingDetection = 0,  // Find the payload encoding of the request
+  kRequestCheck,           // Check the format of the request
+  kPayloadDecoding,        // Extract and decode the payload of the request
+  kInvoke,                 // Protocol::Invoke
+  kReplyEncoding           // Create the reply and encode its payload
+};
+
+/**
+ * @brief Stages of a synchronous call in ProtocolRPCClient.
+ */
+enum class RPCClientStage : sup::dto::uint32
+{
+  kRequestEncoding = 0,    // Create the request and encode its payload
+  kTransport,              // Call the underlying RPC client
+  kReplyCheck,             // Check the format and extract the result of the reply
+  kPayloadDecoding         // Extract and decode the payload of the reply into the output
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_LATENCY_DISTRIBUTION_H_
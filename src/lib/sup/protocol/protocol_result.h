@@ -261,6 +261,17 @@ extern const ProtocolResult ClientTransportException;
  * @brief Error when an asynchronous request times out.
 */
 extern const ProtocolResult AsynchronousProtocolTimeout;
+/**
+ * @brief Error when the Protocol server rejects a new asynchronous request because it reached its
+ * limit of active or retained requests. Clients may retry the request later.
+*/
+extern const ProtocolResult ServerBusy;
+
+/**
+ * @brief Error when the Protocol server dropped the reply of an asynchronous request before it was
+ * retrieved, because the replies it retained exceeded its memory budget.
+*/
+extern const ProtocolResult AsynchronousReplyEvicted;
 
 }  // namespace protocol
 
@@ -40,17 +40,32 @@ namespace constants
  * - async: (uint32) specifies a command for asynchronous RPC calls
  * - id: (uint64) provides the identification of a specific asynchronous RPC call
  * - ready: (bool) provides the readiness of the reply for a specific asynchronous RPC call
+ * - priority: (uint32) optional scheduling priority of a new asynchronous RPC call
+ * - wait: (float64) optional time in seconds the server may hold a poll until the reply is ready
+ * - max_wait: (float64) maximum time in seconds the server will hold a poll (only present when
+ *             the server supports waiting polls)
+ * - inline: (bool) optional flag in a poll to ask the server to include a ready reply
+ * - key: (string) optional idempotency key of a new asynchronous RPC call, chosen by the client
+ * - retry_after: (float64) optional delay in seconds the server suggests before the next poll,
+ *                based on the completion time of similar requests
 */
 const std::string ENCODING_FIELD_NAME = "encoding";
 const std::string ASYNC_COMMAND_FIELD_NAME = "async";
 const std::string ASYNC_ID_FIELD_NAME = "id";
 const std::string ASYNC_READY_FIELD_NAME = "ready";
+const std::string ASYNC_PRIORITY_FIELD_NAME = "priority";
+const std::string ASYNC_WAIT_FIELD_NAME = "wait";
+const std::string ASYNC_MAX_WAIT_FIELD_NAME = "max_wait";
+const std::string ASYNC_INLINE_REPLY_FIELD_NAME = "inline";
+const std::string ASYNC_KEY_FIELD_NAME = "key";
+const std::string ASYNC_RETRY_AFTER_FIELD_NAME = "retry_after";
 
 /**
  * An RPC request is a structured AnyValue with two fields:
  * - timestamp: a 64bit unsigned integer (obsolete)
  * - encoding: specifies how the payload is encoded (optional: default is no encoding)
  * - async: specifies a command for asynchronous RPC calls
+ * - priority: specifies the priority of a new asynchronous RPC call (optional: default is normal)
  * - query: a generic AnyValue that contains the payload of the request
  * Obsolete fields need to have the correct type when present.
 */
@@ -126,6 +141,17 @@ enum class AsyncCommand : sup::dto::uint32
   kInvalidate
 };
 
+/**
+ * Priority of an asynchronous request. When the server cannot run all asynchronous requests at
+ * the same time, requests with a higher priority are started first.
+*/
+enum class AsyncPriority : sup::dto::uint32
+{
+  kLow = 0u,
+  kNormal,
+  kHigh
+};
+
 namespace utils
 {
 sup::dto::int32 EncodingToInteger(PayloadEncoding encoding);
@@ -152,8 +178,37 @@ sup::dto::AnyValue CreateRPCRequest(const sup::dto::AnyValue& payload, PayloadEn
 sup::dto::AnyValue CreateAsyncRPCRequest(const sup::dto::AnyValue& payload,
                                          PayloadEncoding encoding);
 
+sup::dto::AnyValue CreateAsyncRPCRequest(const sup::dto::AnyValue& payload,
+                                         PayloadEncoding encoding, AsyncPriority priority);
+
+/**
+ * Create a new asynchronous request with an idempotency key. When the client sends the request
+ * again with the same key (e.g. because the reply was lost), the server returns the identifier of
+ * the request it already started instead of starting it again. The key field is omitted when the
+ * key is empty.
+*/
+sup::dto::AnyValue CreateAsyncRPCRequest(const sup::dto::AnyValue& payload,
+                                         PayloadEncoding encoding, AsyncPriority priority,
+                                         const std::string& key);
+
 sup::dto::AnyValue CreateAsyncRPCPoll(sup::dto::uint64 id, PayloadEncoding encoding);
 
+/**
+ * Create a poll request that allows the server to hold the reply until the asynchronous request
+ * is ready or the given time has passed. The wait field is omitted when wait_sec is not positive.
+*/
+sup::dto::AnyValue CreateAsyncRPCPoll(sup::dto::uint64 id, PayloadEncoding encoding,
+                                      double wait_sec);
+
+/**
+ * Create a poll request that can be held by the server (see above) and optionally asks the
+ * server to include the reply when it is ready. Including the reply retires the request on the
+ * server, just like retrieving it separately. Servers that do not support this ignore the request
+ * and the reply then needs to be retrieved separately.
+*/
+sup::dto::AnyValue CreateAsyncRPCPoll(sup::dto::uint64 id, PayloadEncoding encoding,
+                                      double wait_sec, bool inline_reply);
+
 sup::dto::AnyValue CreateAsyncRPCGetReply(sup::dto::uint64 id, PayloadEncoding encoding);
 
 sup::dto::AnyValue CreateAsyncRPCInvalidate(sup::dto::uint64 id, PayloadEncoding encoding);
@@ -174,8 +229,38 @@ sup::dto::AnyValue CreateAsyncRPCReply(const sup::protocol::ProtocolResult& resu
 
 sup::dto::AnyValue CreateAsyncRPCNewRequestReply(sup::dto::uint64 id, PayloadEncoding encoding);
 
+/**
+ * Create the reply to a new asynchronous request, advertising the maximum time the server will
+ * hold a poll. The max_wait field is omitted when max_wait_sec is not positive.
+*/
+sup::dto::AnyValue CreateAsyncRPCNewRequestReply(sup::dto::uint64 id, PayloadEncoding encoding,
+                                                 double max_wait_sec);
+
+/**
+ * Create the reply to a new asynchronous request, advertising the maximum time the server will
+ * hold a poll and suggesting a delay before the first poll. The max_wait and retry_after fields
+ * are omitted when the corresponding time is not positive.
+*/
+sup::dto::AnyValue CreateAsyncRPCNewRequestReply(sup::dto::uint64 id, PayloadEncoding encoding,
+                                                 double max_wait_sec, double retry_after_sec);
+
 sup::dto::AnyValue CreateAsyncRPCPollReply(bool is_ready, PayloadEncoding encoding);
 
+/**
+ * Create a poll reply that suggests a delay before the next poll. The retry_after field is omitted
+ * when retry_after_sec is not positive.
+*/
+sup::dto::AnyValue CreateAsyncRPCPollReply(bool is_ready, PayloadEncoding encoding,
+                                           double retry_after_sec);
+
+/**
+ * Create a poll reply for a ready request that includes the result and (optional) payload of
+ * the reply. The server no longer retains the request after sending this reply.
+*/
+sup::dto::AnyValue CreateAsyncRPCPollReply(const sup::protocol::ProtocolResult& result,
+                                           const sup::dto::AnyValue& payload,
+                                           PayloadEncoding encoding);
+
 bool CheckServiceRequest(const sup::dto::AnyValue& request);
 
 bool CheckServiceReplyFormat(const sup::dto::AnyValue& reply);
@@ -226,6 +311,32 @@ std::pair<bool, PayloadEncoding> TryGetPacketEncoding(const sup::dto::AnyValue&
 
 std::pair<bool, AsyncCommand> GetAsyncInfo(const sup::dto::AnyValue& packet);
 
+/**
+ * Get the priority of an asynchronous request packet. Returns AsyncPriority::kNormal when the
+ * priority field is missing or does not contain a known priority.
+*/
+AsyncPriority GetAsyncPriority(const sup::dto::AnyValue& packet);
+
+/**
+ * Get the idempotency key of an asynchronous request packet. Returns an empty string when the key
+ * field is missing or is not a string.
+*/
+std::string GetAsyncRequestKey(const sup::dto::AnyValue& packet);
+
+/**
+ * Get the maximum time in seconds the server will hold a poll, as advertised in the reply to a
+ * new asynchronous request. Returns zero when the server does not support waiting polls or the
+ * field could not be decoded.
+*/
+double GetAsyncMaxPollWait(const sup::dto::AnyValue& packet, PayloadEncoding encoding);
+
+/**
+ * Get the delay in seconds the server suggests before the next poll, as included in the reply to
+ * a new asynchronous request or to a poll. Returns zero when the server gave no suggestion or the
+ * field could not be decoded.
+*/
+double GetAsyncRetryAfter(const sup::dto::AnyValue& packet, PayloadEncoding encoding);
+
 }  // namespace utils
 
 }  // namespace protocol
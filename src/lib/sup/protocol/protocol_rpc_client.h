@@ -23,16 +23,20 @@
 
 #include <sup/dto/any_functor.h>
 #include <sup/dto/basic_scalar_types.h>
+#include <sup/protocol/latency_distribution.h>
 #include <sup/protocol/protocol.h>
 #include <sup/protocol/protocol_rpc.h>
 #include <sup/protocol/protocol_rpc_client_config.h>
 
+#include <memory>
 #include <tuple>
 
 namespace sup
 {
 namespace protocol
 {
+class StageTimers;
+
 /**
  * @brief The ProtocolRPCClient is a Protocol implementation that forwards to an AnyFunctor.
  *
@@ -60,11 +64,26 @@ public:
 
   ProtocolResult Service(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override;
 
+  /**
+   * @brief Get the latencies of a stage of synchronous calls with the given payload encoding.
+   *
+   * @param stage Stage of a call.
+   * @param encoding Payload encoding of the calls.
+   * @return Latency distribution (empty when stage timing is disabled).
+   */
+  LatencyDistribution GetStageLatency(RPCClientStage stage, PayloadEncoding encoding) const;
+
+  /**
+   * @brief Clear the latencies of all stages of synchronous calls.
+   */
+  void ResetStageLatencies();
+
 private:
   ProtocolResult HandleSyncInvoke(const sup::dto::AnyValue& input, sup::dto::AnyValue& output);
   ProtocolResult HandleAsyncInvoke(const sup::dto::AnyValue& input, sup::dto::AnyValue& output);
   sup::dto::AnyFunctor& m_any_functor;
   ProtocolRPCClientConfig m_config;
+  std::unique_ptr<StageTimers> m_stage_timers;
 };
 
 }  // namespace protocol
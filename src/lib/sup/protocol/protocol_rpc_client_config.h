@@ -23,6 +23,8 @@
 
 #include <sup/protocol/protocol_rpc.h>
 
+#include <cstddef>
+
 namespace sup
 {
 namespace protocol
@@ -33,7 +35,11 @@ namespace protocol
  * @details The configuration includes:
  *   - The optional encoding to be applied to the payload (none or base64);
  *   - Whether or not the underlying RPC communication will be dealt with asynchronously;
- *   - In case of asynchrounous communication: the total timeout and polling interval in seconds.
+ *   - In case of asynchrounous communication: the total timeout and polling interval in seconds
+ *     (the client follows the delay before the next poll when the server suggests one), the
+ *     priority of the requests (normal by default) and the number of times a lost initial request
+ *     is sent again;
+ *   - Whether the stages of synchronous calls are timed (disabled by default).
  */
 struct ProtocolRPCClientConfig
 {
@@ -72,6 +78,23 @@ public:
   bool m_async;
   double m_timeout_sec;
   double m_polling_interval_sec;
+  AsyncPriority m_priority;
+
+  /**
+   * @brief Number of times the initial request of an asynchronous call is sent again, within the
+   * timeout, when sending it failed with ClientTransportException (e.g. because the reply got
+   * lost). The request then carries an idempotency key that is unique for the call, so the server
+   * returns the request it already started instead of starting it again. Servers that do not
+   * support idempotency keys may run the call more than once: set this to zero for such servers
+   * when calls are not idempotent.
+   */
+  std::size_t m_start_retries;
+
+  /**
+   * @brief Time the stages of each synchronous call (see RPCClientStage) and aggregate them per
+   * stage and payload encoding. This reads a steady clock once per stage.
+   */
+  bool m_stage_timing;
 };
 
 bool ValidateProtocolRPCClientConfig(const ProtocolRPCClientConfig& cfg);
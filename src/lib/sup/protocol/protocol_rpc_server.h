@@ -21,6 +21,7 @@
 #ifndef SUP_PROTOCOL_PROTOCOL_RPC_SERVER_H_
 #define SUP_PROTOCOL_PROTOCOL_RPC_SERVER_H_
 
+#include <sup/protocol/latency_distribution.h>
 #include <sup/protocol/protocol_rpc_server_config.h>
 #include <sup/protocol/protocol_rpc.h>
 #include <sup/protocol/protocol.h>
@@ -28,12 +29,19 @@
 #include <sup/dto/any_functor.h>
 #include <sup/dto/basic_scalar_types.h>
 
+#include <cstddef>
+#include <memory>
+
 namespace sup
 {
 namespace protocol
 {
 class AsyncInvokeServer;
+class ExpirationReaper;
 class ExpirationTimeoutHandler;
+class ReplyCache;
+class StageTimer;
+class StageTimers;
 
 /**
  * @brief The ProtocolRPCServer is an AnyFunctor implementation that forwards to a Protocol.
@@ -57,14 +65,104 @@ public:
   ProtocolRPCServer& operator=(ProtocolRPCServer&&) = delete;
 
   sup::dto::AnyValue operator()(const sup::dto::AnyValue& input) override;
+
+  /**
+   * @brief Get the number of asynchronous requests that were abandoned, i.e. invalidated or
+   * expired before their reply was retrieved.
+   *
+   * @return Number of abandoned requests.
+   */
+  std::size_t GetNumberOfAbandonedRequests() const;
+
+  /**
+   * @brief Get the approximate memory held by replies of asynchronous requests that are ready,
+   * but not retrieved yet.
+   *
+   * @return Approximate size in bytes of the retained replies.
+   */
+  std::size_t GetRetainedReplySize() const;
+
+  /**
+   * @brief Get the number of replies of asynchronous requests that were evicted to stay within the
+   * configured memory budget.
+   *
+   * @return Number of evicted replies.
+   */
+  std::size_t GetNumberOfEvictedReplies() const;
+
+  /**
+   * @brief Get the number of replies of asynchronous requests that were spilled to a scratch file.
+   *
+   * @return Number of spilled replies.
+   */
+  std::size_t GetNumberOfSpilledReplies() const;
+
+  /**
+   * @brief Get a snapshot of the latency histograms of the lifecycle stages of asynchronous
+   * requests (queued, executing and waiting to be retrieved), for the requests that finished since
+   * construction or the last reset.
+   *
+   * @return Latency statistics.
+   */
+  AsyncLatencyStatistics GetAsyncLatencyStatistics() const;
+
+  /**
+   * @brief Clear the latency histograms of asynchronous requests, e.g. after taking a snapshot.
+   */
+  void ResetAsyncLatencyStatistics();
+
+  /**
+   * @brief Get the number of requests that were answered from the reply cache.
+   *
+   * @return Number of cache hits (zero when the cache is disabled).
+   */
+  std::size_t GetReplyCacheHits() const;
+
+  /**
+   * @brief Get the number of requests with a cacheable input that were not found in the reply
+   * cache.
+   *
+   * @return Number of cache misses (zero when the cache is disabled).
+   */
+  std::size_t GetReplyCacheMisses() const;
+
+  /**
+   * @brief Get the number of service queries that were answered with a precomputed constant reply.
+   *
+   * @return Number of precomputed service replies that were returned.
+   */
+  std::size_t GetConstantServiceReplyHits() const;
+
+  /**
+   * @brief Get the latencies of a stage of handling synchronous requests with the given payload
+   * encoding.
+   *
+   * @param stage Stage of handling a request.
+   * @param encoding Payload encoding of the requests.
+   * @return Latency distribution (empty when stage timing is disabled).
+   */
+  LatencyDistribution GetStageLatency(RPCServerStage stage, PayloadEncoding encoding) const;
+
+  /**
+   * @brief Clear the latencies of all stages of handling synchronous requests.
+   */
+  void ResetStageLatencies();
 private:
   sup::dto::AnyValue HandleInvokeRequest(const sup::dto::AnyValue& request,
-                                         PayloadEncoding encoding);
+                                         PayloadEncoding encoding, StageTimer& timer);
   sup::dto::AnyValue HandleServiceRequest(const sup::dto::AnyValue& request,
                                           PayloadEncoding encoding);
+  bool IsCacheable(const sup::dto::AnyValue& payload) const;
+  bool IsConstantService(const sup::dto::AnyValue& payload) const;
   Protocol& m_protocol;
   std::unique_ptr<AsyncInvokeServer> m_async_server;
   std::unique_ptr<ExpirationTimeoutHandler> m_expiration_handler;
+  std::unique_ptr<ExpirationReaper> m_reaper;
+  std::unique_ptr<ReplyCache> m_reply_cache;
+  CacheablePredicate m_cacheable;
+  std::unique_ptr<ReplyCache> m_service_cache;
+  ConstantServicePredicate m_constant_service;
+  std::unique_ptr<StageTimers> m_stage_timers;
 };
 
 }  // namespace protocol
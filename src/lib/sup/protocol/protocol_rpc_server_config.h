@@ -21,15 +21,66 @@
 #ifndef SUP_PROTOCOL_PROTOCOL_RPC_SERVER_CONFIG_H_
 #define SUP_PROTOCOL_PROTOCOL_RPC_SERVER_CONFIG_H_
 
+#include <sup/protocol/async_executor.h>
+#include <sup/protocol/protocol_result.h>
+
+#include <sup/dto/anyvalue.h>
+#include <sup/dto/basic_scalar_types.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
 namespace sup
 {
 namespace protocol
 {
+/**
+ * @brief Callback that is called with the identifier and result of an asynchronous request as soon
+ * as its reply is ready.
+ */
+using AsyncCompletionCallback = std::function<void(sup::dto::uint64, const ProtocolResult&)>;
+
+/**
+ * @brief Predicate that indicates if the reply to the given (decoded) input can be cached, i.e.
+ * if calling Protocol::Invoke again with the same input returns the same output.
+ */
+using CacheablePredicate = std::function<bool(const sup::dto::AnyValue&)>;
+
+/**
+ * @brief Predicate that indicates if the reply to the given (decoded) service query never changes
+ * during the lifetime of the server, so it only needs to be computed once.
+ */
+using ConstantServicePredicate = std::function<bool(const sup::dto::AnyValue&)>;
+
 /**
  * @brief ProtocolRPCServerConfig contains the configuration information of the ProtocolRPCServer.
  *
  * @details The configuration includes:
- *   - The time in seconds for requests to expire (each poll will reset the timer)
+ *   - The time in seconds for requests to expire (each poll will reset the timer) and the clock to
+ *     measure it;
+ *   - How asynchronous requests are executed: an executor provided by the application, a fixed
+ *     size (optionally work-stealing) worker pool or a new thread for each request (default);
+ *   - Limits on the number of active and retained asynchronous requests and on the memory held by
+ *     replies that were not retrieved yet (unlimited by default);
+ *   - Whether the bookkeeping of asynchronous requests is allocated from a pool (disabled by
+ *     default);
+ *   - Whether large replies are spilled to scratch files until they are retrieved (disabled by
+ *     default);
+ *   - Whether expired requests are cleaned up by a background thread (by default, they are cleaned
+ *     up while handling incoming requests);
+ *   - The maximum time a poll can be held until the reply is ready (disabled by default);
+ *   - The time a new request waits for its reply, to answer it directly when it finishes quickly
+ *     (disabled by default);
+ *   - Whether replies to new requests and polls suggest when to poll next, based on the completion
+ *     time of earlier requests (disabled by default);
+ *   - An optional callback to notify the transport layer when an asynchronous request completes;
+ *   - An optional cache for the replies to inputs that are marked as cacheable (disabled by
+ *     default);
+ *   - Which service queries have a constant reply that is computed and encoded only once (none
+ *     by default);
+ *   - Whether the stages of handling synchronous requests are timed (disabled by default).
  */
 struct ProtocolRPCServerConfig
 {
@@ -55,6 +106,180 @@ public:
   ProtocolRPCServerConfig& operator=(ProtocolRPCServerConfig&&) & noexcept;
 
   double m_expiration_sec;
+
+  /**
+   * @brief Measure expiration with a coarse clock that is cheaper to read, but only has a
+   * resolution of a few milliseconds (CLOCK_MONOTONIC_COARSE where available). Disabled by default,
+   * meaning a steady clock with full resolution is used.
+   */
+  bool m_coarse_clock;
+
+  /**
+   * @brief Number of worker threads for executing asynchronous requests. When zero, a new thread
+   * is launched for each asynchronous request. This value is ignored when m_executor is set.
+   */
+  std::size_t m_worker_pool_size;
+
+  /**
+   * @brief Use per-worker queues with work stealing instead of a single shared queue for the
+   * worker pool. This value is only used when m_worker_pool_size is larger than zero.
+   */
+  bool m_work_stealing;
+
+  /**
+   * @brief Optional executor, provided by the application, for running asynchronous requests.
+   */
+  std::shared_ptr<AsyncExecutor> m_executor;
+
+  /**
+   * @brief Maximum number of times in a row that queued asynchronous requests of a lower priority
+   * can be passed over in favour of requests with a higher priority before they are run anyway.
+   */
+  std::size_t m_max_priority_skips;
+
+  /**
+   * @brief Maximum number of asynchronous requests whose call to Protocol::Invoke has not finished
+   * yet. New requests above this limit are rejected with ServerBusy. Zero means unlimited.
+   */
+  std::size_t m_max_active_requests;
+
+  /**
+   * @brief Maximum number of asynchronous requests retained by the server, i.e. still running or
+   * waiting for their reply to be retrieved. New requests above this limit are rejected with
+   * ServerBusy. Without background clean up (see m_cleanup_interval_sec), expired requests are
+   * first removed to make room. Zero means unlimited.
+   */
+  std::size_t m_max_retained_requests;
+
+  /**
+   * @brief Memory budget in bytes for the replies of asynchronous requests that are ready, but not
+   * retrieved yet (as estimated from their leaf values). When exceeded, the replies of the least
+   * recently accessed requests are dropped and retrieving them results in
+   * AsynchronousReplyEvicted. Zero means unlimited.
+   */
+  std::size_t m_max_retained_reply_bytes;
+
+  /**
+   * @brief Allocate the bookkeeping of asynchronous requests (table entries and completion state)
+   * from pools of reusable memory blocks instead of the heap. The values of the input and the
+   * reply still use the heap. This avoids part of the heap allocations per request under
+   * sustained load, but the pools keep the memory needed at peak load until the server is
+   * destroyed. Disabled by default.
+   */
+  bool m_pooled_requests;
+
+  /**
+   * @brief Replies of asynchronous requests with an approximate size above this number of bytes
+   * are serialized to a memory mapped scratch file until they are retrieved, keeping resident
+   * memory low for large outputs. Spilled replies do not count towards
+   * m_max_retained_reply_bytes. When spilling fails, the reply is kept in memory. Zero disables
+   * spilling.
+   */
+  std::size_t m_reply_spill_threshold;
+
+  /**
+   * @brief Directory for the scratch files of spilled replies. It is required when
+   * m_reply_spill_threshold is set: servers refuse to start without one.
+   *
+   * @note Choose a directory on a disk backed file system. On most systems /tmp is a tmpfs, which
+   * keeps spilled replies in memory (or swap) and defeats the purpose of spilling.
+   */
+  std::string m_reply_spill_directory;
+
+  /**
+   * @brief Interval in seconds for cleaning up expired requests on a dedicated background thread.
+   * When zero, the clean up is done while handling an incoming request, at most once every half
+   * expiration time.
+   */
+  double m_cleanup_interval_sec;
+
+  /**
+   * @brief Maximum time in seconds the server holds a poll until the reply is ready. This value is
+   * advertised to clients, which then need fewer polls and see the reply as soon as it is ready.
+   * Zero disables waiting polls.
+   *
+   * @note A held poll occupies the thread that calls the server, so this should only be enabled
+   * when the transport layer handles requests concurrently. It should also stay well below any
+   * timeout the transport imposes on single requests.
+   */
+  double m_max_poll_wait_sec;
+
+  /**
+   * @brief Time in seconds a new asynchronous request waits for its call to Protocol::Invoke to
+   * finish. When it finishes in time, the server answers with a normal synchronous reply and
+   * retires the request, saving the client a poll and a separate request to retrieve the reply.
+   * Otherwise, the identifier of the request is returned as usual. Zero disables this.
+   *
+   * @note As with held polls, the wait occupies the thread that calls the server, so this should
+   * stay small compared to the typical execution time of requests that need to run
+   * asynchronously.
+   */
+  double m_inline_grace_sec;
+
+  /**
+   * @brief Include a suggested delay before the next poll in the replies to new asynchronous
+   * requests and to polls for requests that are not ready. The server keeps a moving average of
+   * the completion time of requests per called function (the FUNCTION_FIELD_NAME member of the
+   * input, if present) and suggests the expected remaining time. Clients that do not support this
+   * ignore the suggestion. Disabled by default.
+   */
+  bool m_retry_after_hints;
+
+  /**
+   * @brief Optional callback that is called as soon as the reply of an asynchronous request is
+   * ready. Transport layers that can reach their clients can use this to push the reply, or a
+   * notification that it is ready, instead of having the clients poll. Requests that are answered
+   * within m_inline_grace_sec are not reported, since their clients never receive an identifier.
+   *
+   * @note The callback is called on the thread that executed the request and may call back into
+   * the server, e.g. to retrieve the reply. It can be called before the client received the
+   * identifier of its request. With an inline grace period, requests that finish during that
+   * period, but could not be answered inline, are reported on the thread that handled the initial
+   * request when the period is over. Exceptions thrown by the callback are ignored.
+   */
+  AsyncCompletionCallback m_completion_callback;
+
+  /**
+   * @brief Maximum number of cached replies. When larger than zero and m_cacheable is set,
+   * successful replies to cacheable inputs are cached, so that the same request is answered
+   * without calling Protocol::Invoke nor encoding the reply again. Least recently used replies are
+   * evicted first. Zero disables the cache.
+   */
+  std::size_t m_reply_cache_size;
+
+  /**
+   * @brief Maximum approximate total size in bytes of the cached replies. Zero means unlimited.
+   */
+  std::size_t m_reply_cache_bytes;
+
+  /**
+   * @brief Time in seconds a cached reply remains valid. Zero means cached replies do not expire.
+   */
+  double m_reply_cache_ttl_sec;
+
+  /**
+   * @brief Predicate that marks which inputs of Protocol::Invoke can be answered from the cache.
+   * Typically provided by the application protocol, since only it knows which calls are free of
+   * side effects. Inputs for which the predicate throws are not cached.
+   */
+  CacheablePredicate m_cacheable;
+
+  /**
+   * @brief Predicate that marks the queries of Protocol::Service with a constant reply. The first
+   * successful reply to such a query is kept as a fully encoded reply packet per query and payload
+   * encoding, and returned for all later equal queries without calling Protocol::Service. Use
+   * utils::IsApplicationProtocolRequestPayload to precompute the application protocol information,
+   * which clients typically request on every connection. Empty by default, meaning all queries are
+   * forwarded. Queries for which the predicate throws are not considered constant.
+   */
+  ConstantServicePredicate m_constant_service;
+
+  /**
+   * @brief Time the stages of handling each synchronous request (see RPCServerStage) and
+   * aggregate them per stage and payload encoding. This reads a steady clock once per stage.
+   * Asynchronous requests and requests answered from the reply cache are not timed.
+   */
+  bool m_stage_timing;
 };
 
 bool ValidateProtocolRPCServerConfig(const ProtocolRPCServerConfig& cfg);
@@ -0,0 +1,132 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#ifndef SUP_PROTOCOL_SINGLE_FLIGHT_PROTOCOL_DECORATOR_H_
+#define SUP_PROTOCOL_SINGLE_FLIGHT_PROTOCOL_DECORATOR_H_
+
+#include <sup/protocol/protocol.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace sup
+{
+namespace dto
+{
+class AnyValue;
+}  // namespace dto
+
+namespace protocol
+{
+/**
+ * @brief Protocol decorator that coalesces concurrent calls to Invoke with equal inputs.
+ *
+ * @details The first call with a given input (the leader) is forwarded to the decorated protocol.
+ * Calls with an equal input that arrive while the leader is still running do not call the
+ * decorated protocol, but wait for the leader and receive a copy of its result and output. Inputs
+ * are compared on their binary serialization, which is hashed for the lookup of the call in
+ * flight. Calls to Service are always forwarded.
+ *
+ * When the leader was an asynchronous request that got cancelled (see IsInvocationCancelled), its
+ * result is not shared and the waiting calls start a new call to the decorated protocol instead.
+ *
+ * @note Coalescing is only correct for inputs whose handling has no side effects, since calls
+ * that arrive at the same time are executed only once. Use the constructor with a predicate to
+ * restrict coalescing to those inputs.
+ */
+class SingleFlightProtocolDecorator : public Protocol
+{
+public:
+  /**
+   * @brief Predicate that indicates if calls with the given input can be coalesced.
+   */
+  using CoalescePredicate = std::function<bool(const sup::dto::AnyValue&)>;
+
+  /**
+   * @brief Constructor that coalesces all calls to Invoke with equal inputs.
+   *
+   * @param protocol Decorated protocol.
+   */
+  explicit SingleFlightProtocolDecorator(Protocol& protocol);
+
+  /**
+   * @brief Constructor that only coalesces calls to Invoke whose input satisfies the given
+   * predicate. Inputs for which the predicate throws are not coalesced.
+   *
+   * @param protocol Decorated protocol.
+   * @param coalescable Predicate that marks the inputs that can be coalesced.
+   */
+  SingleFlightProtocolDecorator(Protocol& protocol, CoalescePredicate coalescable);
+  ~SingleFlightProtocolDecorator() override;
+
+  ProtocolResult Invoke(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override;
+  ProtocolResult Service(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override;
+
+  /**
+   * @brief Get the number of calls to Invoke that were answered with the result of another call
+   * in flight, instead of calling the decorated protocol.
+   *
+   * @return Number of coalesced calls.
+   */
+  std::size_t GetNumberOfCoalescedCalls() const;
+
+  /**
+   * @brief Get the number of calls to Invoke with a coalescable input that were forwarded to the
+   * decorated protocol.
+   *
+   * @return Number of leading calls.
+   */
+  std::size_t GetNumberOfLeadingCalls() const;
+
+  /**
+   * @brief Get the number of calls to the decorated protocol that are currently in flight and can
+   * be joined.
+   *
+   * @return Number of calls in flight.
+   */
+  std::size_t GetNumberOfCallsInFlight() const;
+
+private:
+  struct FlightResult;
+  using FlightPromise = std::promise<std::shared_ptr<const FlightResult>>;
+  using Flight = std::shared_future<std::shared_ptr<const FlightResult>>;
+  bool IsCoalescable(const sup::dto::AnyValue& input) const;
+  ProtocolResult Lead(const std::string& key, FlightPromise& promise,
+                      const sup::dto::AnyValue& input, sup::dto::AnyValue& output);
+  void Land(const std::string& key);
+  Protocol& m_protocol;
+  CoalescePredicate m_coalescable;
+  mutable std::mutex m_mtx;
+  std::unordered_map<std::string, Flight> m_flights;
+  std::atomic<std::size_t> m_coalesced_calls;
+  std::atomic<std::size_t> m_leading_calls;
+};
+
+}  // namespace protocol
+
+}  // namespace sup
+
+#endif  // SUP_PROTOCOL_SINGLE_FLIGHT_PROTOCOL_DECORATOR_H_
@@ -0,0 +1,190 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/protocol.h>
+#include <sup/protocol/protocol_rpc.h>
+#include <sup/protocol/protocol_rpc_server.h>
+
+#include <sup/dto/anyvalue.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace sup::protocol;
+
+namespace
+{
+std::atomic<std::size_t> g_allocations{0};
+
+/**
+ * @brief Protocol that simulates a short call to Protocol::Invoke by echoing its input.
+ */
+class EchoProtocol : public Protocol
+{
+public:
+  EchoProtocol() = default;
+  ~EchoProtocol() override = default;
+
+  ProtocolResult Invoke(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override
+  {
+    output = input;
+    return Success;
+  }
+
+  ProtocolResult Service(const sup::dto::AnyValue&, sup::dto::AnyValue&) override
+  {
+    return Success;
+  }
+};
+
+struct AllocationCounts
+{
+  double m_warm_up;
+  double m_steady_state;
+};
+
+// Perform a full asynchronous call with a fixed number of round trips: the initial request and a
+// single long poll that includes the reply.
+bool AsyncCall(sup::dto::AnyFunctor& server, const sup::dto::AnyValue& request)
+{
+  auto reply = server(request);
+  auto id_info = utils::TryExtractReplyId(reply, PayloadEncoding::kNone);
+  if (!id_info.first)
+  {
+    return false;
+  }
+  auto poll_request = utils::CreateAsyncRPCPoll(id_info.second, PayloadEncoding::kNone, 1.0, true);
+  reply = server(poll_request);
+  auto result_info = utils::TryExtractProtocolResult(reply);
+  return result_info.first && result_info.second == Success
+         && reply.HasField(constants::REPLY_PAYLOAD);
+}
+
+// Measure the average number of heap allocations per asynchronous call, over all threads.
+double CountAllocations(sup::dto::AnyFunctor& server, const sup::dto::AnyValue& request,
+                        std::size_t n_calls)
+{
+  const auto start = g_allocations.load();
+  for (std::size_t i = 0; i < n_calls; ++i)
+  {
+    if (!AsyncCall(server, request))
+    {
+      std::cerr << "Asynchronous call failed" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+  const auto stop = g_allocations.load();
+  return static_cast<double>(stop - start) / static_cast<double>(n_calls);
+}
+
+AllocationCounts MeasureAllocations(bool pooled, std::size_t n_warm_up_calls,
+                                    std::size_t n_calls)
+{
+  EchoProtocol protocol{};
+  ProtocolRPCServerConfig config{};
+  config.m_executor = CreateWorkerPool(1);
+  config.m_max_poll_wait_sec = 1.0;
+  config.m_pooled_requests = pooled;
+  ProtocolRPCServer server{protocol, config};
+  const sup::dto::AnyValue payload{ sup::dto::UnsignedInteger32Type, 42u };
+  const auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kNone);
+  AllocationCounts result{};
+  result.m_warm_up = CountAllocations(server, request, n_warm_up_calls);
+  result.m_steady_state = CountAllocations(server, request, n_calls);
+  return result;
+}
+}  // unnamed namespace
+
+// Count all allocations made through the global operator new.
+void* operator new(std::size_t size)
+{
+  ++g_allocations;
+  if (auto ptr = std::malloc(size == 0 ? 1 : size))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+  return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+/**
+ * @brief Compare the number of heap allocations per asynchronous call with and without pooling of
+ * the request entries in the server. The difference between both is the part of the allocations
+ * that the pool removes in steady state; the remaining allocations belong to the values that are
+ * passed around (request and reply packets, the copied input and the output).
+ *
+ * Usage: allocation-benchmark [warm_up_calls] [calls]
+ */
+int main(int argc, char* argv[])
+{
+  std::size_t n_warm_up_calls = 100;
+  std::size_t n_calls = 10000;
+  if (argc > 1)
+  {
+    n_warm_up_calls = std::stoul(argv[1]);
+  }
+  if (argc > 2)
+  {
+    n_calls = std::stoul(argv[2]);
+  }
+  const auto heap = MeasureAllocations(false, n_warm_up_calls, n_calls);
+  const auto pooled = MeasureAllocations(true, n_warm_up_calls, n_calls);
+  std::cout << "Heap allocations per asynchronous call (" << n_warm_up_calls
+            << " warm up calls, " << n_calls << " calls)" << std::endl;
+  std::cout << std::setw(16) << "" << std::setw(12) << "warm up" << std::setw(16)
+            << "steady state" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(16) << "heap" << std::setw(12) << heap.m_warm_up << std::setw(16)
+            << heap.m_steady_state << std::endl;
+  std::cout << std::setw(16) << "pooled" << std::setw(12) << pooled.m_warm_up << std::setw(16)
+            << pooled.m_steady_state << std::endl;
+  std::cout << "Allocations per call saved by the pool in steady state: "
+            << heap.m_steady_state - pooled.m_steady_state << std::endl;
+  return EXIT_SUCCESS;
+}
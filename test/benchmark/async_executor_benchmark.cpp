@@ -0,0 +1,176 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/async_executor.h>
+#include <sup/protocol/protocol.h>
+#include <sup/protocol/protocol_rpc.h>
+#include <sup/protocol/protocol_rpc_server.h>
+
+#include <sup/dto/anyvalue.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sup::protocol;
+
+namespace
+{
+/**
+ * @brief Protocol that simulates a short call to Protocol::Invoke by echoing its input.
+ */
+class EchoProtocol : public Protocol
+{
+public:
+  EchoProtocol() = default;
+  ~EchoProtocol() override = default;
+
+  ProtocolResult Invoke(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override
+  {
+    output = input;
+    return Success;
+  }
+
+  ProtocolResult Service(const sup::dto::AnyValue&, sup::dto::AnyValue&) override
+  {
+    return Success;
+  }
+};
+
+struct ExecutorSetup
+{
+  std::string m_name;
+  std::function<std::shared_ptr<AsyncExecutor>()> m_create;
+};
+
+sup::dto::uint64 ExtractId(const sup::dto::AnyValue& reply)
+{
+  auto id_info = utils::TryExtractReplyId(reply, PayloadEncoding::kNone);
+  return id_info.first ? id_info.second : 0;
+}
+
+bool ExtractReady(const sup::dto::AnyValue& reply)
+{
+  auto ready_info = utils::TryExtractReadyStatus(reply, PayloadEncoding::kNone);
+  return ready_info.first && ready_info.second;
+}
+
+// Perform a full asynchronous call: initial request, polling until ready and retrieving the reply.
+bool AsyncCall(sup::dto::AnyFunctor& server, const sup::dto::AnyValue& request)
+{
+  auto id = ExtractId(server(request));
+  if (id == 0)
+  {
+    return false;
+  }
+  const auto poll_request = utils::CreateAsyncRPCPoll(id, PayloadEncoding::kNone);
+  while (!ExtractReady(server(poll_request)))
+  {
+    std::this_thread::yield();
+  }
+  auto reply = server(utils::CreateAsyncRPCGetReply(id, PayloadEncoding::kNone));
+  auto result_info = utils::TryExtractProtocolResult(reply);
+  return result_info.first && result_info.second == Success;
+}
+
+double MeasureThroughput(const ExecutorSetup& setup, std::size_t n_clients,
+                         std::size_t n_calls_per_client)
+{
+  EchoProtocol protocol{};
+  ProtocolRPCServerConfig config{};
+  config.m_executor = setup.m_create();
+  ProtocolRPCServer server{protocol, config};
+  const sup::dto::AnyValue payload{ sup::dto::UnsignedInteger32Type, 42u };
+  const auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kNone);
+  std::vector<std::thread> clients;
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < n_clients; ++i)
+  {
+    clients.emplace_back([&server, &request, n_calls_per_client](){
+      for (std::size_t j = 0; j < n_calls_per_client; ++j)
+      {
+        if (!AsyncCall(server, request))
+        {
+          std::cerr << "Asynchronous call failed" << std::endl;
+          std::exit(EXIT_FAILURE);
+        }
+      }
+    });
+  }
+  for (auto& client : clients)
+  {
+    client.join();
+  }
+  auto stop = std::chrono::steady_clock::now();
+  auto seconds = std::chrono::duration<double>(stop - start).count();
+  return static_cast<double>(n_clients * n_calls_per_client) / seconds;
+}
+}  // unnamed namespace
+
+/**
+ * @brief Compare the throughput of asynchronous calls for the different executors, as the number
+ * of concurrent clients grows.
+ *
+ * Usage: executor-benchmark [max_clients] [calls_per_client]
+ */
+int main(int argc, char* argv[])
+{
+  std::size_t max_clients = 64;
+  std::size_t n_calls_per_client = 200;
+  if (argc > 1)
+  {
+    max_clients = std::stoul(argv[1]);
+  }
+  if (argc > 2)
+  {
+    n_calls_per_client = std::stoul(argv[2]);
+  }
+  const std::size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+  const std::vector<ExecutorSetup> setups = {
+    { "thread per request", [](){ return CreateThreadPerTaskExecutor(); } },
+    { "worker pool", [n_threads](){ return CreateWorkerPool(n_threads); } },
+    { "work stealing", [n_threads](){ return CreateWorkStealingPool(n_threads); } }
+  };
+  std::cout << "Asynchronous calls per second (" << n_threads << " worker threads, "
+            << n_calls_per_client << " calls per client)" << std::endl;
+  std::cout << std::setw(10) << "clients";
+  for (const auto& setup : setups)
+  {
+    std::cout << std::setw(22) << setup.m_name;
+  }
+  std::cout << std::endl;
+  for (std::size_t n_clients = 1; n_clients <= max_clients; n_clients *= 2)
+  {
+    std::cout << std::setw(10) << n_clients;
+    for (const auto& setup : setups)
+    {
+      auto throughput = MeasureThroughput(setup, n_clients, n_calls_per_client);
+      std::cout << std::setw(22) << std::fixed << std::setprecision(0) << throughput;
+    }
+    std::cout << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
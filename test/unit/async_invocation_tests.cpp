@@ -28,7 +28,10 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace sup::protocol;
 
@@ -210,6 +213,163 @@ TEST_F(AsyncInvocationTest, PollNotReadyThenReady)
   EXPECT_EQ(output, kReplyPayload);
 }
 
+// PollOnce only asks the server to hold the poll when the server advertised support for it.
+TEST_F(AsyncInvocationTest, PollWithWait)
+{
+  double max_wait = 0.0;
+  std::vector<double> poll_waits;
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([&max_wait, &poll_waits](const sup::dto::AnyValue& input)
+                     -> sup::dto::AnyValue {
+    switch (utils::GetAsyncInfo(input).second)
+    {
+    case AsyncCommand::kInitialRequest:
+      return utils::CreateAsyncRPCNewRequestReply(kRequestId, PayloadEncoding::kNone, max_wait);
+    case AsyncCommand::kPoll:
+    {
+      auto payload = utils::TryExtractRPCRequestPayload(input, PayloadEncoding::kNone).second;
+      poll_waits.push_back(payload.HasField(constants::ASYNC_WAIT_FIELD_NAME)
+                           ? payload[constants::ASYNC_WAIT_FIELD_NAME].As<sup::dto::float64>()
+                           : 0.0);
+      return utils::CreateAsyncRPCPollReply(false, PayloadEncoding::kNone);
+    }
+    default:
+      return sup::dto::AnyValue{};
+    }
+  });
+  {
+    // Server without support for waiting polls
+    AsyncInvocation invocation{functor, PayloadEncoding::kNone};
+    ASSERT_EQ(invocation.Start(kInput), Success);
+    EXPECT_EQ(invocation.GetMaxPollWait(), 0.0);
+    EXPECT_EQ(invocation.PollOnce(5.0).first, Success);
+  }
+  {
+    // Server that holds polls for at most one second
+    max_wait = 1.0;
+    AsyncInvocation invocation{functor, PayloadEncoding::kNone};
+    ASSERT_EQ(invocation.Start(kInput), Success);
+    EXPECT_EQ(invocation.GetMaxPollWait(), 1.0);
+    EXPECT_EQ(invocation.PollOnce(5.0).first, Success);
+    EXPECT_EQ(invocation.PollOnce(0.5).first, Success);
+    EXPECT_EQ(invocation.PollOnce().first, Success);
+  }
+  std::vector<double> expected_waits{0.0, 1.0, 0.5, 0.0};
+  EXPECT_EQ(poll_waits, expected_waits);
+}
+
+// A reply included in the poll reply is returned without a separate request to the server.
+TEST_F(AsyncInvocationTest, InlineReply)
+{
+  int get_reply_calls = 0;
+  int invalidate_calls = 0;
+  bool inline_requested = false;
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([&](const sup::dto::AnyValue& input) -> sup::dto::AnyValue {
+    switch (utils::GetAsyncInfo(input).second)
+    {
+    case AsyncCommand::kInitialRequest:
+      return utils::CreateAsyncRPCNewRequestReply(kRequestId, PayloadEncoding::kBase64);
+    case AsyncCommand::kPoll:
+    {
+      auto payload = utils::TryExtractRPCRequestPayload(input, PayloadEncoding::kBase64).second;
+      inline_requested = payload.HasField(constants::ASYNC_INLINE_REPLY_FIELD_NAME);
+      return utils::CreateAsyncRPCPollReply(Success, kReplyPayload, PayloadEncoding::kBase64);
+    }
+    case AsyncCommand::kGetReply:
+      ++get_reply_calls;
+      return utils::CreateAsyncRPCReply(Success, kReplyPayload, PayloadEncoding::kBase64,
+                                        AsyncCommand::kGetReply);
+    case AsyncCommand::kInvalidate:
+      ++invalidate_calls;
+      return utils::CreateAsyncRPCReply(Success, AsyncCommand::kInvalidate);
+    default:
+      return sup::dto::AnyValue{};
+    }
+  });
+  AsyncInvocation invocation{functor, PayloadEncoding::kBase64};
+  ASSERT_EQ(invocation.Start(kInput), Success);
+  auto poll_result = invocation.PollOnce();
+  EXPECT_EQ(poll_result.first, Success);
+  EXPECT_TRUE(poll_result.second);
+  EXPECT_TRUE(inline_requested);
+  EXPECT_FALSE(invocation.IsSynchronous());
+  sup::dto::AnyValue output;
+  EXPECT_EQ(invocation.GetReply(output), Success);
+  EXPECT_EQ(output, kReplyPayload);
+  invocation.Invalidate();
+  EXPECT_EQ(get_reply_calls, 0);
+  EXPECT_EQ(invalidate_calls, 0);
+}
+
+// A malformed inline reply is reported as a decoding error.
+TEST_F(AsyncInvocationTest, MalformedInlineReply)
+{
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([](const sup::dto::AnyValue& input) -> sup::dto::AnyValue {
+    switch (utils::GetAsyncInfo(input).second)
+    {
+    case AsyncCommand::kInitialRequest:
+      return utils::CreateAsyncRPCNewRequestReply(kRequestId, PayloadEncoding::kNone);
+    case AsyncCommand::kPoll:
+    {
+      const sup::dto::AnyValue payload = {{
+        { constants::ASYNC_READY_FIELD_NAME, { sup::dto::BooleanType, true }},
+        { constants::REPLY_RESULT, { sup::dto::StringType, "Success" }}
+      }};
+      return utils::CreateAsyncRPCReply(Success, payload, PayloadEncoding::kNone,
+                                        AsyncCommand::kPoll);
+    }
+    default:
+      return sup::dto::AnyValue{};
+    }
+  });
+  AsyncInvocation invocation{functor, PayloadEncoding::kNone};
+  ASSERT_EQ(invocation.Start(kInput), Success);
+  auto poll_result = invocation.PollOnce();
+  EXPECT_EQ(poll_result.first, ClientTransportDecodingError);
+  EXPECT_FALSE(poll_result.second);
+}
+
+// WaitForCompletion returns when completion is notified from another thread.
+TEST_F(AsyncInvocationTest, WaitForCompletion)
+{
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([](const sup::dto::AnyValue& input) -> sup::dto::AnyValue {
+    if (utils::GetAsyncInfo(input).second == AsyncCommand::kInitialRequest)
+    {
+      return utils::CreateAsyncRPCNewRequestReply(kRequestId, PayloadEncoding::kNone);
+    }
+    return sup::dto::AnyValue{};
+  });
+  AsyncInvocation invocation{functor, PayloadEncoding::kNone};
+  EXPECT_EQ(invocation.GetId(), 0u);
+  ASSERT_EQ(invocation.Start(kInput), Success);
+  EXPECT_EQ(invocation.GetId(), kRequestId);
+  EXPECT_FALSE(invocation.WaitForCompletion(0.01));
+  std::thread notifier{[&invocation](){
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    invocation.NotifyCompletion();
+  }};
+  EXPECT_TRUE(invocation.WaitForCompletion(5.0));
+  notifier.join();
+  // Remains notified
+  EXPECT_TRUE(invocation.WaitForCompletion(0.0));
+}
+
+// WaitForCompletion returns immediately for a synchronous reply.
+TEST_F(AsyncInvocationTest, WaitForCompletionWhenSynchronous)
+{
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([](const sup::dto::AnyValue&) -> sup::dto::AnyValue {
+    return utils::CreateRPCReply(Success, kReplyPayload, PayloadEncoding::kNone);
+  });
+  AsyncInvocation invocation{functor, PayloadEncoding::kNone};
+  ASSERT_EQ(invocation.Start(kInput), Success);
+  EXPECT_EQ(invocation.GetId(), 0u);
+  EXPECT_TRUE(invocation.WaitForCompletion(0.0));
+}
+
 // Invalidate notifies the server with an invalidate command for a pending asynchronous request.
 TEST_F(AsyncInvocationTest, InvalidateSendsInvalidateCommand)
 {
@@ -253,3 +413,141 @@ TEST_F(AsyncInvocationTest, InvalidateNoOpWhenSynchronous)
   invocation.Invalidate();
   EXPECT_EQ(invalidate_calls, 0);
 }
+
+// Destroying an invocation whose request is still outstanding invalidates it exactly once.
+TEST_F(AsyncInvocationTest, DestructorInvalidatesOutstandingRequest)
+{
+  int invalidate_calls = 0;
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([&invalidate_calls](const sup::dto::AnyValue& input) -> sup::dto::AnyValue {
+    const auto command = utils::GetAsyncInfo(input).second;
+    if (command == AsyncCommand::kInitialRequest)
+    {
+      return utils::CreateAsyncRPCNewRequestReply(kRequestId, PayloadEncoding::kNone);
+    }
+    if (command == AsyncCommand::kInvalidate)
+    {
+      ++invalidate_calls;
+      return utils::CreateAsyncRPCReply(Success, AsyncCommand::kInvalidate);
+    }
+    return utils::CreateAsyncRPCPollReply(false, PayloadEncoding::kNone);
+  });
+  {
+    AsyncInvocation invocation{functor, PayloadEncoding::kBase64};
+    EXPECT_FALSE(invocation.IsOutstanding());
+    ASSERT_EQ(invocation.Start(kInput), Success);
+    EXPECT_TRUE(invocation.IsOutstanding());
+    auto poll_result = invocation.PollOnce();
+    EXPECT_EQ(poll_result.first, Success);
+    EXPECT_FALSE(poll_result.second);
+    EXPECT_TRUE(invocation.IsOutstanding());
+  }
+  EXPECT_EQ(invalidate_calls, 1);
+  {
+    AsyncInvocation invocation{functor, PayloadEncoding::kBase64};
+    ASSERT_EQ(invocation.Start(kInput), Success);
+    invocation.Invalidate();
+    EXPECT_FALSE(invocation.IsOutstanding());
+  }
+  EXPECT_EQ(invalidate_calls, 2);
+}
+
+// Starting again invalidates the request that is still outstanding.
+TEST_F(AsyncInvocationTest, StartAgainInvalidatesPreviousRequest)
+{
+  sup::dto::uint64 next_id = kRequestId;
+  std::vector<sup::dto::uint64> invalidated_ids;
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([&](const sup::dto::AnyValue& input) -> sup::dto::AnyValue {
+    const auto command = utils::GetAsyncInfo(input).second;
+    if (command == AsyncCommand::kInitialRequest)
+    {
+      return utils::CreateAsyncRPCNewRequestReply(next_id++, PayloadEncoding::kNone);
+    }
+    if (command == AsyncCommand::kInvalidate)
+    {
+      auto payload = utils::TryExtractRPCRequestPayload(input, PayloadEncoding::kBase64).second;
+      invalidated_ids.push_back(payload[constants::ASYNC_ID_FIELD_NAME].As<sup::dto::uint64>());
+      return utils::CreateAsyncRPCReply(Success, AsyncCommand::kInvalidate);
+    }
+    return utils::CreateAsyncRPCPollReply(false, PayloadEncoding::kNone);
+  });
+  {
+    AsyncInvocation invocation{functor, PayloadEncoding::kBase64};
+    ASSERT_EQ(invocation.Start(kInput), Success);
+    EXPECT_EQ(invocation.GetId(), kRequestId);
+    ASSERT_EQ(invocation.Start(kInput), Success);
+    EXPECT_EQ(invocation.GetId(), kRequestId + 1);
+    EXPECT_TRUE(invocation.IsOutstanding());
+    ASSERT_EQ(invalidated_ids.size(), 1);
+    EXPECT_EQ(invalidated_ids[0], kRequestId);
+  }
+  ASSERT_EQ(invalidated_ids.size(), 2);
+  EXPECT_EQ(invalidated_ids[1], kRequestId + 1);
+}
+
+// Destruction during stack unwinding does not send an invalidation.
+TEST_F(AsyncInvocationTest, NoInvalidateDuringUnwinding)
+{
+  int invalidate_calls = 0;
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([&invalidate_calls](const sup::dto::AnyValue& input) -> sup::dto::AnyValue {
+    const auto command = utils::GetAsyncInfo(input).second;
+    if (command == AsyncCommand::kInitialRequest)
+    {
+      return utils::CreateAsyncRPCNewRequestReply(kRequestId, PayloadEncoding::kNone);
+    }
+    if (command == AsyncCommand::kInvalidate)
+    {
+      ++invalidate_calls;
+    }
+    return utils::CreateAsyncRPCReply(Success, AsyncCommand::kInvalidate);
+  });
+  try
+  {
+    AsyncInvocation invocation{functor, PayloadEncoding::kBase64};
+    ASSERT_EQ(invocation.Start(kInput), Success);
+    throw std::runtime_error("early exit");
+  }
+  catch (const std::runtime_error&)
+  {
+  }
+  EXPECT_EQ(invalidate_calls, 0);
+}
+
+// No invalidation is sent for a request whose reply was retrieved.
+TEST_F(AsyncInvocationTest, NoInvalidateAfterReply)
+{
+  int invalidate_calls = 0;
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([&invalidate_calls](const sup::dto::AnyValue& input) -> sup::dto::AnyValue {
+    switch (utils::GetAsyncInfo(input).second)
+    {
+    case AsyncCommand::kInitialRequest:
+      return utils::CreateAsyncRPCNewRequestReply(kRequestId, PayloadEncoding::kNone);
+    case AsyncCommand::kPoll:
+      return utils::CreateAsyncRPCPollReply(true, PayloadEncoding::kNone);
+    case AsyncCommand::kGetReply:
+      return utils::CreateAsyncRPCReply(Success, kReplyPayload, PayloadEncoding::kNone,
+                                        AsyncCommand::kGetReply);
+    case AsyncCommand::kInvalidate:
+      ++invalidate_calls;
+      return utils::CreateAsyncRPCReply(Success, AsyncCommand::kInvalidate);
+    default:
+      break;
+    }
+    return sup::dto::AnyValue{};
+  });
+  {
+    AsyncInvocation invocation{functor, PayloadEncoding::kBase64};
+    ASSERT_EQ(invocation.Start(kInput), Success);
+    auto poll_result = invocation.PollOnce();
+    ASSERT_EQ(poll_result.first, Success);
+    ASSERT_TRUE(poll_result.second);
+    sup::dto::AnyValue output;
+    EXPECT_EQ(invocation.GetReply(output), Success);
+    EXPECT_EQ(output, kReplyPayload);
+    EXPECT_FALSE(invocation.IsOutstanding());
+  }
+  EXPECT_EQ(invalidate_calls, 0);
+}
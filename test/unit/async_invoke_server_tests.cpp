@@ -21,10 +21,19 @@
 #include "test_protocol.h"
 
 #include <sup/protocol/base/async_invoke_server.h>
+#include <sup/protocol/exceptions.h>
+#include <sup/protocol/function_protocol.h>
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
 
 using namespace sup::protocol;
 
@@ -240,6 +249,1148 @@ TEST_F(AsyncRequestServerTest, InvalidAsyncOperation)
   EXPECT_EQ(ExtractProtocolResult(reply), InvalidAsynchronousOperationError);
 }
 
+TEST_F(AsyncRequestServerTest, MaxActiveRequests)
+{
+  // New requests are rejected when the maximum number of running requests is reached
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol protocol{go.get_future()};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_max_active_requests = 1;
+  AsyncInvokeServer async_server{protocol, config};
+
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto id = test::ExtractRequestId(reply);
+  EXPECT_EQ(id, 1u);
+  EXPECT_EQ(async_server.GetNumberOfActiveRequests(), 1u);
+
+  // Second request is rejected
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  EXPECT_EQ(ExtractAsyncCommand(reply), AsyncCommand::kInitialRequest);
+  EXPECT_EQ(ExtractProtocolResult(reply), ServerBusy);
+  EXPECT_FALSE(reply.HasField(constants::REPLY_PAYLOAD));
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 1u);
+
+  // Finish the first request: new requests are accepted again, even if the first reply was not
+  // retrieved yet
+  go.set_value();
+  EXPECT_TRUE(async_server.WaitForReady(id, 1.0));
+  EXPECT_EQ(async_server.GetNumberOfActiveRequests(), 0u);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(test::ExtractRequestId(reply), 2u);
+}
+
+TEST_F(AsyncRequestServerTest, MaxRetainedRequests)
+{
+  // New requests are rejected when the maximum number of retained requests is reached
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  test::TestProtocol protocol{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_max_retained_requests = 1;
+  AsyncInvokeServer async_server{protocol, config};
+
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto id = test::ExtractRequestId(reply);
+  EXPECT_EQ(id, 1u);
+  EXPECT_TRUE(async_server.WaitForReady(id, 1.0));
+
+  // Second request is rejected since the first reply was not retrieved yet
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  EXPECT_EQ(ExtractProtocolResult(reply), ServerBusy);
+
+  // Retrieving the first reply makes room for a new request
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0u);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(test::ExtractRequestId(reply), 2u);
+}
+
+TEST_F(AsyncRequestServerTest, MaxRetainedRequestsCleanUp)
+{
+  // Without background clean up, expired requests are removed to make room for a new request
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  test::TestProtocol protocol{};
+  VirtualClock clock{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = CreateWorkerPool(1);
+  config.m_max_retained_requests = 1;
+  {
+    AsyncInvokeServer async_server{protocol, config, clock};
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    ASSERT_TRUE(async_server.WaitForReady(test::ExtractRequestId(reply), 1.0));
+    clock.Advance(2 * kExpirationSec);
+    reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                      AsyncCommand::kInitialRequest);
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+    EXPECT_EQ(async_server.GetNumberOfAbandonedRequests(), 1);
+  }
+  // With background clean up, the request is rejected and removal is left to the clean up
+  config.m_cleanup_interval_sec = 1.0;
+  {
+    AsyncInvokeServer async_server{protocol, config, clock};
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    ASSERT_TRUE(async_server.WaitForReady(test::ExtractRequestId(reply), 1.0));
+    clock.Advance(2 * kExpirationSec);
+    reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                      AsyncCommand::kInitialRequest);
+    EXPECT_EQ(ExtractProtocolResult(reply), ServerBusy);
+    EXPECT_EQ(async_server.GetNumberOfAbandonedRequests(), 0);
+    async_server.CleanUpExpiredRequests();
+    reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                      AsyncCommand::kInitialRequest);
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  }
+}
+
+TEST_F(AsyncRequestServerTest, WaitDoesNotBlockOtherRequests)
+{
+  // Waiting for a request does not block other calls for the same request
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol protocol{go.get_future()};
+  AsyncInvokeServer async_server{protocol, kExpirationSec};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_EQ(id, 1u);
+  std::promise<void> waiting;
+  auto wait_result = std::async(std::launch::async, [&async_server, &waiting, id](){
+    waiting.set_value();
+    return async_server.WaitForReady(id, 5.0);
+  });
+  waiting.get_future().wait();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // Poll returns immediately while the other thread is waiting
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  auto start = std::chrono::steady_clock::now();
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+  auto poll_duration = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_FALSE(test::ExtractReadyStatus(reply));
+  EXPECT_LT(poll_duration, std::chrono::seconds(1));
+
+  go.set_value();
+  EXPECT_TRUE(wait_result.get());
+}
+
+TEST_F(AsyncRequestServerTest, LongPoll)
+{
+  // A poll with a wait time is held until the reply is ready
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol protocol{go.get_future()};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_max_poll_wait_sec = 5.0;
+  AsyncInvokeServer async_server{protocol, config};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  EXPECT_EQ(utils::GetAsyncMaxPollWait(reply, PayloadEncoding::kNone), 5.0);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_EQ(id, 1u);
+  const sup::dto::AnyValue poll_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id },
+    { constants::ASYNC_WAIT_FIELD_NAME, 10.0 }
+  }};
+  auto poll_reply = std::async(std::launch::async, [&async_server, &poll_payload](){
+    return async_server.HandleInvoke(poll_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+  });
+  EXPECT_EQ(poll_reply.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+
+  go.set_value();
+  ASSERT_EQ(poll_reply.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  reply = poll_reply.get();
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_TRUE(test::ExtractReadyStatus(reply));
+}
+
+TEST_F(AsyncRequestServerTest, LongPollLimitedByServer)
+{
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol protocol{go.get_future()};
+  {
+    // Waiting polls are disabled by default
+    AsyncInvokeServer async_server{protocol, kExpirationSec};
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    EXPECT_EQ(utils::GetAsyncMaxPollWait(reply, PayloadEncoding::kNone), 0.0);
+    const sup::dto::AnyValue poll_payload = {{
+      { constants::ASYNC_ID_FIELD_NAME, test::ExtractRequestId(reply) },
+      { constants::ASYNC_WAIT_FIELD_NAME, 10.0 }
+    }};
+    auto start = std::chrono::steady_clock::now();
+    reply = async_server.HandleInvoke(poll_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+    EXPECT_FALSE(test::ExtractReadyStatus(reply));
+    go.set_value();
+  }
+  {
+    // The wait time is limited to the configured maximum
+    std::promise<void> release;
+    test::AsyncRequestTestProtocol waiting_protocol{release.get_future()};
+    ProtocolRPCServerConfig config{kExpirationSec};
+    config.m_max_poll_wait_sec = 0.05;
+    AsyncInvokeServer async_server{waiting_protocol, config};
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    const sup::dto::AnyValue poll_payload = {{
+      { constants::ASYNC_ID_FIELD_NAME, test::ExtractRequestId(reply) },
+      { constants::ASYNC_WAIT_FIELD_NAME, 10.0 }
+    }};
+    auto start = std::chrono::steady_clock::now();
+    reply = async_server.HandleInvoke(poll_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+    auto poll_duration = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(poll_duration, std::chrono::milliseconds(50));
+    EXPECT_LT(poll_duration, std::chrono::seconds(1));
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+    EXPECT_FALSE(test::ExtractReadyStatus(reply));
+    release.set_value();
+  }
+}
+
+TEST_F(AsyncRequestServerTest, InlineReply)
+{
+  // A poll that asks for an inline reply retires a ready request
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol protocol{go.get_future()};
+  AsyncInvokeServer async_server{protocol, kExpirationSec};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_EQ(id, 1u);
+  const sup::dto::AnyValue poll_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id },
+    { constants::ASYNC_INLINE_REPLY_FIELD_NAME, true }
+  }};
+
+  // Not ready yet: plain poll reply
+  reply = async_server.HandleInvoke(poll_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_FALSE(test::ExtractReadyStatus(reply));
+  EXPECT_FALSE(reply[constants::REPLY_PAYLOAD].HasField(constants::REPLY_RESULT));
+
+  // Ready: the reply is included and the request is removed
+  go.set_value();
+  ASSERT_TRUE(async_server.WaitForReady(id, 5.0));
+  reply = async_server.HandleInvoke(poll_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_TRUE(test::ExtractReadyStatus(reply));
+  auto& poll_reply_payload = reply[constants::REPLY_PAYLOAD];
+  ASSERT_TRUE(poll_reply_payload.HasField(constants::REPLY_RESULT));
+  EXPECT_EQ(poll_reply_payload[constants::REPLY_RESULT].As<sup::dto::uint32>(),
+            Success.GetValue());
+  ASSERT_TRUE(poll_reply_payload.HasField(constants::REPLY_PAYLOAD));
+  EXPECT_EQ(poll_reply_payload[constants::REPLY_PAYLOAD], input);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0u);
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), InvalidRequestIdentifierError);
+}
+
+TEST_F(AsyncRequestServerTest, InlineGracePeriod)
+{
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  {
+    // A request that finishes within the grace period is answered synchronously
+    std::promise<void> go;
+    go.set_value();
+    test::AsyncRequestTestProtocol protocol{go.get_future()};
+    ProtocolRPCServerConfig config{kExpirationSec};
+    config.m_inline_grace_sec = 5.0;
+    AsyncInvokeServer async_server{protocol, config};
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+    EXPECT_FALSE(reply.HasField(constants::ASYNC_COMMAND_FIELD_NAME));
+    ASSERT_TRUE(reply.HasField(constants::REPLY_PAYLOAD));
+    EXPECT_EQ(reply[constants::REPLY_PAYLOAD], input);
+    EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0u);
+    EXPECT_EQ(async_server.GetNumberOfActiveRequests(), 0u);
+  }
+  {
+    // Otherwise, the request identifier is returned after the grace period
+    std::promise<void> go;
+    test::AsyncRequestTestProtocol protocol{go.get_future()};
+    ProtocolRPCServerConfig config{kExpirationSec};
+    config.m_inline_grace_sec = 0.05;
+    AsyncInvokeServer async_server{protocol, config};
+    auto start = std::chrono::steady_clock::now();
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    auto duration = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(duration, std::chrono::milliseconds(50));
+    EXPECT_LT(duration, std::chrono::seconds(1));
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+    auto id = test::ExtractRequestId(reply);
+    ASSERT_EQ(id, 1u);
+    EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 1u);
+    go.set_value();
+    ASSERT_TRUE(async_server.WaitForReady(id, 5.0));
+    const sup::dto::AnyValue id_payload = {{
+      { constants::ASYNC_ID_FIELD_NAME, id }
+    }};
+    reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone,
+                                      AsyncCommand::kGetReply);
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+    EXPECT_EQ(reply[constants::REPLY_PAYLOAD], input);
+  }
+}
+
+TEST_F(AsyncRequestServerTest, CompletionCallback)
+{
+  // The completion callback receives the request identifier and can retrieve the reply
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol protocol{go.get_future()};
+  std::promise<sup::dto::AnyValue> pushed;
+  AsyncInvokeServer* server_ptr = nullptr;
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_completion_callback = [&pushed, &server_ptr](sup::dto::uint64 id,
+                                                        const ProtocolResult& result) {
+    EXPECT_EQ(result, Success);
+    const sup::dto::AnyValue id_payload = {{
+      { constants::ASYNC_ID_FIELD_NAME, id }
+    }};
+    pushed.set_value(server_ptr->HandleInvoke(id_payload, PayloadEncoding::kNone,
+                                              AsyncCommand::kGetReply));
+  };
+  AsyncInvokeServer async_server{protocol, config};
+  server_ptr = &async_server;
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_EQ(id, 1u);
+  auto pushed_future = pushed.get_future();
+  EXPECT_EQ(pushed_future.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+
+  go.set_value();
+  ASSERT_EQ(pushed_future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  reply = pushed_future.get();
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(reply[constants::REPLY_PAYLOAD], input);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0u);
+}
+
+TEST_F(AsyncRequestServerTest, CompletionCallbackInlineGrace)
+{
+  // Requests answered inline are not reported, requests answered later are
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::vector<sup::dto::uint64> reported;
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_inline_grace_sec = 0.05;
+  config.m_completion_callback = [&mtx, &cv, &reported](sup::dto::uint64 id,
+                                                        const ProtocolResult& result) {
+    EXPECT_EQ(result, Success);
+    std::lock_guard<std::mutex> lk{mtx};
+    reported.push_back(id);
+    cv.notify_all();
+  };
+  {
+    std::promise<void> go;
+    go.set_value();
+    test::AsyncRequestTestProtocol protocol{go.get_future()};
+    AsyncInvokeServer async_server{protocol, config};
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+    ASSERT_TRUE(reply.HasField(constants::REPLY_PAYLOAD));
+    EXPECT_EQ(reply[constants::REPLY_PAYLOAD], input);
+  }
+  {
+    std::lock_guard<std::mutex> lk{mtx};
+    EXPECT_TRUE(reported.empty());
+  }
+  {
+    std::promise<void> go;
+    test::AsyncRequestTestProtocol protocol{go.get_future()};
+    AsyncInvokeServer async_server{protocol, config};
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    auto id = test::ExtractRequestId(reply);
+    ASSERT_EQ(id, 1u);
+    go.set_value();
+    std::unique_lock<std::mutex> lk{mtx};
+    ASSERT_TRUE(cv.wait_for(lk, std::chrono::seconds(5), [&reported] {
+      return !reported.empty();
+    }));
+    ASSERT_EQ(reported.size(), 1u);
+    EXPECT_EQ(reported[0], 1u);
+  }
+}
+
+TEST_F(AsyncRequestServerTest, CleanUpExpiredRequests)
+{
+  // Only requests that were not accessed within the expiration time are removed
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  test::TestProtocol protocol{};
+  AsyncInvokeServer async_server{protocol, 0.1};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto expiring_id = test::ExtractRequestId(reply);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  auto polled_id = test::ExtractRequestId(reply);
+  ASSERT_TRUE(async_server.WaitForReady(expiring_id, 1.0));
+  ASSERT_TRUE(async_server.WaitForReady(polled_id, 1.0));
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 2u);
+
+  // Keep polling one of the requests
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, polled_id }
+  }};
+  for (int i = 0; i < 4; ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+    EXPECT_TRUE(test::ExtractReadyStatus(reply));
+  }
+  async_server.CleanUpExpiredRequests();
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 1u);
+  EXPECT_FALSE(async_server.WaitForReady(expiring_id, 0.0));
+  EXPECT_TRUE(async_server.WaitForReady(polled_id, 0.0));
+
+  // Stop polling: the second request expires too
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  async_server.CleanUpExpiredRequests();
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0u);
+}
+
+TEST_F(AsyncRequestServerTest, InvalidateCancelsRequests)
+{
+  // Invalidating a queued request frees its place immediately and stops a running request
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  test::CancellableTestProtocol protocol{5.0};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = CreateWorkerPool(1);
+  config.m_max_active_requests = 2;
+  AsyncInvokeServer async_server{protocol, config};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto running_id = test::ExtractRequestId(reply);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  auto queued_id = test::ExtractRequestId(reply);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  EXPECT_EQ(ExtractProtocolResult(reply), ServerBusy);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (protocol.GetNumberOfInvocations() == 0 && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(protocol.GetNumberOfInvocations(), 1);
+
+  const sup::dto::AnyValue queued_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, queued_id }
+  }};
+  reply = async_server.HandleInvoke(queued_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kInvalidate);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(async_server.GetNumberOfActiveRequests(), 1);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 1);
+
+  const sup::dto::AnyValue running_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, running_id }
+  }};
+  reply = async_server.HandleInvoke(running_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kInvalidate);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (async_server.GetNumberOfActiveRequests() > 0 &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(async_server.GetNumberOfActiveRequests(), 0);
+  EXPECT_EQ(protocol.GetNumberOfInvocations(), 1);
+  EXPECT_EQ(protocol.GetNumberOfCancellations(), 1);
+}
+
+TEST_F(AsyncRequestServerTest, ExpiryCancelsRequests)
+{
+  // Expired requests are cancelled by the clean up
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  test::CancellableTestProtocol protocol{5.0};
+  AsyncInvokeServer async_server{protocol, 0.05, CreateWorkerPool(1)};
+  (void)async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  (void)async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // The queued request is removed immediately, the running one after it stopped
+  async_server.CleanUpExpiredRequests();
+  EXPECT_LE(async_server.GetNumberOfRetainedRequests(), 1);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (async_server.GetNumberOfActiveRequests() > 0 &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  async_server.CleanUpExpiredRequests();
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0);
+  EXPECT_EQ(protocol.GetNumberOfInvocations(), 1);
+  EXPECT_EQ(protocol.GetNumberOfCancellations(), 1);
+}
+
+TEST_F(AsyncRequestServerTest, VirtualClockExpiry)
+{
+  // Expiration follows the clock of the server, not the time that passed
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  test::TestProtocol protocol{};
+  VirtualClock clock{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = CreateWorkerPool(1);
+  AsyncInvokeServer async_server{protocol, config, clock};
+  EXPECT_EQ(&async_server.GetClock(), &clock);
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_TRUE(async_server.WaitForReady(id, 1.0));
+  clock.Advance(0.75 * kExpirationSec);
+  async_server.CleanUpExpiredRequests();
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 1);
+
+  // Polling resets the expiration timer
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+  EXPECT_TRUE(test::ExtractReadyStatus(reply));
+  clock.Advance(0.75 * kExpirationSec);
+  async_server.CleanUpExpiredRequests();
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 1);
+  clock.Advance(0.5 * kExpirationSec);
+  async_server.CleanUpExpiredRequests();
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0);
+}
+
+TEST_F(AsyncRequestServerTest, LatencyStatistics)
+{
+  // Latencies are recorded per lifecycle stage when the request is removed
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  test::TestProtocol protocol{};
+  VirtualClock clock{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = CreateWorkerPool(1);
+  AsyncInvokeServer async_server{protocol, config, clock};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_TRUE(async_server.WaitForReady(id, 1.0));
+  clock.Advance(2.0);
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+  EXPECT_TRUE(test::ExtractReadyStatus(reply));
+  EXPECT_EQ(async_server.GetLatencyStatistics().m_fetch_time.GetCount(), 0);
+  clock.Advance(1.0);
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+
+  auto statistics = async_server.GetLatencyStatistics();
+  EXPECT_EQ(statistics.m_queue_time.GetCount(), 1);
+  EXPECT_EQ(statistics.m_queue_time.GetMaximum(), 0.0);
+  EXPECT_EQ(statistics.m_execution_time.GetCount(), 1);
+  EXPECT_EQ(statistics.m_execution_time.GetMaximum(), 0.0);
+  EXPECT_EQ(statistics.m_poll_delay.GetCount(), 1);
+  EXPECT_DOUBLE_EQ(statistics.m_poll_delay.GetPercentile(0.5), 2.0);
+  EXPECT_EQ(statistics.m_fetch_time.GetCount(), 1);
+  EXPECT_DOUBLE_EQ(statistics.m_fetch_time.GetPercentile(0.5), 3.0);
+
+  async_server.ResetLatencyStatistics();
+  statistics = async_server.GetLatencyStatistics();
+  EXPECT_EQ(statistics.m_queue_time.GetCount(), 0);
+  EXPECT_EQ(statistics.m_execution_time.GetCount(), 0);
+  EXPECT_EQ(statistics.m_poll_delay.GetCount(), 0);
+  EXPECT_EQ(statistics.m_fetch_time.GetCount(), 0);
+}
+
+TEST_F(AsyncRequestServerTest, RetryAfterHints)
+{
+  // Replies suggest when to poll next, based on earlier requests for the same function
+  const sup::dto::AnyValue slow_input = {{
+    { FUNCTION_FIELD_NAME, { sup::dto::StringType, "slow" }}
+  }};
+  const sup::dto::AnyValue other_input = {{
+    { FUNCTION_FIELD_NAME, { sup::dto::StringType, "other" }}
+  }};
+  test::GatedTestProtocol protocol{};
+  VirtualClock clock{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_retry_after_hints = true;
+  AsyncInvokeServer async_server{protocol, config, clock};
+
+  // Without an estimate, there is no hint
+  auto reply = async_server.HandleInvoke(slow_input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  EXPECT_EQ(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 0.0);
+  auto id = test::ExtractRequestId(reply);
+  clock.Advance(2.0);
+  protocol.Open();
+  ASSERT_TRUE(async_server.WaitForReady(id, 5.0));
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  protocol.Close();
+
+  // The hint is the expected remaining time
+  reply = async_server.HandleInvoke(slow_input, PayloadEncoding::kNone,
+                                    AsyncCommand::kInitialRequest);
+  EXPECT_NEAR(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 2.0, 1e-6);
+  const sup::dto::AnyValue poll_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, test::ExtractRequestId(reply) }
+  }};
+  clock.Advance(0.5);
+  reply = async_server.HandleInvoke(poll_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+  EXPECT_FALSE(test::ExtractReadyStatus(reply));
+  EXPECT_NEAR(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 1.5, 1e-6);
+
+  // Overdue requests are polled more often
+  clock.Advance(5.0);
+  reply = async_server.HandleInvoke(poll_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+  EXPECT_FALSE(test::ExtractReadyStatus(reply));
+  EXPECT_NEAR(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 0.2, 1e-6);
+
+  // Other functions have their own estimate
+  reply = async_server.HandleInvoke(other_input, PayloadEncoding::kNone,
+                                    AsyncCommand::kInitialRequest);
+  EXPECT_EQ(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 0.0);
+  protocol.Open();
+}
+
+TEST_F(AsyncRequestServerTest, AbandonedRequests)
+{
+  // Requests that are invalidated or expire before their reply was retrieved count as abandoned
+  const std::string text = "This is the reply payload";
+  const sup::dto::AnyValue input = {{
+    { test::ECHO_FIELD, true },
+    { "text", text }
+  }};
+  const std::size_t reply_size = 1 + text.size();
+  test::TestProtocol protocol{};
+  AsyncInvokeServer async_server{protocol, 0.2, CreateWorkerPool(1)};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto retrieved_id = test::ExtractRequestId(reply);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  auto invalidated_id = test::ExtractRequestId(reply);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  auto expired_id = test::ExtractRequestId(reply);
+  ASSERT_TRUE(async_server.WaitForReady(retrieved_id, 1.0));
+  ASSERT_TRUE(async_server.WaitForReady(invalidated_id, 1.0));
+  ASSERT_TRUE(async_server.WaitForReady(expired_id, 1.0));
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 3 * reply_size);
+
+  // Retrieving a reply releases its memory without counting as abandoned
+  const sup::dto::AnyValue retrieved_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, retrieved_id }
+  }};
+  reply = async_server.HandleInvoke(retrieved_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(async_server.GetNumberOfAbandonedRequests(), 0);
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 2 * reply_size);
+
+  // Invalidate only counts once
+  const sup::dto::AnyValue invalidated_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, invalidated_id }
+  }};
+  reply = async_server.HandleInvoke(invalidated_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kInvalidate);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  reply = async_server.HandleInvoke(invalidated_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kInvalidate);
+  EXPECT_EQ(ExtractProtocolResult(reply), InvalidRequestIdentifierError);
+  EXPECT_EQ(async_server.GetNumberOfAbandonedRequests(), 1);
+  EXPECT_EQ(async_server.GetRetainedReplySize(), reply_size);
+
+  // Expiry
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  async_server.CleanUpExpiredRequests();
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0);
+  EXPECT_EQ(async_server.GetNumberOfAbandonedRequests(), 2);
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 0);
+}
+
+TEST_F(AsyncRequestServerTest, CancelledRequestReleasesReply)
+{
+  // The output of a request that was invalidated while running is not retained
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol protocol{go.get_future()};
+  AsyncInvokeServer async_server{protocol, kExpirationSec, CreateWorkerPool(1)};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto id = test::ExtractRequestId(reply);
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  // Give the task time to start, so it produces its output after the invalidation
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kInvalidate);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  go.set_value();
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (async_server.GetNumberOfActiveRequests() > 0 &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(async_server.GetNumberOfActiveRequests(), 0);
+  EXPECT_EQ(async_server.GetNumberOfAbandonedRequests(), 1);
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 0);
+}
+
+TEST_F(AsyncRequestServerTest, ReplyBudget)
+{
+  // Replies that are not retrieved are evicted, least recently accessed first, to stay within the
+  // memory budget
+  const std::string text = "This is the reply payload";
+  const sup::dto::AnyValue input = {{
+    { test::ECHO_FIELD, true },
+    { "text", text }
+  }};
+  const std::size_t reply_size = 1 + text.size();
+  test::TestProtocol protocol{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = CreateWorkerPool(1);
+  config.m_max_retained_reply_bytes = reply_size;
+  AsyncInvokeServer async_server{protocol, config};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto evicted_id = test::ExtractRequestId(reply);
+  ASSERT_TRUE(async_server.WaitForReady(evicted_id, 1.0));
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  auto kept_id = test::ExtractRequestId(reply);
+  ASSERT_TRUE(async_server.WaitForReady(kept_id, 1.0));
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 2 * reply_size);
+  EXPECT_EQ(async_server.GetNumberOfEvictedReplies(), 0);
+
+  // Eviction happens during clean up
+  async_server.CleanUpExpiredRequests();
+  EXPECT_EQ(async_server.GetNumberOfEvictedReplies(), 1);
+  EXPECT_EQ(async_server.GetRetainedReplySize(), reply_size);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 2);
+
+  // The evicted request is still known, but its reply is gone
+  const sup::dto::AnyValue evicted_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, evicted_id }
+  }};
+  reply = async_server.HandleInvoke(evicted_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kPoll);
+  EXPECT_TRUE(test::ExtractReadyStatus(reply));
+  reply = async_server.HandleInvoke(evicted_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), AsynchronousReplyEvicted);
+  const sup::dto::AnyValue kept_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, kept_id }
+  }};
+  reply = async_server.HandleInvoke(kept_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 0);
+  EXPECT_EQ(async_server.GetNumberOfEvictedReplies(), 1);
+}
+
+TEST_F(AsyncRequestServerTest, ReplyBudgetLastAccess)
+{
+  // Eviction follows the last access of the requests, also when they live in different shards
+  const std::string text = "This is the reply payload";
+  const sup::dto::AnyValue input = {{
+    { test::ECHO_FIELD, true },
+    { "text", text }
+  }};
+  const std::size_t reply_size = 1 + text.size();
+  test::TestProtocol protocol{};
+  VirtualClock clock{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = CreateWorkerPool(1);
+  config.m_max_retained_reply_bytes = 2 * reply_size;
+  AsyncInvokeServer async_server{protocol, config, clock};
+  std::vector<sup::dto::uint64> ids;
+  for (int i = 0; i < 2; ++i)
+  {
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    ids.push_back(test::ExtractRequestId(reply));
+    ASSERT_TRUE(async_server.WaitForReady(ids.back(), 1.0));
+    clock.Advance(0.1 * kExpirationSec);
+  }
+
+  // Polling the first request makes the second one the least recently accessed
+  const sup::dto::AnyValue first_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, ids[0] }
+  }};
+  auto reply = async_server.HandleInvoke(first_payload, PayloadEncoding::kNone,
+                                         AsyncCommand::kPoll);
+  EXPECT_TRUE(test::ExtractReadyStatus(reply));
+  clock.Advance(0.1 * kExpirationSec);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest);
+  ids.push_back(test::ExtractRequestId(reply));
+  ASSERT_TRUE(async_server.WaitForReady(ids.back(), 1.0));
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 3 * reply_size);
+  async_server.CleanUpExpiredRequests();
+  EXPECT_EQ(async_server.GetNumberOfEvictedReplies(), 1);
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 2 * reply_size);
+  const std::vector<ProtocolResult> expected_results{ Success, AsynchronousReplyEvicted, Success };
+  for (std::size_t i = 0; i < ids.size(); ++i)
+  {
+    const sup::dto::AnyValue id_payload = {{
+      { constants::ASYNC_ID_FIELD_NAME, ids[i] }
+    }};
+    reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone,
+                                      AsyncCommand::kGetReply);
+    EXPECT_EQ(ExtractProtocolResult(reply), expected_results[i]);
+  }
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 0);
+}
+
+TEST_F(AsyncRequestServerTest, SpillLargeReplies)
+{
+  // Replies above the threshold are kept in a scratch file until they are retrieved
+  const std::string text = "This is the reply payload";
+  const sup::dto::AnyValue large_input = {{
+    { test::ECHO_FIELD, true },
+    { "text", text }
+  }};
+  const sup::dto::AnyValue small_input = {{
+    { test::ECHO_FIELD, true }
+  }};
+  test::TestProtocol protocol{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = CreateWorkerPool(1);
+  config.m_reply_spill_threshold = text.size();
+  EXPECT_THROW(AsyncInvokeServer(protocol, config), InvalidOperationException);
+  config.m_reply_spill_directory = "/tmp";
+  AsyncInvokeServer async_server{protocol, config};
+  auto reply = async_server.HandleInvoke(large_input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto large_id = test::ExtractRequestId(reply);
+  reply = async_server.HandleInvoke(small_input, PayloadEncoding::kNone,
+                                    AsyncCommand::kInitialRequest);
+  auto small_id = test::ExtractRequestId(reply);
+  ASSERT_TRUE(async_server.WaitForReady(large_id, 1.0));
+  ASSERT_TRUE(async_server.WaitForReady(small_id, 1.0));
+  EXPECT_EQ(async_server.GetNumberOfSpilledReplies(), 1);
+  // Only the small reply is held in memory
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 1);
+
+  const sup::dto::AnyValue large_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, large_id }
+  }};
+  reply = async_server.HandleInvoke(large_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  ASSERT_TRUE(reply.HasField(constants::REPLY_PAYLOAD));
+  EXPECT_EQ(reply[constants::REPLY_PAYLOAD], large_input);
+  const sup::dto::AnyValue small_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, small_id }
+  }};
+  reply = async_server.HandleInvoke(small_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  ASSERT_TRUE(reply.HasField(constants::REPLY_PAYLOAD));
+  EXPECT_EQ(reply[constants::REPLY_PAYLOAD], small_input);
+  EXPECT_EQ(async_server.GetRetainedReplySize(), 0);
+}
+
+TEST_F(AsyncRequestServerTest, PooledRequests)
+{
+  // Pooling the request entries does not change the behaviour of the server
+  const sup::dto::AnyValue input = {{
+    { test::ECHO_FIELD, true },
+    { "text", "This is the request payload" }
+  }};
+  test::TestProtocol protocol{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = CreateWorkerPool(1);
+  config.m_pooled_requests = true;
+  AsyncInvokeServer async_server{protocol, config};
+  for (int i = 0; i < 20; ++i)
+  {
+    auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                           AsyncCommand::kInitialRequest);
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+    auto id = test::ExtractRequestId(reply);
+    ASSERT_TRUE(async_server.WaitForReady(id, 1.0));
+    const sup::dto::AnyValue id_payload = {{
+      { constants::ASYNC_ID_FIELD_NAME, id }
+    }};
+    reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone,
+                                      AsyncCommand::kGetReply);
+    EXPECT_EQ(ExtractProtocolResult(reply), Success);
+    ASSERT_TRUE(reply.HasField(constants::REPLY_PAYLOAD));
+    EXPECT_EQ(reply[constants::REPLY_PAYLOAD], input);
+  }
+  EXPECT_EQ(async_server.GetNumberOfActiveRequests(), 0);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0);
+}
+
+TEST_F(AsyncRequestServerTest, DestroyWithQueuedCancelledRequest)
+{
+  // A request that was invalidated before it started is finished, while the dispatch task of the
+  // priority scheduler is still queued in the executor: destroying the server waits until the
+  // executor ran it
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  auto executor = std::make_shared<test::ManualExecutor>();
+  test::TestProtocol protocol{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = executor;
+  auto async_server = std::make_unique<AsyncInvokeServer>(protocol, config);
+  auto reply = async_server->HandleInvoke(input, PayloadEncoding::kNone,
+                                          AsyncCommand::kInitialRequest, AsyncPriority::kLow);
+  auto id = test::ExtractRequestId(reply);
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  reply = async_server->HandleInvoke(id_payload, PayloadEncoding::kNone,
+                                     AsyncCommand::kInvalidate);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(async_server->GetNumberOfActiveRequests(), 0);
+  auto destroyed = std::async(std::launch::async, [&async_server](){ async_server.reset(); });
+  EXPECT_EQ(destroyed.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+  executor->RunAll();
+  EXPECT_EQ(destroyed.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+}
+
+TEST_F(AsyncRequestServerTest, InvalidateReleasesQueuedTask)
+{
+  // Invalidating a request whose task is still queued in the priority scheduler releases the task
+  // immediately, instead of when a worker dispatches it
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  auto executor = std::make_shared<test::ManualExecutor>();
+  test::TestProtocol protocol{};
+  auto sentinel = std::make_shared<int>(0);
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_executor = executor;
+  // Each task holds a copy of the completion callback
+  config.m_completion_callback = [sentinel](sup::dto::uint64, const ProtocolResult&) {};
+  AsyncInvokeServer async_server{protocol, config};
+  const auto initial_count = sentinel.use_count();
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest, AsyncPriority::kLow);
+  auto id = test::ExtractRequestId(reply);
+  EXPECT_EQ(sentinel.use_count(), initial_count + 1);
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kInvalidate);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0u);
+  EXPECT_EQ(sentinel.use_count(), initial_count);
+  executor->RunAll();
+}
+
+TEST_F(AsyncRequestServerTest, IdempotencyKey)
+{
+  // A new request with a known key returns the existing request instead of starting a new one
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol protocol{go.get_future()};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_max_active_requests = 1;
+  AsyncInvokeServer async_server{protocol, config};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest, AsyncPriority::kNormal,
+                                         "key_1");
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  auto id = test::ExtractRequestId(reply);
+
+  // A retry is not limited by the maximum number of active requests
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest,
+                                    AsyncPriority::kNormal, "key_1");
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(test::ExtractRequestId(reply), id);
+  EXPECT_EQ(async_server.GetNumberOfActiveRequests(), 1);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 1);
+
+  // A different key is a different request
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest,
+                                    AsyncPriority::kNormal, "key_2");
+  EXPECT_EQ(ExtractProtocolResult(reply), ServerBusy);
+
+  // Retrieving the reply releases the key
+  go.set_value();
+  ASSERT_TRUE(async_server.WaitForReady(id, 1.0));
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest,
+                                    AsyncPriority::kNormal, "key_1");
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  auto new_id = test::ExtractRequestId(reply);
+  EXPECT_NE(new_id, id);
+
+  // Invalidating a request releases its key, even when it is still running
+  const sup::dto::AnyValue new_id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, new_id }
+  }};
+  reply = async_server.HandleInvoke(new_id_payload, PayloadEncoding::kNone,
+                                    AsyncCommand::kInvalidate);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (async_server.GetNumberOfActiveRequests() > 0 &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest,
+                                    AsyncPriority::kNormal, "key_1");
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  EXPECT_NE(test::ExtractRequestId(reply), new_id);
+}
+
+TEST_F(AsyncRequestServerTest, IdempotencyKeyRetryAfter)
+{
+  // A retry gets the same retry-after hint as the original request
+  const sup::dto::AnyValue input = {{
+    { FUNCTION_FIELD_NAME, { sup::dto::StringType, "slow" }}
+  }};
+  test::GatedTestProtocol protocol{};
+  VirtualClock clock{};
+  ProtocolRPCServerConfig config{kExpirationSec};
+  config.m_retry_after_hints = true;
+  AsyncInvokeServer async_server{protocol, config, clock};
+  auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                         AsyncCommand::kInitialRequest);
+  auto id = test::ExtractRequestId(reply);
+  clock.Advance(2.0);
+  protocol.Open();
+  ASSERT_TRUE(async_server.WaitForReady(id, 5.0));
+  const sup::dto::AnyValue id_payload = {{
+    { constants::ASYNC_ID_FIELD_NAME, id }
+  }};
+  reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kGetReply);
+  EXPECT_EQ(ExtractProtocolResult(reply), Success);
+  protocol.Close();
+
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest,
+                                    AsyncPriority::kNormal, "key");
+  EXPECT_NEAR(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 2.0, 1e-6);
+  id = test::ExtractRequestId(reply);
+  clock.Advance(0.5);
+  reply = async_server.HandleInvoke(input, PayloadEncoding::kNone, AsyncCommand::kInitialRequest,
+                                    AsyncPriority::kNormal, "key");
+  EXPECT_EQ(test::ExtractRequestId(reply), id);
+  EXPECT_NEAR(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 1.5, 1e-6);
+  protocol.Open();
+}
+
+TEST_F(AsyncRequestServerTest, ConcurrentIdempotencyKey)
+{
+  // Concurrent requests with the same key all get an identifier that can be polled right away
+  const std::size_t n_threads = 8;
+  const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+  test::GatedTestProtocol protocol{};
+  AsyncInvokeServer async_server{protocol, kExpirationSec};
+  std::promise<void> go;
+  std::shared_future<void> go_future = go.get_future();
+  std::mutex mtx;
+  std::set<sup::dto::uint64> ids;
+  std::vector<ProtocolResult> poll_results;
+  std::vector<std::thread> clients;
+  for (std::size_t i = 0; i < n_threads; ++i)
+  {
+    clients.emplace_back([&](){
+      go_future.wait();
+      auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                             AsyncCommand::kInitialRequest,
+                                             AsyncPriority::kNormal, "key");
+      auto id = test::ExtractRequestId(reply);
+      const sup::dto::AnyValue id_payload = {{
+        { constants::ASYNC_ID_FIELD_NAME, id }
+      }};
+      reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone, AsyncCommand::kPoll);
+      std::lock_guard<std::mutex> lk{mtx};
+      ids.insert(id);
+      poll_results.push_back(ExtractProtocolResult(reply));
+    });
+  }
+  go.set_value();
+  for (auto& client : clients)
+  {
+    client.join();
+  }
+  EXPECT_EQ(ids.size(), 1);
+  for (const auto& result : poll_results)
+  {
+    EXPECT_EQ(result, Success);
+  }
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 1);
+  protocol.Open();
+}
+
+TEST_F(AsyncRequestServerTest, ConcurrentRequests)
+{
+  // Launch, poll and retrieve many requests concurrently
+  const std::size_t n_threads = 8;
+  const std::size_t n_requests = 50;
+  test::TestProtocol protocol{};
+  // TestProtocol is not threadsafe: use a single worker thread
+  AsyncInvokeServer async_server{protocol, kExpirationSec, CreateWorkerPool(1)};
+  std::mutex mtx;
+  std::set<sup::dto::uint64> ids;
+  std::vector<std::thread> clients;
+  for (std::size_t i = 0; i < n_threads; ++i)
+  {
+    clients.emplace_back([&](){
+      const sup::dto::AnyValue input{ sup::dto::StringType, "This is the request payload" };
+      for (std::size_t j = 0; j < n_requests; ++j)
+      {
+        auto reply = async_server.HandleInvoke(input, PayloadEncoding::kNone,
+                                               AsyncCommand::kInitialRequest);
+        auto id = test::ExtractRequestId(reply);
+        {
+          std::lock_guard<std::mutex> lk{mtx};
+          ids.insert(id);
+        }
+        const sup::dto::AnyValue id_payload = {{
+          { constants::ASYNC_ID_FIELD_NAME, id }
+        }};
+        ASSERT_TRUE(async_server.WaitForReady(id, 5.0));
+        reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone,
+                                          AsyncCommand::kPoll);
+        EXPECT_TRUE(test::ExtractReadyStatus(reply));
+        reply = async_server.HandleInvoke(id_payload, PayloadEncoding::kNone,
+                                          AsyncCommand::kGetReply);
+        EXPECT_EQ(ExtractProtocolResult(reply), Success);
+      }
+    });
+  }
+  for (auto& client : clients)
+  {
+    client.join();
+  }
+  // All identifiers are unique and all requests were removed after retrieving their reply
+  EXPECT_EQ(ids.size(), n_threads * n_requests);
+  EXPECT_EQ(ids.count(0), 0);
+  EXPECT_EQ(async_server.GetNumberOfRetainedRequests(), 0);
+  EXPECT_EQ(async_server.GetNumberOfActiveRequests(), 0);
+}
+
 AsyncRequestServerTest::AsyncRequestServerTest() = default;
 
 AsyncRequestServerTest::~AsyncRequestServerTest() = default;
@@ -21,20 +21,28 @@
 #include "test_protocol.h"
 
 #include <sup/protocol/base/async_invoke.h>
+#include <sup/protocol/base/worker_pool.h>
 
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <future>
+#include <thread>
+#include <utility>
 
 using namespace sup::protocol;
 
 const double kExpirationSec = 100;
 
+void WaitForBlocksReleased(const SlabPool& pool);
+
 class AsyncRequestTest : public ::testing::Test
 {
 protected:
   AsyncRequestTest();
   virtual ~AsyncRequestTest();
+
+  WorkerPool m_executor;
 };
 
 TEST_F(AsyncRequestTest, Construction)
@@ -43,7 +51,7 @@ TEST_F(AsyncRequestTest, Construction)
   sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
   std::promise<void> go;
   test::AsyncRequestTestProtocol protocol{go.get_future()};
-  AsyncInvoke req{protocol, input, kExpirationSec};
+  AsyncInvoke req{protocol, input, kExpirationSec, m_executor};
   EXPECT_FALSE(req.IsReady());
   EXPECT_FALSE(req.IsReadyForRemoval());
   auto reply = req.GetReply();
@@ -58,7 +66,7 @@ TEST_F(AsyncRequestTest, GetReply)
   sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
   std::promise<void> go;
   test::AsyncRequestTestProtocol protocol{go.get_future()};
-  AsyncInvoke req{protocol, input, kExpirationSec};
+  AsyncInvoke req{protocol, input, kExpirationSec, m_executor};
   EXPECT_FALSE(req.IsReady());
   EXPECT_FALSE(req.IsReadyForRemoval());
   go.set_value();
@@ -78,7 +86,7 @@ TEST_F(AsyncRequestTest, Invalidate)
   sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
   std::promise<void> go;
   test::AsyncRequestTestProtocol protocol{go.get_future()};
-  AsyncInvoke req{protocol, input, kExpirationSec};
+  AsyncInvoke req{protocol, input, kExpirationSec, m_executor};
   EXPECT_FALSE(req.IsReady());
   EXPECT_FALSE(req.IsReadyForRemoval());
   go.set_value();
@@ -91,6 +99,197 @@ TEST_F(AsyncRequestTest, Invalidate)
   EXPECT_NE(reply.second, input);
 }
 
-AsyncRequestTest::AsyncRequestTest() = default;
+TEST_F(AsyncRequestTest, CompletionHandle)
+{
+  // The completion handle can be used to wait for the reply, even after the request is gone.
+  sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol protocol{go.get_future()};
+  std::shared_ptr<CompletionHandle> completion;
+  {
+    AsyncInvoke req{protocol, input, kExpirationSec, m_executor};
+    completion = req.GetCompletionHandle();
+    ASSERT_TRUE(static_cast<bool>(completion));
+    EXPECT_FALSE(completion->IsReady());
+    go.set_value();
+    ASSERT_TRUE(completion->WaitForReady(1.0));
+    EXPECT_TRUE(req.IsReady());
+    auto reply = req.GetReply();
+    EXPECT_EQ(reply.first, Success);
+    // No completion handle after the reply was retrieved
+    EXPECT_FALSE(static_cast<bool>(req.GetCompletionHandle()));
+  }
+  EXPECT_TRUE(completion->IsReady());
+}
+
+TEST_F(AsyncRequestTest, ProtocolThrows)
+{
+  // Check that an exception thrown by the protocol is translated into a ProtocolResult.
+  sup::dto::AnyValue input = {{
+    { test::THROW_FIELD, {sup::dto::BooleanType, true }}
+  }};
+  test::TestProtocol protocol{};
+  AsyncInvoke req{protocol, input, kExpirationSec, m_executor};
+  ASSERT_TRUE(req.WaitForReady(1.0));
+  auto reply = req.GetReply();
+  EXPECT_EQ(reply.first, ServerProtocolException);
+  EXPECT_TRUE(sup::dto::IsEmptyValue(reply.second));
+  EXPECT_TRUE(req.IsReadyForRemoval());
+}
+
+TEST_F(AsyncRequestTest, CompletedCallback)
+{
+  // The completed callback is called with the result when the reply is ready
+  sup::dto::AnyValue input = {{
+    { test::THROW_FIELD, {sup::dto::BooleanType, true }}
+  }};
+  test::TestProtocol protocol{};
+  std::promise<std::pair<bool, ProtocolResult>> completed;
+  auto on_completed = [&completed](const ProtocolResult& result) {
+    completed.set_value({ true, result });
+  };
+  AsyncInvoke req{protocol, input, kExpirationSec, m_executor, {}, on_completed};
+  auto completed_future = completed.get_future();
+  ASSERT_EQ(completed_future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  EXPECT_TRUE(req.IsReady());
+  auto completed_info = completed_future.get();
+  EXPECT_TRUE(completed_info.first);
+  EXPECT_EQ(completed_info.second, ServerProtocolException);
+}
+
+TEST_F(AsyncRequestTest, CancelQueued)
+{
+  // A request that is invalidated before it started never calls the protocol
+  sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
+  std::promise<void> go;
+  test::AsyncRequestTestProtocol blocking_protocol{go.get_future()};
+  test::CancellableTestProtocol protocol{5.0};
+  int finished_count = 0;
+  AsyncInvoke blocking_req{blocking_protocol, input, kExpirationSec, m_executor};
+  {
+    AsyncInvoke req{protocol, input, kExpirationSec, m_executor,
+                    [&finished_count](std::size_t) { ++finished_count; }};
+    EXPECT_FALSE(req.IsReadyForRemoval());
+    req.Invalidate();
+    EXPECT_TRUE(req.IsReadyForRemoval());
+    EXPECT_EQ(finished_count, 1);
+  }
+  go.set_value();
+  ASSERT_TRUE(blocking_req.WaitForReady(1.0));
+  // The single worker has handled the dropped task by now
+  AsyncInvoke last_req{blocking_protocol, input, kExpirationSec, m_executor};
+  ASSERT_TRUE(last_req.WaitForReady(1.0));
+  EXPECT_EQ(protocol.GetNumberOfInvocations(), 0);
+  EXPECT_EQ(finished_count, 1);
+}
+
+TEST_F(AsyncRequestTest, CancelRunning)
+{
+  // A running request can detect its cancellation
+  sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
+  test::CancellableTestProtocol protocol{5.0};
+  AsyncInvoke req{protocol, input, kExpirationSec, m_executor};
+  auto completion = req.GetCompletionHandle();
+  ASSERT_TRUE(static_cast<bool>(completion));
+  while (protocol.GetNumberOfInvocations() == 0)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  req.Invalidate();
+  ASSERT_TRUE(completion->WaitForReady(1.0));
+  EXPECT_TRUE(req.IsReadyForRemoval());
+  EXPECT_EQ(protocol.GetNumberOfCancellations(), 1);
+}
+
+TEST_F(AsyncRequestTest, PooledAllocation)
+{
+  // The state of a request is allocated from the pool and returned when it is no longer used
+  sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
+  test::TestProtocol protocol{};
+  auto pool = std::make_shared<SlabPool>(4);
+  {
+    AsyncInvoke req{protocol, input, kExpirationSec, m_executor, {}, {}, {}, GetSteadyClock(),
+                    pool};
+    EXPECT_GT(pool->GetNumberOfBlocksInUse(), 0);
+    ASSERT_TRUE(req.WaitForReady(1.0));
+    auto reply = req.GetReply();
+    EXPECT_EQ(reply.first, Success);
+  }
+  WaitForBlocksReleased(*pool);
+  EXPECT_EQ(pool->GetNumberOfBlocksInUse(), 0);
+
+  // The memory is reused by the next request
+  const auto n_slabs = pool->GetNumberOfSlabs();
+  EXPECT_GT(n_slabs, 0);
+  for (int i = 0; i < 10; ++i)
+  {
+    AsyncInvoke req{protocol, input, kExpirationSec, m_executor, {}, {}, {}, GetSteadyClock(),
+                    pool};
+    ASSERT_TRUE(req.WaitForReady(1.0));
+    (void)req.GetReply();
+  }
+  WaitForBlocksReleased(*pool);
+  EXPECT_EQ(pool->GetNumberOfSlabs(), n_slabs);
+}
+
+TEST_F(AsyncRequestTest, PooledStateOutlivesRequest)
+{
+  // A task that still runs its completed callback keeps its state and the pool alive
+  sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
+  test::TestProtocol protocol{};
+  auto pool = std::make_shared<SlabPool>(4);
+  std::weak_ptr<SlabPool> weak_pool = pool;
+  std::promise<void> release;
+  auto release_future = release.get_future().share();
+  std::promise<void> done;
+  auto on_completed = [release_future, &done](const ProtocolResult&) {
+    release_future.wait();
+    done.set_value();
+  };
+  {
+    AsyncInvoke req{protocol, input, kExpirationSec, m_executor, {}, on_completed, {},
+                    GetSteadyClock(), std::move(pool)};
+    ASSERT_TRUE(req.WaitForReady(1.0));
+  }
+  EXPECT_FALSE(weak_pool.expired());
+  release.set_value();
+  auto done_future = done.get_future();
+  ASSERT_EQ(done_future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  // The single worker has released the state by the time it runs the next task
+  AsyncInvoke last_req{protocol, input, kExpirationSec, m_executor};
+  ASSERT_TRUE(last_req.WaitForReady(1.0));
+  EXPECT_TRUE(weak_pool.expired());
+}
+
+TEST_F(AsyncRequestTest, DroppedTask)
+{
+  // The state of a request is released when the executor destroys its task without running it
+  sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
+  test::TestProtocol protocol{};
+  test::ManualExecutor executor{};
+  auto pool = std::make_shared<SlabPool>(4);
+  {
+    AsyncInvoke req{protocol, input, kExpirationSec, executor, {}, {}, {}, GetSteadyClock(),
+                    pool};
+    EXPECT_TRUE(req.Invalidate());
+  }
+  EXPECT_GT(pool->GetNumberOfBlocksInUse(), 0);
+  executor.DropAll();
+  EXPECT_EQ(pool->GetNumberOfBlocksInUse(), 0);
+}
+
+AsyncRequestTest::AsyncRequestTest()
+  : m_executor{1}
+{}
 
 AsyncRequestTest::~AsyncRequestTest() = default;
+
+void WaitForBlocksReleased(const SlabPool& pool)
+{
+  // The executing task releases the state right after the reply became ready
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (pool.GetNumberOfBlocksInUse() > 0 && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
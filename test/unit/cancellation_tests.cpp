@@ -0,0 +1,94 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/cancellation_scope.h>
+#include <sup/protocol/base/completion_handle.h>
+
+#include <sup/protocol/cancellation.h>
+
+#include <gtest/gtest.h>
+
+using namespace sup::protocol;
+
+class CancellationTest : public ::testing::Test
+{
+protected:
+  CancellationTest();
+  virtual ~CancellationTest();
+};
+
+TEST_F(CancellationTest, OutsideInvocation)
+{
+  EXPECT_FALSE(IsInvocationCancelled());
+}
+
+TEST_F(CancellationTest, CancelBeforeStart)
+{
+  // A task that was cancelled before it started, will never start
+  CompletionHandle completion{};
+  EXPECT_FALSE(completion.IsCancelled());
+  EXPECT_TRUE(completion.Cancel());
+  EXPECT_TRUE(completion.IsCancelled());
+  EXPECT_FALSE(completion.TryStart());
+  // Cancelling again does not hand over the task again
+  EXPECT_FALSE(completion.Cancel());
+}
+
+TEST_F(CancellationTest, CancelAfterStart)
+{
+  CompletionHandle completion{};
+  EXPECT_TRUE(completion.TryStart());
+  EXPECT_FALSE(completion.TryStart());
+  EXPECT_FALSE(completion.Cancel());
+  EXPECT_TRUE(completion.IsCancelled());
+}
+
+TEST_F(CancellationTest, Scope)
+{
+  CompletionHandle completion{};
+  {
+    CancellationScope scope{completion};
+    EXPECT_FALSE(IsInvocationCancelled());
+    (void)completion.Cancel();
+    EXPECT_TRUE(IsInvocationCancelled());
+  }
+  EXPECT_FALSE(IsInvocationCancelled());
+}
+
+TEST_F(CancellationTest, NestedScopes)
+{
+  CompletionHandle outer{};
+  CompletionHandle inner{};
+  (void)outer.Cancel();
+  {
+    CancellationScope outer_scope{outer};
+    EXPECT_TRUE(IsInvocationCancelled());
+    {
+      CancellationScope inner_scope{inner};
+      EXPECT_FALSE(IsInvocationCancelled());
+    }
+    EXPECT_TRUE(IsInvocationCancelled());
+  }
+  EXPECT_FALSE(IsInvocationCancelled());
+}
+
+CancellationTest::CancellationTest() = default;
+
+CancellationTest::~CancellationTest() = default;
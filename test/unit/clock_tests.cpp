@@ -0,0 +1,83 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/clock.h>
+#include <sup/protocol/base/polling_timeout_handler.h>
+
+#include <gtest/gtest.h>
+
+using namespace sup::protocol;
+
+class ClockTest : public ::testing::Test
+{
+protected:
+  ClockTest();
+  virtual ~ClockTest();
+};
+
+TEST_F(ClockTest, SteadyClock)
+{
+  const auto& clock = GetSteadyClock();
+  auto first = clock.GetTimestamp();
+  auto second = clock.GetTimestamp();
+  EXPECT_LE(first, second);
+  EXPECT_EQ(&clock, &GetSteadyClock());
+}
+
+TEST_F(ClockTest, CoarseClock)
+{
+  // The coarse clock lags the steady clock by at most one tick
+  const auto& clock = GetCoarseClock();
+  auto first = clock.GetTimestamp();
+  auto steady = GetSteadyClock().GetTimestamp();
+  auto second = clock.GetTimestamp();
+  EXPECT_LE(first, second);
+  EXPECT_LE(first, steady);
+  EXPECT_LT(steady - first, 100000000u);
+}
+
+TEST_F(ClockTest, VirtualClock)
+{
+  VirtualClock clock{};
+  EXPECT_EQ(clock.GetTimestamp(), 0);
+  clock.Advance(1.5);
+  EXPECT_EQ(clock.GetTimestamp(), 1500000000u);
+  clock.Advance(0.0);
+  EXPECT_EQ(clock.GetTimestamp(), 1500000000u);
+}
+
+TEST_F(ClockTest, PollingTimeoutHandler)
+{
+  // The timeout only passes when the virtual clock is advanced
+  VirtualClock clock{};
+  PollingTimeoutHandler handler{1.0, 0.0, clock};
+  EXPECT_DOUBLE_EQ(handler.GetRemainingTime(), 1.0);
+  EXPECT_TRUE(handler.Wait());
+  clock.Advance(0.75);
+  EXPECT_DOUBLE_EQ(handler.GetRemainingTime(), 0.25);
+  EXPECT_TRUE(handler.Wait());
+  clock.Advance(0.5);
+  EXPECT_DOUBLE_EQ(handler.GetRemainingTime(), 0.0);
+  EXPECT_FALSE(handler.Wait());
+}
+
+ClockTest::ClockTest() = default;
+
+ClockTest::~ClockTest() = default;
@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/completion_time_estimator.h>
+
+#include <sup/protocol/exceptions.h>
+
+#include <gtest/gtest.h>
+
+using namespace sup::protocol;
+
+class CompletionTimeEstimatorTest : public ::testing::Test
+{
+protected:
+  CompletionTimeEstimatorTest();
+  virtual ~CompletionTimeEstimatorTest();
+};
+
+TEST_F(CompletionTimeEstimatorTest, Construction)
+{
+  EXPECT_NO_THROW(CompletionTimeEstimator(0.5, 10));
+  EXPECT_NO_THROW(CompletionTimeEstimator(1.0, 10));
+  EXPECT_THROW(CompletionTimeEstimator(0.0, 10), InvalidOperationException);
+  EXPECT_THROW(CompletionTimeEstimator(-0.1, 10), InvalidOperationException);
+  EXPECT_THROW(CompletionTimeEstimator(1.5, 10), InvalidOperationException);
+}
+
+TEST_F(CompletionTimeEstimatorTest, MovingAverage)
+{
+  CompletionTimeEstimator estimator{0.5, 10};
+  EXPECT_EQ(estimator.GetEstimate("func"), 0.0);
+  EXPECT_EQ(estimator.GetNumberOfShapes(), 0);
+
+  // The first completion time is the initial estimate
+  estimator.Record("func", 2000000000u);
+  EXPECT_DOUBLE_EQ(estimator.GetEstimate("func"), 2.0);
+
+  // Later completion times move the estimate by the smoothing factor
+  estimator.Record("func", 1000000000u);
+  EXPECT_DOUBLE_EQ(estimator.GetEstimate("func"), 1.5);
+  estimator.Record("func", 3500000000u);
+  EXPECT_DOUBLE_EQ(estimator.GetEstimate("func"), 2.5);
+  EXPECT_EQ(estimator.GetNumberOfShapes(), 1);
+}
+
+TEST_F(CompletionTimeEstimatorTest, SeparateShapes)
+{
+  CompletionTimeEstimator estimator{0.5, 2};
+  estimator.Record("", 1000000u);
+  estimator.Record("func", 2000000u);
+  EXPECT_DOUBLE_EQ(estimator.GetEstimate(""), 0.001);
+  EXPECT_DOUBLE_EQ(estimator.GetEstimate("func"), 0.002);
+  EXPECT_EQ(estimator.GetNumberOfShapes(), 2);
+
+  // New shapes are ignored once the maximum is reached
+  estimator.Record("other", 3000000u);
+  EXPECT_EQ(estimator.GetEstimate("other"), 0.0);
+  EXPECT_EQ(estimator.GetNumberOfShapes(), 2);
+  estimator.Record("func", 4000000u);
+  EXPECT_DOUBLE_EQ(estimator.GetEstimate("func"), 0.003);
+}
+
+CompletionTimeEstimatorTest::CompletionTimeEstimatorTest() = default;
+
+CompletionTimeEstimatorTest::~CompletionTimeEstimatorTest() = default;
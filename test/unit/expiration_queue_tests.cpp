@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/expiration_queue.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace sup::protocol;
+
+class ExpirationQueueTest : public ::testing::Test
+{
+protected:
+  ExpirationQueueTest();
+  virtual ~ExpirationQueueTest();
+};
+
+TEST_F(ExpirationQueueTest, Construction)
+{
+  ExpirationQueue queue{};
+  EXPECT_EQ(queue.GetSize(), 0);
+  EXPECT_TRUE(queue.PopExpired(1000u).empty());
+}
+
+TEST_F(ExpirationQueueTest, PopExpired)
+{
+  ExpirationQueue queue{};
+  queue.Push(1u, 300u);
+  queue.Push(2u, 100u);
+  queue.Push(3u, 200u);
+  queue.Push(4u, 400u);
+  EXPECT_EQ(queue.GetSize(), 4);
+
+  // Nothing expired yet
+  EXPECT_TRUE(queue.PopExpired(50u).empty());
+  EXPECT_EQ(queue.GetSize(), 4);
+
+  // Expired entries are returned in order of their deadline
+  auto expired = queue.PopExpired(300u);
+  const std::vector<sup::dto::uint64> expected = { 2u, 3u, 1u };
+  EXPECT_EQ(expired, expected);
+  EXPECT_EQ(queue.GetSize(), 1);
+
+  // Same identifier can be pushed again
+  queue.Push(2u, 350u);
+  expired = queue.PopExpired(1000u);
+  const std::vector<sup::dto::uint64> expected_last = { 2u, 4u };
+  EXPECT_EQ(expired, expected_last);
+  EXPECT_EQ(queue.GetSize(), 0);
+}
+
+TEST_F(ExpirationQueueTest, Clear)
+{
+  ExpirationQueue queue{};
+  queue.Push(1u, 100u);
+  queue.Push(2u, 200u);
+  queue.Clear();
+  EXPECT_EQ(queue.GetSize(), 0);
+  EXPECT_TRUE(queue.PopExpired(1000u).empty());
+}
+
+ExpirationQueueTest::ExpirationQueueTest() = default;
+
+ExpirationQueueTest::~ExpirationQueueTest() = default;
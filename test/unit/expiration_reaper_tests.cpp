@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/expiration_reaper.h>
+
+#include <sup/protocol/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace sup::protocol;
+
+class ExpirationReaperTest : public ::testing::Test
+{
+protected:
+  ExpirationReaperTest();
+  virtual ~ExpirationReaperTest();
+};
+
+TEST_F(ExpirationReaperTest, Construction)
+{
+  EXPECT_THROW(ExpirationReaper([](){}, 0.0), InvalidOperationException);
+  EXPECT_THROW(ExpirationReaper([](){}, -1.0), InvalidOperationException);
+  EXPECT_NO_THROW(ExpirationReaper([](){}, 100.0));
+}
+
+TEST_F(ExpirationReaperTest, PeriodicCleanUp)
+{
+  std::atomic<int> counter{0};
+  {
+    ExpirationReaper reaper{[&counter](){ ++counter; }, 0.01};
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  // No more clean up after destruction
+  auto final_count = counter.load();
+  EXPECT_GE(final_count, 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_EQ(counter.load(), final_count);
+}
+
+TEST_F(ExpirationReaperTest, ThrowingCleanUp)
+{
+  // A throwing clean up function does not stop the reaper
+  std::atomic<int> counter{0};
+  ExpirationReaper reaper{[&counter](){
+    ++counter;
+    throw std::runtime_error("Throwing on demand");
+  }, 0.01};
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_GE(counter.load(), 2);
+}
+
+ExpirationReaperTest::ExpirationReaperTest() = default;
+
+ExpirationReaperTest::~ExpirationReaperTest() = default;
@@ -18,12 +18,15 @@
  * of the distribution package.
  ******************************************************************************/
 
+#include <sup/protocol/base/clock.h>
 #include <sup/protocol/base/expiration_timeout_handler.h>
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <chrono>
 #include <thread>
+#include <vector>
 
 using namespace sup::protocol;
 
@@ -52,6 +55,45 @@ TEST_F(ExpirationTimeoutHandlerTest, UpdatedHandler)
   EXPECT_FALSE(handler.IsCleanUpNeeded());
 }
 
+TEST_F(ExpirationTimeoutHandlerTest, VirtualClock)
+{
+  // First query will always return true, even when the clock is at zero
+  VirtualClock clock{};
+  ExpirationTimeoutHandler handler{1.0, clock};
+  EXPECT_TRUE(handler.IsCleanUpNeeded());
+  EXPECT_FALSE(handler.IsCleanUpNeeded());
+  clock.Advance(1.0);
+  EXPECT_FALSE(handler.IsCleanUpNeeded());
+  clock.Advance(0.001);
+  EXPECT_TRUE(handler.IsCleanUpNeeded());
+  EXPECT_FALSE(handler.IsCleanUpNeeded());
+}
+
+TEST_F(ExpirationTimeoutHandlerTest, ConcurrentQueries)
+{
+  // Only one of the concurrent queries is told to clean up
+  ExpirationTimeoutHandler handler{5.0};
+  std::atomic<int> n_cleanups{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i)
+  {
+    threads.emplace_back([&handler, &n_cleanups](){
+      for (int j = 0; j < 100; ++j)
+      {
+        if (handler.IsCleanUpNeeded())
+        {
+          ++n_cleanups;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_EQ(n_cleanups.load(), 1);
+}
+
 ExpirationTimeoutHandlerTest::ExpirationTimeoutHandlerTest() = default;
 
 ExpirationTimeoutHandlerTest::~ExpirationTimeoutHandlerTest() = default;
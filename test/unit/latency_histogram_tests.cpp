@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/latency_histogram.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace sup::protocol;
+
+class LatencyHistogramTest : public ::testing::Test
+{
+protected:
+  LatencyHistogramTest();
+  virtual ~LatencyHistogramTest();
+};
+
+TEST_F(LatencyHistogramTest, Buckets)
+{
+  // Small values have their own bucket
+  for (sup::dto::uint64 value = 0; value < 16; ++value)
+  {
+    EXPECT_EQ(GetLatencyBucketIndex(value), value);
+    EXPECT_EQ(GetLatencyBucketUpperBound(value), value);
+  }
+  EXPECT_EQ(GetLatencyBucketIndex(16), 16);
+  EXPECT_EQ(GetLatencyBucketIndex(31), 31);
+  EXPECT_EQ(GetLatencyBucketIndex(32), 32);
+  EXPECT_EQ(GetLatencyBucketIndex(33), 32);
+  EXPECT_EQ(GetLatencyBucketUpperBound(32), 33);
+  EXPECT_EQ(GetLatencyBucketIndex(~sup::dto::uint64{0}), kNumberOfLatencyBuckets - 1);
+  EXPECT_EQ(GetLatencyBucketUpperBound(kNumberOfLatencyBuckets - 1), ~sup::dto::uint64{0});
+
+  // Each value falls within the bounds of its bucket, which are accurate to 1/16
+  for (sup::dto::uint64 value = 1; value < (sup::dto::uint64{1} << 40); value = value * 3 + 1)
+  {
+    auto index = GetLatencyBucketIndex(value);
+    auto upper_bound = GetLatencyBucketUpperBound(index);
+    EXPECT_GE(upper_bound, value);
+    EXPECT_LE(upper_bound - value, value / 16);
+    EXPECT_LT(GetLatencyBucketUpperBound(index - 1), value);
+  }
+}
+
+TEST_F(LatencyHistogramTest, RecordAndSnapshot)
+{
+  LatencyHistogram histogram{};
+  auto empty = histogram.GetSnapshot();
+  EXPECT_EQ(empty.GetCount(), 0);
+  EXPECT_EQ(empty.GetMean(), 0.0);
+  EXPECT_EQ(empty.GetPercentile(0.5), 0.0);
+
+  // 1 to 100 milliseconds
+  for (sup::dto::uint64 ms = 1; ms <= 100; ++ms)
+  {
+    histogram.Record(ms * 1000000);
+  }
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.GetCount(), 100);
+  EXPECT_DOUBLE_EQ(snapshot.GetMinimum(), 0.001);
+  EXPECT_DOUBLE_EQ(snapshot.GetMaximum(), 0.1);
+  EXPECT_NEAR(snapshot.GetMean(), 0.0505, 1e-9);
+  EXPECT_NEAR(snapshot.GetPercentile(0.5), 0.050, 0.050 / 16);
+  EXPECT_NEAR(snapshot.GetPercentile(0.99), 0.099, 0.099 / 16);
+  EXPECT_DOUBLE_EQ(snapshot.GetPercentile(0.0), 0.001);
+  EXPECT_DOUBLE_EQ(snapshot.GetPercentile(1.0), 0.1);
+
+  // Snapshots are not affected by a reset
+  histogram.Reset();
+  EXPECT_EQ(histogram.GetSnapshot().GetCount(), 0);
+  EXPECT_EQ(histogram.GetSnapshot().GetMaximum(), 0.0);
+  EXPECT_EQ(snapshot.GetCount(), 100);
+}
+
+TEST_F(LatencyHistogramTest, ConcurrentRecords)
+{
+  LatencyHistogram histogram{};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([&histogram, i](){
+      for (sup::dto::uint64 j = 0; j < 1000; ++j)
+      {
+        histogram.Record(i * 1000 + j);
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.GetCount(), 4000);
+  EXPECT_EQ(snapshot.GetMinimum(), 0.0);
+  EXPECT_DOUBLE_EQ(snapshot.GetMaximum(), 3999e-9);
+}
+
+LatencyHistogramTest::LatencyHistogramTest() = default;
+
+LatencyHistogramTest::~LatencyHistogramTest() = default;
@@ -0,0 +1,230 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include "test_protocol.h"
+
+#include <sup/protocol/base/priority_scheduler.h>
+#include <sup/protocol/base/worker_pool.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace sup::protocol;
+
+class PrioritySchedulerTest : public ::testing::Test
+{
+protected:
+  PrioritySchedulerTest();
+  virtual ~PrioritySchedulerTest();
+
+  // Submit a task to the scheduler that records its priority
+  void SubmitTask(PriorityScheduler& scheduler, AsyncPriority priority);
+
+  // Wait until all submitted tasks have run
+  bool WaitForTasks();
+
+  std::vector<AsyncPriority> m_order;
+  std::promise<void> m_done;
+  std::size_t m_expected;
+};
+
+TEST_F(PrioritySchedulerTest, HighestPriorityFirst)
+{
+  WorkerPool pool{1};
+  PriorityScheduler scheduler{pool, 10};
+  // Block the only worker thread until all tasks are queued
+  std::promise<void> go;
+  auto go_future = go.get_future();
+  pool.Submit([&go_future](){ go_future.wait(); });
+  SubmitTask(scheduler, AsyncPriority::kLow);
+  SubmitTask(scheduler, AsyncPriority::kHigh);
+  SubmitTask(scheduler, AsyncPriority::kNormal);
+  SubmitTask(scheduler, AsyncPriority::kNormal);
+  SubmitTask(scheduler, AsyncPriority::kHigh);
+  go.set_value();
+  ASSERT_TRUE(WaitForTasks());
+  const std::vector<AsyncPriority> expected = { AsyncPriority::kHigh, AsyncPriority::kHigh,
+                                                AsyncPriority::kNormal, AsyncPriority::kNormal,
+                                                AsyncPriority::kLow };
+  EXPECT_EQ(m_order, expected);
+}
+
+TEST_F(PrioritySchedulerTest, NoStarvation)
+{
+  WorkerPool pool{1};
+  PriorityScheduler scheduler{pool, 2};
+  std::promise<void> go;
+  auto go_future = go.get_future();
+  pool.Submit([&go_future](){ go_future.wait(); });
+  SubmitTask(scheduler, AsyncPriority::kLow);
+  for (int i = 0; i < 5; ++i)
+  {
+    SubmitTask(scheduler, AsyncPriority::kHigh);
+  }
+  go.set_value();
+  ASSERT_TRUE(WaitForTasks());
+  // The low priority task is run after being passed over twice
+  const std::vector<AsyncPriority> expected = { AsyncPriority::kHigh, AsyncPriority::kHigh,
+                                                AsyncPriority::kLow, AsyncPriority::kHigh,
+                                                AsyncPriority::kHigh, AsyncPriority::kHigh };
+  EXPECT_EQ(m_order, expected);
+}
+
+TEST_F(PrioritySchedulerTest, PriorityExecutor)
+{
+  WorkerPool pool{1};
+  PriorityScheduler scheduler{pool, 10};
+  std::promise<void> go;
+  auto go_future = go.get_future();
+  pool.Submit([&go_future](){ go_future.wait(); });
+  SubmitTask(scheduler, AsyncPriority::kLow);
+  auto& high_executor = scheduler.GetExecutor(AsyncPriority::kHigh);
+  ++m_expected;
+  high_executor.Submit([this](){
+    m_order.push_back(AsyncPriority::kHigh);
+    if (m_order.size() == m_expected)
+    {
+      m_done.set_value();
+    }
+  });
+  go.set_value();
+  ASSERT_TRUE(WaitForTasks());
+  const std::vector<AsyncPriority> expected = { AsyncPriority::kHigh, AsyncPriority::kLow };
+  EXPECT_EQ(m_order, expected);
+}
+
+TEST_F(PrioritySchedulerTest, NormalPriorityBypass)
+{
+  // Without queued tasks of normal or high priority, normal tasks go straight to the executor, so
+  // the scheduler does not wait for them
+  test::ManualExecutor executor{};
+  int n_runs = 0;
+  {
+    PriorityScheduler scheduler{executor, 10};
+    scheduler.Submit([&n_runs](){ ++n_runs; }, AsyncPriority::kNormal);
+  }
+  executor.RunAll();
+  EXPECT_EQ(n_runs, 1);
+
+  // A queued low priority task does not prevent this
+  {
+    PriorityScheduler scheduler{executor, 10};
+    SubmitTask(scheduler, AsyncPriority::kLow);
+    SubmitTask(scheduler, AsyncPriority::kNormal);
+    executor.RunAll();
+  }
+  ASSERT_TRUE(WaitForTasks());
+  const std::vector<AsyncPriority> expected = { AsyncPriority::kLow, AsyncPriority::kNormal };
+  EXPECT_EQ(m_order, expected);
+}
+
+TEST_F(PrioritySchedulerTest, DestructionWaitsForDispatch)
+{
+  // The scheduler cannot be destroyed while the executor still holds one of its dispatch tasks
+  test::ManualExecutor executor{};
+  auto scheduler = std::make_unique<PriorityScheduler>(executor, 10);
+  SubmitTask(*scheduler, AsyncPriority::kLow);
+  auto destroyed = std::async(std::launch::async, [&scheduler](){ scheduler.reset(); });
+  EXPECT_EQ(destroyed.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+  executor.RunAll();
+  EXPECT_EQ(destroyed.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  ASSERT_TRUE(WaitForTasks());
+  const std::vector<AsyncPriority> expected = { AsyncPriority::kLow };
+  EXPECT_EQ(m_order, expected);
+}
+
+TEST_F(PrioritySchedulerTest, Withdraw)
+{
+  // A withdrawn task is released immediately and never runs
+  test::ManualExecutor executor{};
+  PriorityScheduler scheduler{executor, 10};
+  auto sentinel = std::make_shared<int>(0);
+  bool withdrawn_ran = false;
+  auto sequence = scheduler.Submit([sentinel, &withdrawn_ran](){ withdrawn_ran = true; },
+                                   AsyncPriority::kHigh);
+  EXPECT_NE(sequence, 0);
+  SubmitTask(scheduler, AsyncPriority::kLow);
+  EXPECT_EQ(sentinel.use_count(), 2);
+  EXPECT_TRUE(scheduler.Withdraw(sequence));
+  EXPECT_EQ(sentinel.use_count(), 1);
+  EXPECT_FALSE(scheduler.Withdraw(sequence));
+
+  // Both dispatch tasks still run: one runs the remaining task, the other nothing
+  executor.RunAll();
+  ASSERT_TRUE(WaitForTasks());
+  EXPECT_FALSE(withdrawn_ran);
+  const std::vector<AsyncPriority> expected = { AsyncPriority::kLow };
+  EXPECT_EQ(m_order, expected);
+
+  // Tasks that went straight to the executor cannot be withdrawn
+  EXPECT_EQ(scheduler.Submit([](){}, AsyncPriority::kNormal), 0);
+  executor.RunAll();
+}
+
+TEST_F(PrioritySchedulerTest, ExecutorThrows)
+{
+  // A task whose dispatch task could not be submitted is not queued
+  test::ManualExecutor executor{};
+  {
+    PriorityScheduler scheduler{executor, 10};
+    executor.SetRefuse(true);
+    bool task_ran = false;
+    EXPECT_THROW(scheduler.Submit([&task_ran](){ task_ran = true; }, AsyncPriority::kHigh),
+                 std::runtime_error);
+    executor.SetRefuse(false);
+    SubmitTask(scheduler, AsyncPriority::kLow);
+    executor.RunAll();
+    EXPECT_FALSE(task_ran);
+  }
+  ASSERT_TRUE(WaitForTasks());
+  const std::vector<AsyncPriority> expected = { AsyncPriority::kLow };
+  EXPECT_EQ(m_order, expected);
+}
+
+PrioritySchedulerTest::PrioritySchedulerTest()
+  : m_order{}
+  , m_done{}
+  , m_expected{0}
+{}
+
+PrioritySchedulerTest::~PrioritySchedulerTest() = default;
+
+void PrioritySchedulerTest::SubmitTask(PriorityScheduler& scheduler, AsyncPriority priority)
+{
+  ++m_expected;
+  scheduler.Submit([this, priority](){
+    m_order.push_back(priority);
+    if (m_order.size() == m_expected)
+    {
+      m_done.set_value();
+    }
+  }, priority);
+}
+
+bool PrioritySchedulerTest::WaitForTasks()
+{
+  auto future = m_done.get_future();
+  return future.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+}
@@ -152,6 +152,16 @@ TEST_F(ProtocolResultTest, Copy)
   EXPECT_EQ(result.GetValue(), AsynchronousProtocolTimeout.GetValue());
   EXPECT_EQ(result, AsynchronousProtocolTimeout);
 
+  // ServerBusy
+  result = ServerBusy;
+  EXPECT_EQ(result.GetValue(), ServerBusy.GetValue());
+  EXPECT_EQ(result, ServerBusy);
+
+  // AsynchronousReplyEvicted
+  result = AsynchronousReplyEvicted;
+  EXPECT_EQ(result.GetValue(), AsynchronousReplyEvicted.GetValue());
+  EXPECT_EQ(result, AsynchronousReplyEvicted);
+
   // Custom result
   ProtocolResult custom_result{42};
   result = custom_result;
@@ -240,6 +250,14 @@ TEST_F(ProtocolResultTest, ToString)
   result = AsynchronousProtocolTimeout;
   EXPECT_EQ(ProtocolResultToString(result), "AsynchronousProtocolTimeout");
 
+  // ServerBusy
+  result = ServerBusy;
+  EXPECT_EQ(ProtocolResultToString(result), "ServerBusy");
+
+  // AsynchronousReplyEvicted
+  result = AsynchronousReplyEvicted;
+  EXPECT_EQ(ProtocolResultToString(result), "AsynchronousReplyEvicted");
+
   // Custom result
   ProtocolResult custom_result{42};
   result = custom_result;
@@ -279,6 +297,8 @@ TEST_F(ProtocolResultTest, Comparison)
   EXPECT_TRUE(custom_result != ServerProtocolException);
   EXPECT_TRUE(custom_result != ClientTransportException);
   EXPECT_TRUE(custom_result != AsynchronousProtocolTimeout);
+  EXPECT_TRUE(custom_result != ServerBusy);
+  EXPECT_TRUE(custom_result != AsynchronousReplyEvicted);
   EXPECT_FALSE(custom_result != ProtocolResult(42u));
 }
 
@@ -27,6 +27,9 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <vector>
+
 using namespace sup::protocol;
 
 using ::testing::_;
@@ -227,10 +230,18 @@ TEST_F(ProtocolRPCClientAsyncTest, ThrowOnNewRequest)
   ProtocolRPCClient rpc_client{mock_functor, client_config};
   sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
   sup::dto::AnyValue output{};
-  // Check asynchronous invoke:
-  EXPECT_CALL(mock_functor, CallOperator(_)).Times(1);
+  // Check asynchronous invoke: the initial request is retried before giving up
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(1 + client_config.m_start_retries);
   EXPECT_EQ(rpc_client.Invoke(input, output), ClientTransportException);
   EXPECT_TRUE(sup::dto::IsEmptyValue(output));
+  ::testing::Mock::VerifyAndClearExpectations(&mock_functor);
+
+  // Check asynchronous invoke without retries:
+  client_config.m_start_retries = 0;
+  ProtocolRPCClient no_retry_client{mock_functor, client_config};
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(1);
+  EXPECT_EQ(no_retry_client.Invoke(input, output), ClientTransportException);
+  EXPECT_TRUE(sup::dto::IsEmptyValue(output));
 }
 
 TEST_F(ProtocolRPCClientAsyncTest, UnknownEncodingInPoll)
@@ -265,7 +276,8 @@ TEST_F(ProtocolRPCClientAsyncTest, UnknownEncodingInPoll)
   sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
   sup::dto::AnyValue output{};
   // Check for correct error in reponse to Invoke:
-  EXPECT_CALL(mock_functor, CallOperator(_)).Times(2);
+  // The failed request is invalidated when the client gives up on it
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(3);
   EXPECT_EQ(rpc_client.Invoke(input, output), ClientTransportDecodingError);
   EXPECT_TRUE(sup::dto::IsEmptyValue(output));
 }
@@ -301,7 +313,8 @@ TEST_F(ProtocolRPCClientAsyncTest, MissingReadyStateInPoll)
   sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
   sup::dto::AnyValue output{};
   // Check for correct error in reponse to Invoke:
-  EXPECT_CALL(mock_functor, CallOperator(_)).Times(2);
+  // The failed request is invalidated when the client gives up on it
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(3);
   EXPECT_EQ(rpc_client.Invoke(input, output), ClientTransportDecodingError);
   EXPECT_TRUE(sup::dto::IsEmptyValue(output));
 }
@@ -370,7 +383,8 @@ TEST_F(ProtocolRPCClientAsyncTest, ThrowOnPoll)
   sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
   sup::dto::AnyValue output{};
   // Check asynchronous invoke:
-  EXPECT_CALL(mock_functor, CallOperator(_)).Times(2);
+  // The failed request is invalidated when the client gives up on it
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(3);
   EXPECT_EQ(rpc_client.Invoke(input, output), ClientTransportException);
   EXPECT_TRUE(sup::dto::IsEmptyValue(output));
 }
@@ -445,7 +459,8 @@ TEST_F(ProtocolRPCClientAsyncTest, NoProtocolResultInGetReply)
   sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
   sup::dto::AnyValue output{};
   // Check for correct error in reponse to Invoke:
-  EXPECT_CALL(mock_functor, CallOperator(_)).Times(3);
+  // The failed request is invalidated when the client gives up on it
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(4);
   EXPECT_EQ(rpc_client.Invoke(input, output), ClientTransportDecodingError);
   EXPECT_TRUE(sup::dto::IsEmptyValue(output));
 }
@@ -517,7 +532,8 @@ TEST_F(ProtocolRPCClientAsyncTest, ThrowOnGetReply)
   sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
   sup::dto::AnyValue output{};
   // Check asynchronous invoke:
-  EXPECT_CALL(mock_functor, CallOperator(_)).Times(3);
+  // The failed request is invalidated when the client gives up on it
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(4);
   EXPECT_EQ(rpc_client.Invoke(input, output), ClientTransportException);
   EXPECT_TRUE(sup::dto::IsEmptyValue(output));
 }
@@ -585,6 +601,162 @@ TEST_F(ProtocolRPCClientAsyncTest, SynchronousOnlyServerWithException)
   EXPECT_TRUE(sup::dto::IsEmptyValue(output));
 }
 
+TEST_F(ProtocolRPCClientAsyncTest, RetryWhenServerBusy)
+{
+  // Create function that rejects the first two requests because the server is busy:
+  int n_busy = 2;
+  auto func = [&n_busy](const sup::dto::AnyValue& input) {
+    auto async_info = utils::GetAsyncInfo(input);
+    if (!async_info.first)
+    {
+      throw InvalidOperationException("No synchronous support");
+    }
+    switch (async_info.second)
+    {
+    case AsyncCommand::kInitialRequest:
+      if (n_busy > 0)
+      {
+        --n_busy;
+        return utils::CreateAsyncRPCReply(ServerBusy, AsyncCommand::kInitialRequest);
+      }
+      return utils::CreateAsyncRPCNewRequestReply(42u, PayloadEncoding::kNone);
+    case AsyncCommand::kPoll:
+      return utils::CreateAsyncRPCPollReply(true, PayloadEncoding::kBase64);
+    case AsyncCommand::kGetReply:
+      return utils::CreateAsyncRPCReply(Success, kReplyPayload, PayloadEncoding::kNone,
+                                        AsyncCommand::kGetReply);
+    default:
+      break;
+    }
+    throw InvalidOperationException("Unknown async command");
+  };
+  // Inject function into mock functor:
+  ::testing::StrictMock<test::MockFunctor> mock_functor;
+  mock_functor.DelegateTo(func);
+  // Create client:
+  ProtocolRPCClientConfig client_config{PayloadEncoding::kBase64, 1.0, 0.02};
+  ProtocolRPCClient rpc_client{mock_functor, client_config};
+  sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
+  sup::dto::AnyValue output{};
+  // Check successful asynchronous invoke after retrying the initial request:
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(5);
+  EXPECT_EQ(rpc_client.Invoke(input, output), Success);
+  EXPECT_EQ(output, kReplyPayload);
+}
+
+TEST_F(ProtocolRPCClientAsyncTest, ServerAlwaysBusy)
+{
+  // Create function that always rejects new requests because the server is busy:
+  auto func = [](const sup::dto::AnyValue& input) {
+    auto async_info = utils::GetAsyncInfo(input);
+    if (!async_info.first || async_info.second != AsyncCommand::kInitialRequest)
+    {
+      throw InvalidOperationException("Only initial requests are expected");
+    }
+    return utils::CreateAsyncRPCReply(ServerBusy, AsyncCommand::kInitialRequest);
+  };
+  // Inject function into mock functor:
+  ::testing::StrictMock<test::MockFunctor> mock_functor;
+  mock_functor.DelegateTo(func);
+  // Create client:
+  ProtocolRPCClientConfig client_config{PayloadEncoding::kBase64, 0.1, 0.02};
+  ProtocolRPCClient rpc_client{mock_functor, client_config};
+  sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
+  sup::dto::AnyValue output{};
+  // Check that the client gives up after its timeout:
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(AtLeast(2));
+  EXPECT_EQ(rpc_client.Invoke(input, output), ServerBusy);
+  EXPECT_TRUE(sup::dto::IsEmptyValue(output));
+}
+
+TEST_F(ProtocolRPCClientAsyncTest, FollowRetryAfter)
+{
+  // Create function that suggests when to poll and records the time of each poll:
+  using Clock = std::chrono::steady_clock;
+  std::vector<Clock::time_point> call_times;
+  auto func = [&call_times](const sup::dto::AnyValue& input) {
+    call_times.push_back(Clock::now());
+    auto async_info = utils::GetAsyncInfo(input);
+    if (!async_info.first)
+    {
+      throw InvalidOperationException("No synchronous support");
+    }
+    switch (async_info.second)
+    {
+    case AsyncCommand::kInitialRequest:
+      return utils::CreateAsyncRPCNewRequestReply(42u, PayloadEncoding::kNone, 0.0, 0.2);
+    case AsyncCommand::kPoll:
+      if (call_times.size() < 3)
+      {
+        return utils::CreateAsyncRPCPollReply(false, PayloadEncoding::kNone, 0.1);
+      }
+      return utils::CreateAsyncRPCPollReply(true, PayloadEncoding::kNone);
+    case AsyncCommand::kGetReply:
+      return utils::CreateAsyncRPCReply(Success, kReplyPayload, PayloadEncoding::kNone,
+                                        AsyncCommand::kGetReply);
+    default:
+      break;
+    }
+    throw InvalidOperationException("Unknown async command");
+  };
+  // Inject function into mock functor:
+  ::testing::StrictMock<test::MockFunctor> mock_functor;
+  mock_functor.DelegateTo(func);
+  // Create client with a short polling interval:
+  ProtocolRPCClientConfig client_config{PayloadEncoding::kNone, 5.0, 0.01};
+  ProtocolRPCClient rpc_client{mock_functor, client_config};
+  sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
+  sup::dto::AnyValue output{};
+  // Check that the polls follow the suggested delays instead of the polling interval:
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(4);
+  EXPECT_EQ(rpc_client.Invoke(input, output), Success);
+  EXPECT_EQ(output, kReplyPayload);
+  ASSERT_EQ(call_times.size(), 4u);
+  EXPECT_GE(call_times[1] - call_times[0], std::chrono::milliseconds(200));
+  EXPECT_GE(call_times[2] - call_times[1], std::chrono::milliseconds(100));
+}
+
+TEST_F(ProtocolRPCClientAsyncTest, RequestPriority)
+{
+  // Create function that only accepts high priority requests:
+  auto func = [](const sup::dto::AnyValue& input) {
+    auto async_info = utils::GetAsyncInfo(input);
+    if (!async_info.first)
+    {
+      throw InvalidOperationException("No synchronous support");
+    }
+    switch (async_info.second)
+    {
+    case AsyncCommand::kInitialRequest:
+      if (utils::GetAsyncPriority(input) != AsyncPriority::kHigh)
+      {
+        return utils::CreateAsyncRPCReply(ServerBusy, AsyncCommand::kInitialRequest);
+      }
+      return utils::CreateAsyncRPCNewRequestReply(42u, PayloadEncoding::kNone);
+    case AsyncCommand::kPoll:
+      return utils::CreateAsyncRPCPollReply(true, PayloadEncoding::kBase64);
+    case AsyncCommand::kGetReply:
+      return utils::CreateAsyncRPCReply(Success, kReplyPayload, PayloadEncoding::kNone,
+                                        AsyncCommand::kGetReply);
+    default:
+      break;
+    }
+    throw InvalidOperationException("Unknown async command");
+  };
+  // Inject function into mock functor:
+  ::testing::StrictMock<test::MockFunctor> mock_functor;
+  mock_functor.DelegateTo(func);
+  // Create client with high priority:
+  ProtocolRPCClientConfig client_config{PayloadEncoding::kBase64, 0.2, 0.02};
+  client_config.m_priority = AsyncPriority::kHigh;
+  ProtocolRPCClient rpc_client{mock_functor, client_config};
+  sup::dto::AnyValue input { sup::dto::UnsignedInteger32Type, 42u };
+  sup::dto::AnyValue output{};
+  EXPECT_CALL(mock_functor, CallOperator(_)).Times(3);
+  EXPECT_EQ(rpc_client.Invoke(input, output), Success);
+  EXPECT_EQ(output, kReplyPayload);
+}
+
 ProtocolRPCClientAsyncTest::ProtocolRPCClientAsyncTest() = default;
 
 ProtocolRPCClientAsyncTest::~ProtocolRPCClientAsyncTest() = default;
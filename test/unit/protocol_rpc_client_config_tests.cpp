@@ -40,6 +40,7 @@ TEST_F(ProtocolRPCClientConfigTest, DefaultConstructor)
   EXPECT_EQ(config.m_async, false);
   EXPECT_EQ(config.m_timeout_sec, 0.0);
   EXPECT_EQ(config.m_polling_interval_sec, 0.0);
+  EXPECT_EQ(config.m_priority, AsyncPriority::kNormal);
   EXPECT_TRUE(ValidateProtocolRPCClientConfig(config));
 }
 
@@ -50,6 +51,7 @@ TEST_F(ProtocolRPCClientConfigTest, EncodingConstructor)
   EXPECT_EQ(config.m_async, false);
   EXPECT_EQ(config.m_timeout_sec, 0.0);
   EXPECT_EQ(config.m_polling_interval_sec, 0.0);
+  EXPECT_EQ(config.m_priority, AsyncPriority::kNormal);
   EXPECT_TRUE(ValidateProtocolRPCClientConfig(config));
 }
 
@@ -60,6 +62,7 @@ TEST_F(ProtocolRPCClientConfigTest, AsyncConstructor)
   EXPECT_EQ(config.m_async, true);
   EXPECT_EQ(config.m_timeout_sec, 5.0);
   EXPECT_EQ(config.m_polling_interval_sec, 1.0);
+  EXPECT_EQ(config.m_priority, AsyncPriority::kNormal);
   EXPECT_TRUE(ValidateProtocolRPCClientConfig(config));
 }
 
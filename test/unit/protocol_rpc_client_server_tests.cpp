@@ -20,6 +20,7 @@
 
 #include "test_protocol.h"
 
+#include <sup/protocol/async_invocation.h>
 #include <sup/protocol/protocol_rpc_client.h>
 #include <sup/protocol/protocol_rpc_server.h>
 
@@ -28,6 +29,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
 using namespace sup::protocol;
 
 class AnyFunctorSpy : public sup::dto::AnyFunctor
@@ -55,6 +60,30 @@ private:
   std::vector<sup::dto::AnyValue> m_outputs;
 };
 
+// Forwards to the given functor, but loses the reply to the first initial request
+class LostStartReplyFunctor : public sup::dto::AnyFunctor
+{
+public:
+  explicit LostStartReplyFunctor(sup::dto::AnyFunctor& functor)
+    : m_functor{functor}, m_reply_lost{false} {}
+  ~LostStartReplyFunctor() = default;
+
+  sup::dto::AnyValue operator()(const sup::dto::AnyValue& input) override
+  {
+    auto output = m_functor(input);
+    if (!m_reply_lost && utils::GetAsyncInfo(input).second == AsyncCommand::kInitialRequest)
+    {
+      m_reply_lost = true;
+      throw std::runtime_error("LostStartReplyFunctor: reply lost");
+    }
+    return output;
+  }
+
+private:
+  sup::dto::AnyFunctor& m_functor;
+  bool m_reply_lost;
+};
+
 void DumpAnyValues(const std::vector<sup::dto::AnyValue>& values)
 {
   for (const auto& val : values)
@@ -81,8 +110,8 @@ TEST_F(ProtocolRPCClientServerTest, AsyncInvoke)
   sup::dto::AnyValue input{sup::dto::SignedInteger32Type, 42};
   sup::dto::AnyValue output;
   EXPECT_EQ(rpc_client.Invoke(input, output), Success);
-  EXPECT_GE(spy.GetInputs().size(), 3);
-  EXPECT_GE(spy.GetOutputs().size(), 3);
+  EXPECT_GE(spy.GetInputs().size(), 2);
+  EXPECT_GE(spy.GetOutputs().size(), 2);
   // DumpAnyValues(spy.GetInputs());
   // DumpAnyValues(spy.GetOutputs());
 }
@@ -99,8 +128,8 @@ TEST_F(ProtocolRPCClientServerTest, AsyncInvokeEcho)
   }};
   sup::dto::AnyValue output;
   EXPECT_EQ(rpc_client.Invoke(input, output), Success);
-  EXPECT_GE(spy.GetInputs().size(), 3);
-  EXPECT_GE(spy.GetOutputs().size(), 3);
+  EXPECT_GE(spy.GetInputs().size(), 2);
+  EXPECT_GE(spy.GetOutputs().size(), 2);
   EXPECT_EQ(input, output);
 }
 
@@ -115,8 +144,114 @@ TEST_F(ProtocolRPCClientServerTest, ServerException)
   }};
   sup::dto::AnyValue output;
   EXPECT_EQ(rpc_client.Invoke(input, output), ServerProtocolException);
-  EXPECT_GE(spy.GetInputs().size(), 3);
-  EXPECT_GE(spy.GetOutputs().size(), 3);
+  EXPECT_GE(spy.GetInputs().size(), 2);
+  EXPECT_GE(spy.GetOutputs().size(), 2);
+}
+
+TEST_F(ProtocolRPCClientServerTest, AsyncInvokeLongPoll)
+{
+  // With waiting polls, the client does not need to sleep between polls
+  ProtocolRPCServerConfig server_config{};
+  server_config.m_max_poll_wait_sec = 1.0;
+  ProtocolRPCServer rpc_server{m_test_protocol, server_config};
+  AnyFunctorSpy spy{rpc_server};
+  ProtocolRPCClientConfig client_config{PayloadEncoding::kBase64, 5.0, 2.0};
+  ProtocolRPCClient rpc_client{spy, client_config};
+  sup::dto::AnyValue input{sup::dto::SignedInteger32Type, 42};
+  sup::dto::AnyValue output;
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(rpc_client.Invoke(input, output), Success);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+  // New request and a single poll that includes the reply
+  ASSERT_EQ(spy.GetInputs().size(), 2);
+  auto poll_payload = utils::TryExtractRPCRequestPayload(spy.GetInputs()[1],
+                                                         PayloadEncoding::kBase64);
+  ASSERT_TRUE(poll_payload.first);
+  EXPECT_TRUE(poll_payload.second.HasField(constants::ASYNC_WAIT_FIELD_NAME));
+  // Delivering the reply retired the request
+  EXPECT_EQ(rpc_server.GetRetainedReplySize(), 0);
+  EXPECT_EQ(rpc_server.GetNumberOfAbandonedRequests(), 0);
+}
+
+TEST_F(ProtocolRPCClientServerTest, AsyncInvokeInlineReply)
+{
+  // The reply is included in the poll reply, so no separate request is needed to retrieve it
+  ProtocolRPCServer rpc_server{m_test_protocol};
+  AnyFunctorSpy spy{rpc_server};
+  ProtocolRPCClientConfig client_config{PayloadEncoding::kBase64, 1.0, 0.02};
+  ProtocolRPCClient rpc_client{spy, client_config};
+  sup::dto::AnyValue input = {{
+    { "value", {sup::dto::UnsignedInteger32Type, 42u }},
+    { test::ECHO_FIELD, {sup::dto::BooleanType, true }}
+  }};
+  sup::dto::AnyValue output;
+  EXPECT_EQ(rpc_client.Invoke(input, output), Success);
+  EXPECT_EQ(input, output);
+  for (const auto& request : spy.GetInputs())
+  {
+    EXPECT_NE(utils::GetAsyncInfo(request).second, AsyncCommand::kGetReply);
+  }
+}
+
+TEST_F(ProtocolRPCClientServerTest, AsyncInvokeLostStartReply)
+{
+  // The initial request is sent again with the same key and the server returns the request it
+  // already started
+  ProtocolRPCServer rpc_server{m_test_protocol};
+  AnyFunctorSpy spy{rpc_server};
+  LostStartReplyFunctor lossy_functor{spy};
+  ProtocolRPCClientConfig client_config{PayloadEncoding::kNone, 1.0, 0.02};
+  ProtocolRPCClient rpc_client{lossy_functor, client_config};
+  sup::dto::AnyValue input = {{
+    { "value", {sup::dto::UnsignedInteger32Type, 42u }},
+    { test::ECHO_FIELD, {sup::dto::BooleanType, true }}
+  }};
+  sup::dto::AnyValue output;
+  EXPECT_EQ(rpc_client.Invoke(input, output), Success);
+  EXPECT_EQ(input, output);
+  const auto& requests = spy.GetInputs();
+  const auto& replies = spy.GetOutputs();
+  ASSERT_GE(requests.size(), 2u);
+  EXPECT_EQ(utils::GetAsyncInfo(requests[0]).second, AsyncCommand::kInitialRequest);
+  EXPECT_EQ(utils::GetAsyncInfo(requests[1]).second, AsyncCommand::kInitialRequest);
+  const auto key = utils::GetAsyncRequestKey(requests[0]);
+  EXPECT_FALSE(key.empty());
+  EXPECT_EQ(utils::GetAsyncRequestKey(requests[1]), key);
+  EXPECT_EQ(test::ExtractRequestId(replies[1]), test::ExtractRequestId(replies[0]));
+
+  // Every call uses its own key
+  sup::dto::AnyValue other_output;
+  EXPECT_EQ(rpc_client.Invoke(input, other_output), Success);
+  const auto last_start = std::find_if(requests.rbegin(), requests.rend(),
+    [](const sup::dto::AnyValue& request) {
+      return utils::GetAsyncInfo(request).second == AsyncCommand::kInitialRequest;
+    });
+  ASSERT_NE(last_start, requests.rend());
+  EXPECT_NE(utils::GetAsyncRequestKey(*last_start), key);
+}
+
+TEST_F(ProtocolRPCClientServerTest, AsyncInvocationCompletionNotification)
+{
+  // The server notifies completion, so the client only polls once
+  AsyncInvocation* invocation_ptr = nullptr;
+  ProtocolRPCServerConfig server_config{};
+  server_config.m_completion_callback = [&invocation_ptr](sup::dto::uint64,
+                                                          const ProtocolResult&) {
+    invocation_ptr->NotifyCompletion();
+  };
+  ProtocolRPCServer rpc_server{m_test_protocol, server_config};
+  AnyFunctorSpy spy{rpc_server};
+  AsyncInvocation invocation{spy, PayloadEncoding::kBase64};
+  invocation_ptr = &invocation;
+  sup::dto::AnyValue input{sup::dto::SignedInteger32Type, 42};
+  ASSERT_EQ(invocation.Start(input), Success);
+  ASSERT_TRUE(invocation.WaitForCompletion(5.0));
+  auto poll_result = invocation.PollOnce();
+  EXPECT_EQ(poll_result.first, Success);
+  EXPECT_TRUE(poll_result.second);
+  sup::dto::AnyValue output;
+  EXPECT_EQ(invocation.GetReply(output), Success);
+  EXPECT_EQ(spy.GetInputs().size(), 2);
 }
 
 ProtocolRPCClientServerTest::ProtocolRPCClientServerTest()
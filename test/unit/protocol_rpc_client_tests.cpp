@@ -136,6 +136,33 @@ TEST_F(ProtocolRPCClientTest, FunctorThrows)
   EXPECT_EQ(payload, input);
 }
 
+TEST_F(ProtocolRPCClientTest, LongPollAnsweredEarly)
+{
+  // A server that advertises waiting polls, but answers them right away, is still polled at the
+  // configured interval
+  int n_polls = 0;
+  ::testing::NiceMock<test::MockFunctor> functor;
+  functor.DelegateTo([&n_polls](const sup::dto::AnyValue& input) -> sup::dto::AnyValue {
+    switch (utils::GetAsyncInfo(input).second)
+    {
+    case AsyncCommand::kInitialRequest:
+      return utils::CreateAsyncRPCNewRequestReply(1u, PayloadEncoding::kBase64, 10.0);
+    case AsyncCommand::kPoll:
+      ++n_polls;
+      return utils::CreateAsyncRPCPollReply(false, PayloadEncoding::kBase64);
+    default:
+      return utils::CreateAsyncRPCReply(Success, AsyncCommand::kInvalidate);
+    }
+  });
+  ProtocolRPCClientConfig config{PayloadEncoding::kBase64, 0.2, 0.05};
+  ProtocolRPCClient client{functor, config};
+  sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
+  sup::dto::AnyValue output{};
+  EXPECT_EQ(client.Invoke(input, output), AsynchronousProtocolTimeout);
+  EXPECT_GE(n_polls, 2);
+  EXPECT_LE(n_polls, 10);
+}
+
 TEST_F(ProtocolRPCClientTest, ServiceMethod)
 {
   ProtocolRPCClient client{GetTestFunctor()};
@@ -184,6 +211,32 @@ TEST_F(ProtocolRPCClientTest, ApplicationProtocolInfo)
   EXPECT_TRUE(protocol_info.m_application_version.empty());
 }
 
+TEST_F(ProtocolRPCClientTest, StageTiming)
+{
+  // Stages of synchronous calls are timed per encoding when enabled
+  sup::dto::AnyValue input{sup::dto::SignedInteger32Type, 42};
+  sup::dto::AnyValue output;
+  ProtocolRPCClient untimed_client{GetTestFunctor()};
+  EXPECT_EQ(untimed_client.Invoke(input, output), Success);
+  EXPECT_EQ(untimed_client.GetStageLatency(RPCClientStage::kTransport,
+                                           PayloadEncoding::kBase64).GetCount(), 0);
+
+  ProtocolRPCClientConfig config{PayloadEncoding::kBase64};
+  config.m_stage_timing = true;
+  ProtocolRPCClient client{GetTestFunctor(), config};
+  EXPECT_EQ(client.Invoke(input, output), Success);
+  EXPECT_EQ(client.Invoke(input, output), Success);
+  for (auto stage : { RPCClientStage::kRequestEncoding, RPCClientStage::kTransport,
+                      RPCClientStage::kReplyCheck, RPCClientStage::kPayloadDecoding })
+  {
+    EXPECT_EQ(client.GetStageLatency(stage, PayloadEncoding::kBase64).GetCount(), 2);
+    EXPECT_EQ(client.GetStageLatency(stage, PayloadEncoding::kNone).GetCount(), 0);
+  }
+  client.ResetStageLatencies();
+  EXPECT_EQ(client.GetStageLatency(RPCClientStage::kTransport,
+                                   PayloadEncoding::kBase64).GetCount(), 0);
+}
+
 ProtocolRPCClientTest::ProtocolRPCClientTest()
   : m_test_functor{}
   , m_test_protocol{}
@@ -29,10 +29,33 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <thread>
 
 using namespace sup::protocol;
 
+namespace
+{
+class CountingExecutor : public AsyncExecutor
+{
+public:
+  CountingExecutor() : m_pool{CreateWorkerPool(1)}, m_count{0} {}
+  ~CountingExecutor() override = default;
+
+  void Submit(Task task) override
+  {
+    ++m_count;
+    m_pool->Submit(std::move(task));
+  }
+
+  std::size_t GetCount() const { return m_count; }
+
+private:
+  std::shared_ptr<AsyncExecutor> m_pool;
+  std::atomic<std::size_t> m_count;
+};
+}  // unnamed namespace
+
 class ProtocolRPCServerAsyncTest : public ::testing::Test
 {
 protected:
@@ -275,6 +298,127 @@ TEST_F(ProtocolRPCServerAsyncTest, ExpiredRequest)
   EXPECT_EQ(result.second, InvalidRequestIdentifierError);
 }
 
+TEST_F(ProtocolRPCServerAsyncTest, BackgroundReaper)
+{
+  // Expired requests are cleaned up by a background thread
+  ProtocolRPCServerConfig config{0.01};
+  config.m_cleanup_interval_sec = 0.01;
+  ProtocolRPCServer server{GetTestProtocol(), config};
+
+  auto request = utils::CreateAsyncRPCRequest({sup::dto::UnsignedInteger8Type, 1 },
+                                              PayloadEncoding::kBase64);
+  auto reply = server(request);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_NE(id, 0);
+
+  // Wait enough time for the request to have been expired and cleaned up:
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  auto poll_request = utils::CreateAsyncRPCPoll(id, PayloadEncoding::kBase64);
+  reply = server(poll_request);
+  auto result = utils::TryExtractProtocolResult(reply);
+  EXPECT_TRUE(result.first);
+  EXPECT_EQ(result.second, InvalidRequestIdentifierError);
+}
+
+TEST_F(ProtocolRPCServerAsyncTest, NoInlineCleanUpWithReaper)
+{
+  // With a background reaper, incoming requests never trigger the clean up
+  ProtocolRPCServerConfig config{0.01};
+  config.m_cleanup_interval_sec = 100.0;
+  ProtocolRPCServer server{GetTestProtocol(), config};
+
+  auto request = utils::CreateAsyncRPCRequest({sup::dto::UnsignedInteger8Type, 1 },
+                                              PayloadEncoding::kBase64);
+  auto reply = server(request);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_NE(id, 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // The expired request was not removed yet, but it can no longer be used
+  auto poll_request = utils::CreateAsyncRPCPoll(id, PayloadEncoding::kBase64);
+  reply = server(poll_request);
+  auto result = utils::TryExtractProtocolResult(reply);
+  EXPECT_TRUE(result.first);
+  EXPECT_EQ(result.second, InvalidAsynchronousOperationError);
+}
+
+TEST_F(ProtocolRPCServerAsyncTest, WorkerPool)
+{
+  // Asynchronous requests are handled by a fixed size worker pool
+  ProtocolRPCServerConfig config{};
+  config.m_worker_pool_size = 2;
+  ProtocolRPCServer server{GetTestProtocol(), config};
+
+  for (int i = 0; i < 5; ++i)
+  {
+    sup::dto::AnyValue payload = {{
+      { test::ECHO_FIELD, {sup::dto::BooleanType, true }}
+    }};
+    auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kBase64);
+    auto reply = server(request);
+    auto id = test::ExtractRequestId(reply);
+    ASSERT_NE(id, 0);
+    ASSERT_TRUE(test::PollUntilReady(server, id, 1.0));
+    auto get_reply_req = utils::CreateAsyncRPCGetReply(id, PayloadEncoding::kBase64);
+    reply = server(get_reply_req);
+    auto result = utils::TryExtractProtocolResult(reply);
+    EXPECT_TRUE(result.first);
+    EXPECT_EQ(result.second, Success);
+    auto extract_payload = utils::TryExtractRPCReplyPayload(reply, PayloadEncoding::kBase64);
+    ASSERT_TRUE(extract_payload.first);
+    EXPECT_EQ(extract_payload.second, payload);
+  }
+}
+
+TEST_F(ProtocolRPCServerAsyncTest, WorkStealingPool)
+{
+  // Asynchronous requests are handled by a work-stealing worker pool
+  ProtocolRPCServerConfig config{};
+  config.m_worker_pool_size = 2;
+  config.m_work_stealing = true;
+  ProtocolRPCServer server{GetTestProtocol(), config};
+
+  sup::dto::AnyValue payload = {{
+    { test::ECHO_FIELD, {sup::dto::BooleanType, true }}
+  }};
+  auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kBase64);
+  auto reply = server(request);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_NE(id, 0);
+  ASSERT_TRUE(test::PollUntilReady(server, id, 1.0));
+  auto get_reply_req = utils::CreateAsyncRPCGetReply(id, PayloadEncoding::kBase64);
+  reply = server(get_reply_req);
+  auto result = utils::TryExtractProtocolResult(reply);
+  EXPECT_TRUE(result.first);
+  EXPECT_EQ(result.second, Success);
+  auto extract_payload = utils::TryExtractRPCReplyPayload(reply, PayloadEncoding::kBase64);
+  ASSERT_TRUE(extract_payload.first);
+  EXPECT_EQ(extract_payload.second, payload);
+}
+
+TEST_F(ProtocolRPCServerAsyncTest, CustomExecutor)
+{
+  // Asynchronous requests are submitted to the executor provided by the application
+  auto executor = std::make_shared<CountingExecutor>();
+  ProtocolRPCServerConfig config{};
+  config.m_executor = executor;
+  ProtocolRPCServer server{GetTestProtocol(), config};
+
+  sup::dto::AnyValue payload{ sup::dto::UnsignedInteger8Type, 1 };
+  auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kNone);
+  auto reply = server(request);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_NE(id, 0);
+  ASSERT_TRUE(test::PollUntilReady(server, id, 1.0));
+  auto get_reply_req = utils::CreateAsyncRPCGetReply(id, PayloadEncoding::kNone);
+  reply = server(get_reply_req);
+  auto result = utils::TryExtractProtocolResult(reply);
+  EXPECT_TRUE(result.first);
+  EXPECT_EQ(result.second, Success);
+  EXPECT_EQ(executor->GetCount(), 1);
+}
+
 ProtocolRPCServerAsyncTest::ProtocolRPCServerAsyncTest()
   : m_test_protocol{}
 {}
@@ -29,6 +29,8 @@
 
 #include <gtest/gtest.h>
 
+#include <stdexcept>
+
 using namespace sup::protocol;
 
 class ProtocolRPCServerTest : public ::testing::Test
@@ -248,6 +250,214 @@ TEST_F(ProtocolRPCServerTest, Service_UnsupportedPayloadEncoding)
   EXPECT_FALSE(reply.HasField(constants::REPLY_PAYLOAD));
 }
 
+TEST_F(ProtocolRPCServerTest, ReplyCache)
+{
+  ProtocolRPCServerConfig config{};
+  config.m_reply_cache_size = 4;
+  config.m_cacheable = [](const sup::dto::AnyValue& input) {
+    return input.HasField(test::ECHO_FIELD);
+  };
+  ProtocolRPCServer server{GetTestProtocol(), config};
+
+  sup::dto::AnyValue cacheable_payload = {{
+    { test::ECHO_FIELD, {sup::dto::BooleanType, true }},
+    { "value", {sup::dto::UnsignedInteger32Type, 42u }}
+  }};
+  sup::dto::AnyValue other_payload{ sup::dto::StringType, "not cacheable" };
+  auto cacheable_request = utils::CreateRPCRequest(cacheable_payload, PayloadEncoding::kBase64);
+  auto other_request = utils::CreateRPCRequest(other_payload, PayloadEncoding::kBase64);
+
+  // First request is a miss and fills the cache
+  auto reply = server(cacheable_request);
+  EXPECT_TRUE(utils::CheckReplyFormat(reply));
+  EXPECT_EQ(reply[constants::REPLY_RESULT].As<unsigned int>(), Success.GetValue());
+  EXPECT_EQ(server.GetReplyCacheHits(), 0);
+  EXPECT_EQ(server.GetReplyCacheMisses(), 1);
+
+  // Requests that are not cacheable are not counted
+  auto other_reply = server(other_request);
+  EXPECT_EQ(other_reply[constants::REPLY_RESULT].As<unsigned int>(), Success.GetValue());
+  EXPECT_EQ(m_test_protocol.GetLastInput(), other_payload);
+  EXPECT_EQ(server.GetReplyCacheMisses(), 1);
+
+  // Same request is answered from the cache without calling the protocol
+  auto cached_reply = server(cacheable_request);
+  EXPECT_EQ(cached_reply, reply);
+  EXPECT_EQ(m_test_protocol.GetLastInput(), other_payload);
+  EXPECT_EQ(server.GetReplyCacheHits(), 1);
+
+  // Also a new asynchronous request is answered from the cache
+  auto async_request = utils::CreateAsyncRPCRequest(cacheable_payload, PayloadEncoding::kBase64);
+  cached_reply = server(async_request);
+  EXPECT_EQ(cached_reply, reply);
+  EXPECT_FALSE(utils::GetAsyncInfo(cached_reply).first);
+  EXPECT_EQ(server.GetReplyCacheHits(), 2);
+
+  // The cache key includes the encoding of the reply
+  auto unencoded_request = utils::CreateRPCRequest(cacheable_payload, PayloadEncoding::kNone);
+  auto unencoded_reply = server(unencoded_request);
+  EXPECT_EQ(unencoded_reply[constants::REPLY_PAYLOAD], cacheable_payload);
+  EXPECT_EQ(server.GetReplyCacheMisses(), 2);
+}
+
+TEST_F(ProtocolRPCServerTest, ReplyCacheOnlySuccess)
+{
+  ProtocolRPCServerConfig config{};
+  config.m_reply_cache_size = 4;
+  config.m_cacheable = [](const sup::dto::AnyValue&) { return true; };
+  ProtocolRPCServer server{GetTestProtocol(), config};
+
+  sup::dto::AnyValue payload = {{
+    { test::REQUESTED_STATUS_FIELD, {sup::dto::UnsignedInteger32Type, 65 }}
+  }};
+  auto request = utils::CreateRPCRequest(payload, PayloadEncoding::kBase64);
+  auto reply = server(request);
+  EXPECT_EQ(reply[constants::REPLY_RESULT].As<unsigned int>(), 65u);
+  reply = server(request);
+  EXPECT_EQ(reply[constants::REPLY_RESULT].As<unsigned int>(), 65u);
+  EXPECT_EQ(server.GetReplyCacheHits(), 0);
+  EXPECT_EQ(server.GetReplyCacheMisses(), 2);
+}
+
+TEST_F(ProtocolRPCServerTest, ReplyCacheOnlyInvokes)
+{
+  // Asynchronous commands that only carry a request identifier do not look up the cache
+  ProtocolRPCServerConfig config{};
+  config.m_reply_cache_size = 4;
+  config.m_cacheable = [](const sup::dto::AnyValue&) { return true; };
+  ProtocolRPCServer server{GetTestProtocol(), config};
+
+  sup::dto::AnyValue payload{ sup::dto::StringType, "cacheable" };
+  auto async_request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kBase64);
+  auto reply = server(async_request);
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_NE(id, 0);
+  EXPECT_EQ(server.GetReplyCacheMisses(), 1);
+  EXPECT_TRUE(test::PollUntilReady(server, id, 1.0));
+  reply = server(utils::CreateAsyncRPCGetReply(id, PayloadEncoding::kBase64));
+  EXPECT_EQ(reply[constants::REPLY_RESULT].As<unsigned int>(), Success.GetValue());
+  EXPECT_EQ(server.GetReplyCacheHits(), 0);
+  EXPECT_EQ(server.GetReplyCacheMisses(), 1);
+}
+
+TEST_F(ProtocolRPCServerTest, ConstantServiceReply)
+{
+  // Application protocol information is only computed once per encoding
+  ProtocolRPCServerConfig config{};
+  config.m_constant_service = utils::IsApplicationProtocolRequestPayload;
+  ProtocolRPCServer server{GetTestProtocol(), config};
+  sup::dto::AnyValue info_payload{ sup::dto::StringType,
+                                   constants::APPLICATION_PROTOCOL_INFO_REQUEST };
+  sup::dto::AnyValue other_payload{ sup::dto::StringType, "does_not_matter" };
+  auto info_request = utils::CreateServiceRequest(info_payload, PayloadEncoding::kBase64);
+  auto other_request = utils::CreateServiceRequest(other_payload, PayloadEncoding::kBase64);
+
+  // Failures are not kept
+  m_test_protocol.SetFailForServiceRequest(true);
+  auto reply = server(info_request);
+  EXPECT_EQ(reply[constants::SERVICE_REPLY_RESULT].As<unsigned int>(),
+            ServerTransportEncodingError.GetValue());
+  m_test_protocol.SetFailForServiceRequest(false);
+  reply = server(info_request);
+  EXPECT_TRUE(utils::CheckServiceReplyFormat(reply));
+  EXPECT_EQ(reply[constants::SERVICE_REPLY_RESULT].As<unsigned int>(), Success.GetValue());
+  EXPECT_EQ(server.GetConstantServiceReplyHits(), 0);
+
+  // Other queries still call the protocol
+  auto other_reply = server(other_request);
+  EXPECT_EQ(other_reply[constants::SERVICE_REPLY_RESULT].As<unsigned int>(), Success.GetValue());
+  EXPECT_EQ(m_test_protocol.GetLastInput(), other_payload);
+
+  // The same query is answered without calling the protocol
+  auto constant_reply = server(info_request);
+  EXPECT_EQ(constant_reply, reply);
+  EXPECT_EQ(m_test_protocol.GetLastInput(), other_payload);
+  EXPECT_EQ(server.GetConstantServiceReplyHits(), 1);
+
+  // The reply depends on the encoding
+  auto unencoded_request = utils::CreateServiceRequest(info_payload, PayloadEncoding::kNone);
+  auto unencoded_reply = server(unencoded_request);
+  EXPECT_EQ(m_test_protocol.GetLastInput(), info_payload);
+  EXPECT_TRUE(utils::CheckApplicationProtocolReplyPayload(
+    unencoded_reply[constants::SERVICE_REPLY_PAYLOAD]));
+  EXPECT_EQ(server.GetConstantServiceReplyHits(), 1);
+}
+
+TEST_F(ProtocolRPCServerTest, ConstantServiceReplyConfiguration)
+{
+  sup::dto::AnyValue info_payload{ sup::dto::StringType,
+                                   constants::APPLICATION_PROTOCOL_INFO_REQUEST };
+  sup::dto::AnyValue other_payload{ sup::dto::StringType, "does_not_matter" };
+  auto info_request = utils::CreateServiceRequest(info_payload, PayloadEncoding::kNone);
+  auto other_request = utils::CreateServiceRequest(other_payload, PayloadEncoding::kNone);
+  {
+    // Disabled by default
+    ProtocolRPCServer server{GetTestProtocol()};
+    EXPECT_EQ(server(info_request), server(info_request));
+    EXPECT_EQ(server.GetConstantServiceReplyHits(), 0);
+  }
+  {
+    // Application specific constant queries; the predicate may throw
+    ProtocolRPCServerConfig config{};
+    config.m_constant_service = [&other_payload](const sup::dto::AnyValue& query) {
+      if (query != other_payload)
+      {
+        throw std::runtime_error("Not a constant query");
+      }
+      return true;
+    };
+    ProtocolRPCServer server{GetTestProtocol(), config};
+    EXPECT_EQ(server(other_request), server(other_request));
+    EXPECT_EQ(server.GetConstantServiceReplyHits(), 1);
+    EXPECT_EQ(server(info_request), server(info_request));
+    EXPECT_EQ(server.GetConstantServiceReplyHits(), 1);
+  }
+}
+
+TEST_F(ProtocolRPCServerTest, StageTiming)
+{
+  // Stages of synchronous requests are timed per encoding when enabled
+  ProtocolRPCServerConfig config{};
+  config.m_stage_timing = true;
+  ProtocolRPCServer server{GetTestProtocol(), config};
+  sup::dto::AnyValue payload{ sup::dto::StringType, "some_payload" };
+  auto reply = server(utils::CreateRPCRequest(payload, PayloadEncoding::kBase64));
+  EXPECT_EQ(reply[constants::REPLY_RESULT].As<unsigned int>(), Success.GetValue());
+  reply = server(utils::CreateRPCRequest(payload, PayloadEncoding::kNone));
+  EXPECT_EQ(reply[constants::REPLY_RESULT].As<unsigned int>(), Success.GetValue());
+  reply = server(utils::CreateRPCRequest(payload, PayloadEncoding::kNone));
+  EXPECT_EQ(reply[constants::REPLY_RESULT].As<unsigned int>(), Success.GetValue());
+  for (auto stage : { RPCServerStage::kEncodingDetection, RPCServerStage::kRequestCheck,
+                      RPCServerStage::kPayloadDecoding, RPCServerStage::kInvoke,
+                      RPCServerStage::kReplyEncoding })
+  {
+    EXPECT_EQ(server.GetStageLatency(stage, PayloadEncoding::kBase64).GetCount(), 1);
+    EXPECT_EQ(server.GetStageLatency(stage, PayloadEncoding::kNone).GetCount(), 2);
+  }
+  server.ResetStageLatencies();
+  EXPECT_EQ(server.GetStageLatency(RPCServerStage::kInvoke, PayloadEncoding::kNone).GetCount(), 0);
+
+  // Asynchronous requests are not timed
+  reply = server(utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kNone));
+  auto id = test::ExtractRequestId(reply);
+  ASSERT_NE(id, 0);
+  EXPECT_TRUE(test::PollUntilReady(server, id, 1.0));
+  reply = server(utils::CreateAsyncRPCGetReply(id, PayloadEncoding::kNone));
+  EXPECT_EQ(reply[constants::REPLY_RESULT].As<unsigned int>(), Success.GetValue());
+  for (auto stage : { RPCServerStage::kEncodingDetection, RPCServerStage::kRequestCheck,
+                      RPCServerStage::kPayloadDecoding })
+  {
+    EXPECT_EQ(server.GetStageLatency(stage, PayloadEncoding::kNone).GetCount(), 0);
+    EXPECT_EQ(server.GetStageLatency(stage, PayloadEncoding::kBase64).GetCount(), 0);
+  }
+
+  // Disabled by default
+  ProtocolRPCServer untimed_server{GetTestProtocol()};
+  reply = untimed_server(utils::CreateRPCRequest(payload, PayloadEncoding::kNone));
+  EXPECT_EQ(untimed_server.GetStageLatency(RPCServerStage::kInvoke,
+                                           PayloadEncoding::kNone).GetCount(), 0);
+}
+
 ProtocolRPCServerTest::ProtocolRPCServerTest()
   : m_test_protocol{}
 {}
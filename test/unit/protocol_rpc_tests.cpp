@@ -368,6 +368,96 @@ TEST_F(ProtocolRPCTest, CreateAsyncRPCRequest)
   }
 }
 
+TEST_F(ProtocolRPCTest, CreateAsyncRPCRequestWithPriority)
+{
+  sup::dto::AnyValue payload{ sup::dto::UnsignedInteger8Type, 5u };
+  {
+    // Normal priority does not add a priority field
+    auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kNone,
+                                                AsyncPriority::kNormal);
+    ASSERT_TRUE(utils::CheckRequestFormat(request));
+    EXPECT_FALSE(request.HasField(constants::ASYNC_PRIORITY_FIELD_NAME));
+    EXPECT_EQ(utils::GetAsyncPriority(request), AsyncPriority::kNormal);
+  }
+  {
+    // High priority
+    auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kBase64,
+                                                AsyncPriority::kHigh);
+    ASSERT_TRUE(utils::CheckRequestFormat(request));
+    ASSERT_TRUE(request.HasField(constants::ASYNC_PRIORITY_FIELD_NAME));
+    EXPECT_EQ(request[constants::ASYNC_PRIORITY_FIELD_NAME].GetType(),
+              sup::dto::UnsignedInteger32Type);
+    EXPECT_EQ(utils::GetAsyncPriority(request), AsyncPriority::kHigh);
+    auto async_info = utils::GetAsyncInfo(request);
+    EXPECT_TRUE(async_info.first);
+    EXPECT_EQ(async_info.second, AsyncCommand::kInitialRequest);
+  }
+  {
+    // Low priority
+    auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kNone,
+                                                AsyncPriority::kLow);
+    ASSERT_TRUE(utils::CheckRequestFormat(request));
+    EXPECT_EQ(utils::GetAsyncPriority(request), AsyncPriority::kLow);
+  }
+}
+
+TEST_F(ProtocolRPCTest, CreateAsyncRPCRequestWithKey)
+{
+  sup::dto::AnyValue payload{ sup::dto::UnsignedInteger8Type, 5u };
+  {
+    // Empty key does not add a key field
+    auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kNone,
+                                                AsyncPriority::kNormal, "");
+    ASSERT_TRUE(utils::CheckRequestFormat(request));
+    EXPECT_FALSE(request.HasField(constants::ASYNC_KEY_FIELD_NAME));
+    EXPECT_TRUE(utils::GetAsyncRequestKey(request).empty());
+  }
+  {
+    // Key and priority
+    auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kBase64,
+                                                AsyncPriority::kHigh, "client-1/42");
+    ASSERT_TRUE(utils::CheckRequestFormat(request));
+    ASSERT_TRUE(request.HasField(constants::ASYNC_KEY_FIELD_NAME));
+    EXPECT_EQ(request[constants::ASYNC_KEY_FIELD_NAME].GetType(), sup::dto::StringType);
+    EXPECT_EQ(utils::GetAsyncRequestKey(request), "client-1/42");
+    EXPECT_EQ(utils::GetAsyncPriority(request), AsyncPriority::kHigh);
+  }
+  {
+    // Request with wrong type of key field has the wrong format
+    auto request = utils::CreateAsyncRPCRequest(payload, PayloadEncoding::kNone);
+    (void)request.AddMember(constants::ASYNC_KEY_FIELD_NAME,
+                            sup::dto::AnyValue{ sup::dto::UnsignedInteger32Type, 42u });
+    EXPECT_FALSE(utils::CheckRequestFormat(request));
+    EXPECT_TRUE(utils::GetAsyncRequestKey(request).empty());
+  }
+}
+
+TEST_F(ProtocolRPCTest, GetAsyncPriority)
+{
+  {
+    // Unknown priority value falls back to normal priority
+    sup::dto::AnyValue packet = {
+      { constants::ASYNC_PRIORITY_FIELD_NAME, {sup::dto::UnsignedInteger32Type, 42u}}
+    };
+    EXPECT_EQ(utils::GetAsyncPriority(packet), AsyncPriority::kNormal);
+  }
+  {
+    // Wrong type of priority field falls back to normal priority
+    sup::dto::AnyValue packet = {
+      { constants::ASYNC_PRIORITY_FIELD_NAME, {sup::dto::SignedInteger32Type, 2}}
+    };
+    EXPECT_EQ(utils::GetAsyncPriority(packet), AsyncPriority::kNormal);
+  }
+  {
+    // Request with wrong type of priority field has the wrong format
+    auto request = utils::CreateAsyncRPCRequest({ sup::dto::UnsignedInteger8Type, 5u },
+                                                PayloadEncoding::kNone);
+    (void)request.AddMember(constants::ASYNC_PRIORITY_FIELD_NAME,
+                            sup::dto::AnyValue{ sup::dto::StringType, "high" });
+    EXPECT_FALSE(utils::CheckRequestFormat(request));
+  }
+}
+
 TEST_F(ProtocolRPCTest, CreateAsyncRPCPoll)
 {
   {
@@ -410,6 +500,39 @@ TEST_F(ProtocolRPCTest, CreateAsyncRPCPoll)
   }
 }
 
+TEST_F(ProtocolRPCTest, CreateAsyncRPCPollWithWait)
+{
+  {
+    // Poll request with wait time
+    auto request = utils::CreateAsyncRPCPoll(42u, PayloadEncoding::kBase64, 2.5);
+    ASSERT_TRUE(utils::CheckRequestFormat(request));
+    auto poll_id = utils::TryExtractRequestId(request, PayloadEncoding::kBase64);
+    EXPECT_TRUE(poll_id.first);
+    EXPECT_EQ(poll_id.second, 42u);
+    auto payload_info = utils::TryExtractRPCRequestPayload(request, PayloadEncoding::kBase64);
+    ASSERT_TRUE(payload_info.first);
+    ASSERT_TRUE(payload_info.second.HasField(constants::ASYNC_WAIT_FIELD_NAME));
+    auto& wait_field = payload_info.second[constants::ASYNC_WAIT_FIELD_NAME];
+    EXPECT_EQ(wait_field.GetType(), sup::dto::Float64Type);
+    EXPECT_EQ(wait_field.As<sup::dto::float64>(), 2.5);
+  }
+  {
+    // Without a positive wait time, the poll request is a plain poll
+    auto request = utils::CreateAsyncRPCPoll(42u, PayloadEncoding::kNone, 0.0);
+    EXPECT_EQ(request, utils::CreateAsyncRPCPoll(42u, PayloadEncoding::kNone));
+  }
+  {
+    // Poll request that asks for an inline reply
+    auto request = utils::CreateAsyncRPCPoll(42u, PayloadEncoding::kBase64, 0.0, true);
+    ASSERT_TRUE(utils::CheckRequestFormat(request));
+    auto payload_info = utils::TryExtractRPCRequestPayload(request, PayloadEncoding::kBase64);
+    ASSERT_TRUE(payload_info.first);
+    EXPECT_FALSE(payload_info.second.HasField(constants::ASYNC_WAIT_FIELD_NAME));
+    ASSERT_TRUE(payload_info.second.HasField(constants::ASYNC_INLINE_REPLY_FIELD_NAME));
+    EXPECT_TRUE(payload_info.second[constants::ASYNC_INLINE_REPLY_FIELD_NAME].As<bool>());
+  }
+}
+
 TEST_F(ProtocolRPCTest, CreateAsyncRPCGetReply)
 {
   {
@@ -750,6 +873,73 @@ TEST_F(ProtocolRPCTest, CreateAsyncRPCNewRequestReply)
   }
 }
 
+TEST_F(ProtocolRPCTest, GetAsyncMaxPollWait)
+{
+  {
+    // Reply that advertises waiting polls
+    auto reply = utils::CreateAsyncRPCNewRequestReply(42u, PayloadEncoding::kBase64, 1.5);
+    ASSERT_TRUE(utils::CheckReplyFormat(reply));
+    auto id_info = utils::TryExtractReplyId(reply, PayloadEncoding::kBase64);
+    EXPECT_TRUE(id_info.first);
+    EXPECT_EQ(id_info.second, 42u);
+    EXPECT_EQ(utils::GetAsyncMaxPollWait(reply, PayloadEncoding::kBase64), 1.5);
+  }
+  {
+    // Reply without support for waiting polls
+    auto reply = utils::CreateAsyncRPCNewRequestReply(42u, PayloadEncoding::kNone);
+    EXPECT_EQ(utils::GetAsyncMaxPollWait(reply, PayloadEncoding::kNone), 0.0);
+  }
+  {
+    // Wrong type of max_wait field is ignored
+    sup::dto::AnyValue payload = {
+      { constants::ASYNC_ID_FIELD_NAME, {sup::dto::UnsignedInteger64Type, 42u}},
+      { constants::ASYNC_MAX_WAIT_FIELD_NAME, {sup::dto::UnsignedInteger32Type, 2u}}
+    };
+    auto reply = utils::CreateAsyncRPCReply(Success, payload, PayloadEncoding::kNone,
+                                            AsyncCommand::kInitialRequest);
+    EXPECT_EQ(utils::GetAsyncMaxPollWait(reply, PayloadEncoding::kNone), 0.0);
+  }
+}
+
+TEST_F(ProtocolRPCTest, GetAsyncRetryAfter)
+{
+  {
+    // Reply to a new request with a suggested delay
+    auto reply = utils::CreateAsyncRPCNewRequestReply(42u, PayloadEncoding::kBase64, 0.0, 2.5);
+    ASSERT_TRUE(utils::CheckReplyFormat(reply));
+    auto id_info = utils::TryExtractReplyId(reply, PayloadEncoding::kBase64);
+    EXPECT_TRUE(id_info.first);
+    EXPECT_EQ(id_info.second, 42u);
+    EXPECT_EQ(utils::GetAsyncMaxPollWait(reply, PayloadEncoding::kBase64), 0.0);
+    EXPECT_EQ(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kBase64), 2.5);
+  }
+  {
+    // Poll reply with a suggested delay
+    auto reply = utils::CreateAsyncRPCPollReply(false, PayloadEncoding::kNone, 0.5);
+    auto ready_info = utils::TryExtractReadyStatus(reply, PayloadEncoding::kNone);
+    EXPECT_TRUE(ready_info.first);
+    EXPECT_FALSE(ready_info.second);
+    EXPECT_EQ(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 0.5);
+  }
+  {
+    // Replies without a suggestion
+    auto reply = utils::CreateAsyncRPCNewRequestReply(42u, PayloadEncoding::kNone, 1.0);
+    EXPECT_EQ(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 0.0);
+    reply = utils::CreateAsyncRPCPollReply(false, PayloadEncoding::kNone);
+    EXPECT_EQ(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 0.0);
+  }
+  {
+    // Wrong type of retry_after field is ignored
+    sup::dto::AnyValue payload = {
+      { constants::ASYNC_READY_FIELD_NAME, {sup::dto::BooleanType, false}},
+      { constants::ASYNC_RETRY_AFTER_FIELD_NAME, {sup::dto::StringType, "later"}}
+    };
+    auto reply = utils::CreateAsyncRPCReply(Success, payload, PayloadEncoding::kNone,
+                                            AsyncCommand::kPoll);
+    EXPECT_EQ(utils::GetAsyncRetryAfter(reply, PayloadEncoding::kNone), 0.0);
+  }
+}
+
 TEST_F(ProtocolRPCTest, CreateAsyncRPCPollReply)
 {
   {
@@ -806,6 +996,38 @@ TEST_F(ProtocolRPCTest, CreateAsyncRPCPollReply)
   }
 }
 
+TEST_F(ProtocolRPCTest, CreateAsyncRPCPollReplyWithInlineReply)
+{
+  {
+    // Inline reply with payload
+    sup::dto::AnyValue payload{ sup::dto::StringType, "reply payload" };
+    auto reply = utils::CreateAsyncRPCPollReply(NotConnected, payload, PayloadEncoding::kBase64);
+    ASSERT_TRUE(utils::CheckReplyFormat(reply));
+    auto result_info = utils::TryExtractProtocolResult(reply);
+    EXPECT_TRUE(result_info.first);
+    EXPECT_EQ(result_info.second, Success);
+    auto ready_info = utils::TryExtractReadyStatus(reply, PayloadEncoding::kBase64);
+    EXPECT_TRUE(ready_info.first);
+    EXPECT_TRUE(ready_info.second);
+    auto payload_info = utils::TryExtractRPCReplyPayload(reply, PayloadEncoding::kBase64);
+    ASSERT_TRUE(payload_info.first);
+    auto& poll_payload = payload_info.second;
+    ASSERT_TRUE(poll_payload.HasField(constants::REPLY_RESULT));
+    EXPECT_EQ(poll_payload[constants::REPLY_RESULT].As<sup::dto::uint32>(),
+              NotConnected.GetValue());
+    ASSERT_TRUE(poll_payload.HasField(constants::REPLY_PAYLOAD));
+    EXPECT_EQ(poll_payload[constants::REPLY_PAYLOAD], payload);
+  }
+  {
+    // Inline reply without payload
+    auto reply = utils::CreateAsyncRPCPollReply(Success, {}, PayloadEncoding::kNone);
+    auto payload_info = utils::TryExtractRPCReplyPayload(reply, PayloadEncoding::kNone);
+    ASSERT_TRUE(payload_info.first);
+    EXPECT_TRUE(payload_info.second.HasField(constants::REPLY_RESULT));
+    EXPECT_FALSE(payload_info.second.HasField(constants::REPLY_PAYLOAD));
+  }
+}
+
 TEST_F(ProtocolRPCTest, CheckServiceRequest)
 {
   {
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/clock.h>
+#include <sup/protocol/base/reply_cache.h>
+
+#include <sup/protocol/exceptions.h>
+
+#include <gtest/gtest.h>
+
+using namespace sup::protocol;
+
+class ReplyCacheTest : public ::testing::Test
+{
+protected:
+  ReplyCacheTest();
+  virtual ~ReplyCacheTest();
+};
+
+TEST_F(ReplyCacheTest, Construction)
+{
+  EXPECT_THROW(ReplyCache(0, 0, 0.0), InvalidOperationException);
+  ReplyCache cache{4, 0, 0.0};
+  EXPECT_EQ(cache.GetSize(), 0);
+  EXPECT_EQ(cache.GetTotalBytes(), 0);
+  EXPECT_EQ(cache.GetNumberOfHits(), 0);
+  EXPECT_EQ(cache.GetNumberOfMisses(), 0);
+}
+
+TEST_F(ReplyCacheTest, FindAndInsert)
+{
+  ReplyCache cache{4, 0, 0.0};
+  const sup::dto::AnyValue reply{ sup::dto::StringType, "reply" };
+  auto found = cache.Find("key");
+  EXPECT_FALSE(found.first);
+  EXPECT_EQ(cache.GetNumberOfMisses(), 1);
+
+  cache.Insert("key", reply);
+  EXPECT_EQ(cache.GetSize(), 1);
+  EXPECT_EQ(cache.GetTotalBytes(), 3 + 5);
+  found = cache.Find("key");
+  ASSERT_TRUE(found.first);
+  EXPECT_EQ(found.second, reply);
+  EXPECT_EQ(cache.GetNumberOfHits(), 1);
+
+  // Replace existing entry
+  const sup::dto::AnyValue other_reply{ sup::dto::UnsignedInteger32Type, 42u };
+  cache.Insert("key", other_reply);
+  EXPECT_EQ(cache.GetSize(), 1);
+  EXPECT_EQ(cache.GetTotalBytes(), 3 + 4);
+  found = cache.Find("key");
+  ASSERT_TRUE(found.first);
+  EXPECT_EQ(found.second, other_reply);
+}
+
+TEST_F(ReplyCacheTest, LeastRecentlyUsedEviction)
+{
+  ReplyCache cache{2, 0, 0.0};
+  const sup::dto::AnyValue reply{ sup::dto::UnsignedInteger32Type, 42u };
+  cache.Insert("first", reply);
+  cache.Insert("second", reply);
+  // Make the first entry the most recently used one
+  EXPECT_TRUE(cache.Find("first").first);
+  cache.Insert("third", reply);
+  EXPECT_EQ(cache.GetSize(), 2);
+  EXPECT_TRUE(cache.Find("first").first);
+  EXPECT_FALSE(cache.Find("second").first);
+  EXPECT_TRUE(cache.Find("third").first);
+}
+
+TEST_F(ReplyCacheTest, ByteLimit)
+{
+  ReplyCache cache{10, 20, 0.0};
+  const sup::dto::AnyValue reply{ sup::dto::StringType, "0123456789" };
+  // Each entry takes 1 + 10 bytes
+  cache.Insert("a", reply);
+  cache.Insert("b", reply);
+  EXPECT_EQ(cache.GetSize(), 1);
+  EXPECT_FALSE(cache.Find("a").first);
+  EXPECT_TRUE(cache.Find("b").first);
+  EXPECT_LE(cache.GetTotalBytes(), 20);
+
+  // Entries that are too large are not cached
+  const sup::dto::AnyValue large_reply{ sup::dto::StringType, "01234567890123456789" };
+  cache.Insert("c", large_reply);
+  EXPECT_FALSE(cache.Find("c").first);
+  EXPECT_TRUE(cache.Find("b").first);
+}
+
+TEST_F(ReplyCacheTest, TimeToLive)
+{
+  VirtualClock clock;
+  ReplyCache cache{4, 0, 0.05, clock};
+  const sup::dto::AnyValue reply{ sup::dto::UnsignedInteger32Type, 42u };
+  cache.Insert("key", reply);
+  EXPECT_TRUE(cache.Find("key").first);
+  clock.Advance(0.05);
+  EXPECT_TRUE(cache.Find("key").first);
+  clock.Advance(0.001);
+  EXPECT_FALSE(cache.Find("key").first);
+  EXPECT_EQ(cache.GetSize(), 0);
+  EXPECT_EQ(cache.GetTotalBytes(), 0);
+}
+
+TEST_F(ReplyCacheTest, CacheKey)
+{
+  const sup::dto::AnyValue input{ sup::dto::UnsignedInteger32Type, 42u };
+  const sup::dto::AnyValue other_input{ sup::dto::UnsignedInteger32Type, 43u };
+  EXPECT_EQ(GetReplyCacheKey(input, PayloadEncoding::kBase64),
+            GetReplyCacheKey(input, PayloadEncoding::kBase64));
+  EXPECT_NE(GetReplyCacheKey(input, PayloadEncoding::kBase64),
+            GetReplyCacheKey(input, PayloadEncoding::kNone));
+  EXPECT_NE(GetReplyCacheKey(input, PayloadEncoding::kBase64),
+            GetReplyCacheKey(other_input, PayloadEncoding::kBase64));
+}
+
+ReplyCacheTest::ReplyCacheTest() = default;
+
+ReplyCacheTest::~ReplyCacheTest() = default;
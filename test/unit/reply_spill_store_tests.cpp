@@ -0,0 +1,105 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/reply_spill_store.h>
+
+#include <sup/protocol/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+
+using namespace sup::protocol;
+
+class ReplySpillStoreTest : public ::testing::Test
+{
+protected:
+  ReplySpillStoreTest();
+  virtual ~ReplySpillStoreTest();
+};
+
+TEST_F(ReplySpillStoreTest, SpilledValue)
+{
+  sup::dto::AnyValue value = {{
+    { "flag", true },
+    { "count", { sup::dto::UnsignedInteger32Type, 42u } },
+    { "text", "This is a spilled value" }
+  }};
+  SpilledValue spilled{value, "/tmp"};
+  EXPECT_GT(spilled.GetSize(), 0);
+  EXPECT_EQ(spilled.Load(), value);
+  // Loading does not consume the value
+  EXPECT_EQ(spilled.Load(), value);
+
+  // Empty values can be spilled too
+  SpilledValue empty{sup::dto::AnyValue{}, "/tmp"};
+  EXPECT_TRUE(sup::dto::IsEmptyValue(empty.Load()));
+
+  EXPECT_THROW(SpilledValue(value, "/this/directory/does/not/exist"), InvalidOperationException);
+}
+
+TEST_F(ReplySpillStoreTest, Spill)
+{
+  const sup::dto::AnyValue value{ sup::dto::StringType, "This is a spilled value" };
+  ReplySpillStore store{16, "/tmp"};
+  EXPECT_FALSE(store.ShouldSpill(16));
+  EXPECT_TRUE(store.ShouldSpill(17));
+  auto spilled = store.Spill(value);
+  ASSERT_TRUE(spilled);
+  EXPECT_EQ(spilled->Load(), value);
+  EXPECT_EQ(store.GetNumberOfSpilledValues(), 1);
+
+  // Failure to spill is not an error
+  ReplySpillStore failing_store{16, "/this/directory/does/not/exist"};
+  EXPECT_FALSE(failing_store.Spill(value));
+  EXPECT_EQ(failing_store.GetNumberOfSpilledValues(), 0);
+
+  // The directory is required
+  EXPECT_THROW(ReplySpillStore(16, ""), InvalidOperationException);
+}
+
+TEST_F(ReplySpillStoreTest, NoFileDescriptors)
+{
+  // Spilled values only keep their mapping: the lowest free file descriptor stays the same
+  const sup::dto::AnyValue value{ sup::dto::StringType, "This is a spilled value" };
+  auto probe = ::open("/dev/null", O_RDONLY);
+  ASSERT_GE(probe, 0);
+  (void)::close(probe);
+  std::vector<std::unique_ptr<SpilledValue>> spilled;
+  for (int i = 0; i < 8; ++i)
+  {
+    spilled.push_back(std::make_unique<SpilledValue>(value, "/tmp"));
+  }
+  auto next_probe = ::open("/dev/null", O_RDONLY);
+  EXPECT_EQ(next_probe, probe);
+  (void)::close(next_probe);
+  for (const auto& spilled_value : spilled)
+  {
+    EXPECT_EQ(spilled_value->Load(), value);
+  }
+}
+
+ReplySpillStoreTest::ReplySpillStoreTest() = default;
+
+ReplySpillStoreTest::~ReplySpillStoreTest() = default;
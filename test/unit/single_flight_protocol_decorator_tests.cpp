@@ -0,0 +1,264 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <sup/dto/anyvalue.h>
+#include <sup/protocol/base/async_invoke.h>
+#include <sup/protocol/base/worker_pool.h>
+#include <sup/protocol/single_flight_protocol_decorator.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace sup::protocol;
+
+/**
+ * @brief Protocol that counts its calls to Invoke and blocks them until it is opened.
+ */
+class CountingGatedProtocol : public Protocol
+{
+public:
+  CountingGatedProtocol() = default;
+  ~CountingGatedProtocol() = default;
+
+  ProtocolResult Invoke(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override
+  {
+    std::unique_lock<std::mutex> lk{m_mtx};
+    ++m_calls;
+    m_cv.notify_all();
+    m_cv.wait(lk, [this](){ return m_open; });
+    if (m_throw)
+    {
+      throw std::runtime_error("Invoke failed");
+    }
+    output = input;
+    return Success;
+  }
+
+  ProtocolResult Service(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override
+  {
+    output = input;
+    return Success;
+  }
+
+  void Open(bool do_throw = false)
+  {
+    {
+      std::lock_guard<std::mutex> lk{m_mtx};
+      m_open = true;
+      m_throw = do_throw;
+    }
+    m_cv.notify_all();
+  }
+
+  bool WaitForCalls(std::size_t n_calls)
+  {
+    std::unique_lock<std::mutex> lk{m_mtx};
+    return m_cv.wait_for(lk, std::chrono::seconds(1), [this, n_calls](){
+      return m_calls >= n_calls;
+    });
+  }
+
+  std::size_t GetNumberOfCalls()
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    return m_calls;
+  }
+
+private:
+  std::mutex m_mtx{};
+  std::condition_variable m_cv{};
+  bool m_open = false;
+  bool m_throw = false;
+  std::size_t m_calls = 0;
+};
+
+class SingleFlightProtocolDecoratorTest : public ::testing::Test
+{
+protected:
+  SingleFlightProtocolDecoratorTest();
+  virtual ~SingleFlightProtocolDecoratorTest();
+
+  CountingGatedProtocol m_protocol;
+};
+
+TEST_F(SingleFlightProtocolDecoratorTest, CoalesceEqualInputs)
+{
+  const sup::dto::AnyValue input{ sup::dto::StringType, "status" };
+  const std::size_t n_followers = 4;
+  SingleFlightProtocolDecorator decorator{m_protocol};
+  std::vector<sup::dto::AnyValue> outputs(n_followers + 1);
+  std::vector<ProtocolResult> results(n_followers + 1, NotConnected);
+  std::vector<std::thread> threads;
+  threads.emplace_back([&](){ results[0] = decorator.Invoke(input, outputs[0]); });
+  ASSERT_TRUE(m_protocol.WaitForCalls(1));
+  EXPECT_EQ(decorator.GetNumberOfCallsInFlight(), 1);
+  for (std::size_t i = 1; i <= n_followers; ++i)
+  {
+    threads.emplace_back([&, i](){ results[i] = decorator.Invoke(input, outputs[i]); });
+  }
+  // Give the followers time to join the call in flight
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  m_protocol.Open();
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_EQ(m_protocol.GetNumberOfCalls(), 1);
+  EXPECT_EQ(decorator.GetNumberOfLeadingCalls(), 1);
+  EXPECT_EQ(decorator.GetNumberOfCoalescedCalls(), n_followers);
+  EXPECT_EQ(decorator.GetNumberOfCallsInFlight(), 0);
+  for (std::size_t i = 0; i <= n_followers; ++i)
+  {
+    EXPECT_EQ(results[i], Success);
+    EXPECT_EQ(outputs[i], input);
+  }
+
+  // Calls that do not overlap are not coalesced
+  sup::dto::AnyValue output{};
+  EXPECT_EQ(decorator.Invoke(input, output), Success);
+  EXPECT_EQ(output, input);
+  EXPECT_EQ(m_protocol.GetNumberOfCalls(), 2);
+  EXPECT_EQ(decorator.GetNumberOfLeadingCalls(), 2);
+  EXPECT_EQ(decorator.GetNumberOfCoalescedCalls(), n_followers);
+}
+
+TEST_F(SingleFlightProtocolDecoratorTest, DifferentInputs)
+{
+  const sup::dto::AnyValue input_1{ sup::dto::StringType, "status" };
+  const sup::dto::AnyValue input_2{ sup::dto::StringType, "other status" };
+  SingleFlightProtocolDecorator decorator{m_protocol};
+  sup::dto::AnyValue output_1{};
+  sup::dto::AnyValue output_2{};
+  std::thread thread_1{[&](){ (void)decorator.Invoke(input_1, output_1); }};
+  std::thread thread_2{[&](){ (void)decorator.Invoke(input_2, output_2); }};
+  ASSERT_TRUE(m_protocol.WaitForCalls(2));
+  EXPECT_EQ(decorator.GetNumberOfCallsInFlight(), 2);
+  m_protocol.Open();
+  thread_1.join();
+  thread_2.join();
+  EXPECT_EQ(output_1, input_1);
+  EXPECT_EQ(output_2, input_2);
+  EXPECT_EQ(decorator.GetNumberOfLeadingCalls(), 2);
+  EXPECT_EQ(decorator.GetNumberOfCoalescedCalls(), 0);
+}
+
+TEST_F(SingleFlightProtocolDecoratorTest, Predicate)
+{
+  // Inputs that are not coalescable are always forwarded
+  const sup::dto::AnyValue input{ sup::dto::StringType, "command" };
+  const sup::dto::AnyValue throwing_input{ sup::dto::StringType, "throw" };
+  auto coalescable = [&throwing_input](const sup::dto::AnyValue& value) -> bool {
+    if (value == throwing_input)
+    {
+      throw std::runtime_error("Predicate failed");
+    }
+    return false;
+  };
+  SingleFlightProtocolDecorator decorator{m_protocol, coalescable};
+  std::vector<sup::dto::AnyValue> outputs(3);
+  std::vector<std::thread> threads;
+  threads.emplace_back([&](){ (void)decorator.Invoke(input, outputs[0]); });
+  threads.emplace_back([&](){ (void)decorator.Invoke(input, outputs[1]); });
+  threads.emplace_back([&](){ (void)decorator.Invoke(throwing_input, outputs[2]); });
+  ASSERT_TRUE(m_protocol.WaitForCalls(3));
+  EXPECT_EQ(decorator.GetNumberOfCallsInFlight(), 0);
+  m_protocol.Open();
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_EQ(outputs[0], input);
+  EXPECT_EQ(outputs[1], input);
+  EXPECT_EQ(outputs[2], throwing_input);
+  EXPECT_EQ(decorator.GetNumberOfLeadingCalls(), 0);
+  EXPECT_EQ(decorator.GetNumberOfCoalescedCalls(), 0);
+}
+
+TEST_F(SingleFlightProtocolDecoratorTest, LeaderThrows)
+{
+  // An exception of the shared call is passed to all coalesced calls
+  const sup::dto::AnyValue input{ sup::dto::StringType, "status" };
+  SingleFlightProtocolDecorator decorator{m_protocol};
+  std::atomic<int> n_exceptions{0};
+  auto invoke = [&](){
+    sup::dto::AnyValue output{};
+    try
+    {
+      (void)decorator.Invoke(input, output);
+    }
+    catch(const std::runtime_error&)
+    {
+      ++n_exceptions;
+    }
+  };
+  std::thread leader{invoke};
+  ASSERT_TRUE(m_protocol.WaitForCalls(1));
+  std::thread follower{invoke};
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  m_protocol.Open(true);
+  leader.join();
+  follower.join();
+  EXPECT_EQ(n_exceptions, 2);
+  EXPECT_EQ(m_protocol.GetNumberOfCalls(), 1);
+  EXPECT_EQ(decorator.GetNumberOfCallsInFlight(), 0);
+}
+
+TEST_F(SingleFlightProtocolDecoratorTest, CancelledLeader)
+{
+  // The output of a cancelled asynchronous request is not shared: the follower calls again
+  const sup::dto::AnyValue input{ sup::dto::StringType, "status" };
+  SingleFlightProtocolDecorator decorator{m_protocol};
+  WorkerPool executor{1};
+  AsyncInvoke leader{decorator, input, 100.0, executor};
+  ASSERT_TRUE(m_protocol.WaitForCalls(1));
+  sup::dto::AnyValue output{};
+  std::thread follower{[&](){ (void)decorator.Invoke(input, output); }};
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(leader.Invalidate());
+  m_protocol.Open();
+  follower.join();
+  EXPECT_EQ(output, input);
+  EXPECT_EQ(m_protocol.GetNumberOfCalls(), 2);
+  EXPECT_EQ(decorator.GetNumberOfLeadingCalls(), 2);
+  EXPECT_EQ(decorator.GetNumberOfCoalescedCalls(), 0);
+}
+
+TEST_F(SingleFlightProtocolDecoratorTest, Service)
+{
+  const sup::dto::AnyValue input{ sup::dto::StringType, "service" };
+  SingleFlightProtocolDecorator decorator{m_protocol};
+  sup::dto::AnyValue output{};
+  EXPECT_EQ(decorator.Service(input, output), Success);
+  EXPECT_EQ(output, input);
+  EXPECT_EQ(decorator.GetNumberOfLeadingCalls(), 0);
+}
+
+SingleFlightProtocolDecoratorTest::SingleFlightProtocolDecoratorTest()
+  : m_protocol{}
+{}
+
+SingleFlightProtocolDecoratorTest::~SingleFlightProtocolDecoratorTest() = default;
@@ -0,0 +1,162 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/slab_pool.h>
+
+#include <sup/protocol/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+using namespace sup::protocol;
+
+class SlabPoolTest : public ::testing::Test
+{
+protected:
+  SlabPoolTest();
+  virtual ~SlabPoolTest();
+};
+
+TEST_F(SlabPoolTest, Construction)
+{
+  EXPECT_THROW(SlabPool{0}, InvalidOperationException);
+  SlabPool pool{4};
+  EXPECT_EQ(pool.GetNumberOfSlabs(), 0);
+  EXPECT_EQ(pool.GetNumberOfBlocksInUse(), 0);
+}
+
+TEST_F(SlabPoolTest, ReuseBlocks)
+{
+  SlabPool pool{4};
+  auto block = pool.Allocate(24, alignof(std::uint64_t));
+  ASSERT_NE(block, nullptr);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(block) % SlabPool::kSlabBlockGranularity, 0);
+  EXPECT_EQ(pool.GetNumberOfSlabs(), 1);
+  EXPECT_EQ(pool.GetNumberOfBlocksInUse(), 1);
+  pool.Deallocate(block, 24, alignof(std::uint64_t));
+  EXPECT_EQ(pool.GetNumberOfBlocksInUse(), 0);
+
+  // A freed block is handed out again
+  auto other_block = pool.Allocate(24, alignof(std::uint64_t));
+  EXPECT_EQ(other_block, block);
+  pool.Deallocate(other_block, 24, alignof(std::uint64_t));
+
+  // Allocation cycles within the capacity of the slabs do not allocate new slabs
+  std::vector<void*> blocks;
+  for (int cycle = 0; cycle < 10; ++cycle)
+  {
+    for (int i = 0; i < 6; ++i)
+    {
+      blocks.push_back(pool.Allocate(24, alignof(std::uint64_t)));
+    }
+    EXPECT_EQ(pool.GetNumberOfBlocksInUse(), 6);
+    for (auto ptr : blocks)
+    {
+      pool.Deallocate(ptr, 24, alignof(std::uint64_t));
+    }
+    blocks.clear();
+  }
+  EXPECT_EQ(pool.GetNumberOfSlabs(), 2);
+  EXPECT_EQ(pool.GetNumberOfBlocksInUse(), 0);
+
+  // Different size classes use different slabs
+  auto large_block = pool.Allocate(200, alignof(std::uint64_t));
+  EXPECT_EQ(pool.GetNumberOfSlabs(), 3);
+  pool.Deallocate(large_block, 200, alignof(std::uint64_t));
+}
+
+TEST_F(SlabPoolTest, UnpooledBlocks)
+{
+  // Blocks that are too large or need a stronger alignment bypass the slabs
+  SlabPool pool{4};
+  auto large_block = pool.Allocate(SlabPool::kMaxSlabBlockSize + 1, alignof(std::uint64_t));
+  ASSERT_NE(large_block, nullptr);
+  EXPECT_EQ(pool.GetNumberOfSlabs(), 0);
+  EXPECT_EQ(pool.GetNumberOfBlocksInUse(), 0);
+  pool.Deallocate(large_block, SlabPool::kMaxSlabBlockSize + 1, alignof(std::uint64_t));
+
+  const std::size_t alignment = 2 * SlabPool::kSlabBlockGranularity;
+  auto aligned_block = pool.Allocate(16, alignment);
+  ASSERT_NE(aligned_block, nullptr);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned_block) % alignment, 0);
+  EXPECT_EQ(pool.GetNumberOfSlabs(), 0);
+  pool.Deallocate(aligned_block, 16, alignment);
+
+  // Zero sized blocks are still unique
+  auto empty_block = pool.Allocate(0, 1);
+  auto other_empty_block = pool.Allocate(0, 1);
+  EXPECT_NE(empty_block, other_empty_block);
+  pool.Deallocate(empty_block, 0, 1);
+  pool.Deallocate(other_empty_block, 0, 1);
+  EXPECT_EQ(pool.GetNumberOfBlocksInUse(), 0);
+}
+
+TEST_F(SlabPoolTest, PoolAllocator)
+{
+  auto pool = std::make_shared<SlabPool>(8);
+  using Allocator = PoolAllocator<std::pair<const int, double>>;
+  std::map<int, double, std::less<int>, Allocator> values{Allocator{pool}};
+  for (int i = 0; i < 20; ++i)
+  {
+    values[i] = i;
+  }
+  EXPECT_EQ(pool->GetNumberOfBlocksInUse(), 20);
+  const auto n_slabs = pool->GetNumberOfSlabs();
+  values.clear();
+  EXPECT_EQ(pool->GetNumberOfBlocksInUse(), 0);
+
+  // Refilling the container reuses the nodes
+  for (int i = 0; i < 20; ++i)
+  {
+    values[i] = i;
+  }
+  EXPECT_EQ(pool->GetNumberOfSlabs(), n_slabs);
+  values.clear();
+}
+
+TEST_F(SlabPoolTest, PoolLifetime)
+{
+  // Allocated objects keep the pool alive
+  auto pool = std::make_shared<SlabPool>(8);
+  std::weak_ptr<SlabPool> weak_pool = pool;
+  auto value = std::allocate_shared<double>(PoolAllocator<double>{pool}, 3.0);
+  EXPECT_EQ(pool->GetNumberOfBlocksInUse(), 1);
+  pool.reset();
+  EXPECT_FALSE(weak_pool.expired());
+  EXPECT_EQ(*value, 3.0);
+  value.reset();
+  EXPECT_TRUE(weak_pool.expired());
+
+  // Without pool, the global heap is used
+  PoolAllocator<int> heap_allocator{};
+  auto ptr = heap_allocator.allocate(4);
+  ASSERT_NE(ptr, nullptr);
+  heap_allocator.deallocate(ptr, 4);
+  EXPECT_EQ(heap_allocator, PoolAllocator<double>{});
+  EXPECT_NE(heap_allocator, PoolAllocator<int>{std::make_shared<SlabPool>(1)});
+}
+
+SlabPoolTest::SlabPoolTest() = default;
+
+SlabPoolTest::~SlabPoolTest() = default;
@@ -0,0 +1,99 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/stage_timers.h>
+
+#include <gtest/gtest.h>
+
+using namespace sup::protocol;
+
+class StageTimersTest : public ::testing::Test
+{
+protected:
+  StageTimersTest();
+  virtual ~StageTimersTest();
+};
+
+TEST_F(StageTimersTest, Record)
+{
+  StageTimers timers{2};
+  timers.Record(0, PayloadEncoding::kNone, 1000);
+  timers.Record(1, PayloadEncoding::kNone, 2000);
+  timers.Record(1, PayloadEncoding::kBase64, 3000);
+  // Unknown stages are ignored
+  timers.Record(2, PayloadEncoding::kNone, 4000);
+  EXPECT_EQ(timers.GetSnapshot(0, PayloadEncoding::kNone).GetCount(), 1);
+  EXPECT_DOUBLE_EQ(timers.GetSnapshot(1, PayloadEncoding::kNone).GetMaximum(), 2e-6);
+  EXPECT_EQ(timers.GetSnapshot(0, PayloadEncoding::kBase64).GetCount(), 0);
+  EXPECT_DOUBLE_EQ(timers.GetSnapshot(1, PayloadEncoding::kBase64).GetMaximum(), 3e-6);
+  EXPECT_EQ(timers.GetSnapshot(2, PayloadEncoding::kNone).GetCount(), 0);
+
+  timers.Reset();
+  EXPECT_EQ(timers.GetSnapshot(0, PayloadEncoding::kNone).GetCount(), 0);
+  EXPECT_EQ(timers.GetSnapshot(1, PayloadEncoding::kBase64).GetCount(), 0);
+}
+
+TEST_F(StageTimersTest, StageTimer)
+{
+  StageTimers timers{3};
+  {
+    StageTimer timer{&timers};
+    timer.EndStage(0, PayloadEncoding::kBase64);
+    timer.EndStage(2, PayloadEncoding::kBase64);
+  }
+  EXPECT_EQ(timers.GetSnapshot(0, PayloadEncoding::kBase64).GetCount(), 1);
+  EXPECT_EQ(timers.GetSnapshot(1, PayloadEncoding::kBase64).GetCount(), 0);
+  EXPECT_EQ(timers.GetSnapshot(2, PayloadEncoding::kBase64).GetCount(), 1);
+
+  // A timer without histograms does nothing
+  StageTimer disabled_timer{nullptr};
+  EXPECT_NO_THROW(disabled_timer.EndStage(0, PayloadEncoding::kBase64));
+}
+
+TEST_F(StageTimersTest, HeldStages)
+{
+  StageTimers timers{3};
+  {
+    // Held stages are recorded with the encoding passed at the end
+    StageTimer timer{&timers};
+    timer.HoldStage(0);
+    timer.HoldStage(1);
+    timer.RecordHeldStages(PayloadEncoding::kNone);
+    timer.EndStage(2, PayloadEncoding::kNone);
+  }
+  {
+    // Held stages that are never recorded are dropped
+    StageTimer timer{&timers};
+    timer.HoldStage(0);
+  }
+  for (std::size_t stage = 0; stage < 3; ++stage)
+  {
+    EXPECT_EQ(timers.GetSnapshot(stage, PayloadEncoding::kNone).GetCount(), 1);
+  }
+
+  // A timer without histograms does nothing
+  StageTimer disabled_timer{nullptr};
+  EXPECT_NO_THROW(disabled_timer.HoldStage(0));
+  EXPECT_NO_THROW(disabled_timer.RecordHeldStages(PayloadEncoding::kNone));
+}
+
+StageTimersTest::StageTimersTest() = default;
+
+StageTimersTest::~StageTimersTest() = default;
@@ -20,15 +20,18 @@
 
 #include "test_protocol.h"
 
+#include <sup/protocol/cancellation.h>
 #include <sup/protocol/protocol_rpc.h>
 
 #include <sup/dto/anyvalue.h>
 #include <sup/dto/anyvalue_helper.h>
 
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <stdexcept>
 #include <thread>
+#include <utility>
 
 namespace sup
 {
@@ -120,6 +123,128 @@ ProtocolResult AsyncRequestTestProtocol::Service(const sup::dto::AnyValue& input
   return Success;
 }
 
+CancellableTestProtocol::CancellableTestProtocol(double timeout_sec)
+  : m_timeout_sec{timeout_sec}
+  , m_invocations{0}
+  , m_cancellations{0}
+{}
+
+ProtocolResult CancellableTestProtocol::Invoke(const sup::dto::AnyValue& input,
+                                               sup::dto::AnyValue& output)
+{
+  ++m_invocations;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(m_timeout_sec);
+  while (std::chrono::steady_clock::now() < deadline)
+  {
+    if (IsInvocationCancelled())
+    {
+      ++m_cancellations;
+      return NotConnected;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  output = input;
+  return Success;
+}
+
+ProtocolResult CancellableTestProtocol::Service(const sup::dto::AnyValue& input,
+                                                sup::dto::AnyValue& output)
+{
+  output = input;
+  return Success;
+}
+
+std::size_t CancellableTestProtocol::GetNumberOfInvocations() const
+{
+  return m_invocations.load();
+}
+
+std::size_t CancellableTestProtocol::GetNumberOfCancellations() const
+{
+  return m_cancellations.load();
+}
+
+GatedTestProtocol::GatedTestProtocol()
+  : m_mtx{}
+  , m_cv{}
+  , m_open{false}
+{}
+
+ProtocolResult GatedTestProtocol::Invoke(const sup::dto::AnyValue& input,
+                                         sup::dto::AnyValue& output)
+{
+  std::unique_lock<std::mutex> lk{m_mtx};
+  m_cv.wait(lk, [this](){ return m_open; });
+  output = input;
+  return Success;
+}
+
+ProtocolResult GatedTestProtocol::Service(const sup::dto::AnyValue& input,
+                                          sup::dto::AnyValue& output)
+{
+  output = input;
+  return Success;
+}
+
+void GatedTestProtocol::Open()
+{
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    m_open = true;
+  }
+  m_cv.notify_all();
+}
+
+void GatedTestProtocol::Close()
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  m_open = false;
+}
+
+ManualExecutor::ManualExecutor()
+  : m_mtx{}
+  , m_tasks{}
+  , m_refuse{false}
+{}
+
+ManualExecutor::~ManualExecutor() = default;
+
+void ManualExecutor::Submit(Task task)
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  if (m_refuse)
+  {
+    throw std::runtime_error("Executor refuses tasks");
+  }
+  m_tasks.push_back(std::move(task));
+}
+
+void ManualExecutor::RunAll()
+{
+  std::vector<Task> tasks;
+  {
+    std::lock_guard<std::mutex> lk{m_mtx};
+    tasks.swap(m_tasks);
+  }
+  for (auto& task : tasks)
+  {
+    task();
+  }
+}
+
+void ManualExecutor::DropAll()
+{
+  std::vector<Task> tasks;
+  std::lock_guard<std::mutex> lk{m_mtx};
+  tasks.swap(m_tasks);
+}
+
+void ManualExecutor::SetRefuse(bool refuse)
+{
+  std::lock_guard<std::mutex> lk{m_mtx};
+  m_refuse = refuse;
+}
+
 sup::dto::uint64 ExtractRequestId(const sup::dto::AnyValue& reply)
 {
   auto encoding_result = utils::TryGetPacketEncoding(reply);
@@ -21,13 +21,19 @@
 #ifndef SUP_CONFIG_TEST_PROTOCOL_H_
 #define SUP_CONFIG_TEST_PROTOCOL_H_
 
+#include <sup/protocol/async_executor.h>
 #include <sup/protocol/protocol.h>
 
 #include <sup/dto/any_functor.h>
 #include <sup/dto/anyvalue.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <future>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace sup
 {
@@ -82,6 +88,71 @@ private:
   std::future<void> m_go_future;
 };
 
+/**
+ * Protocol whose Invoke runs until its asynchronous request is cancelled (or a timeout passes).
+*/
+class CancellableTestProtocol : public Protocol
+{
+public:
+  explicit CancellableTestProtocol(double timeout_sec);
+  ~CancellableTestProtocol() = default;
+
+  ProtocolResult Invoke(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override;
+  ProtocolResult Service(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override;
+
+  std::size_t GetNumberOfInvocations() const;
+  std::size_t GetNumberOfCancellations() const;
+private:
+  double m_timeout_sec;
+  std::atomic<std::size_t> m_invocations;
+  std::atomic<std::size_t> m_cancellations;
+};
+
+/**
+ * Protocol whose Invoke echoes the input, but only returns while its gate is open. The gate is
+ * closed on construction and can be opened and closed again any number of times.
+*/
+class GatedTestProtocol : public Protocol
+{
+public:
+  GatedTestProtocol();
+  ~GatedTestProtocol() = default;
+
+  ProtocolResult Invoke(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override;
+  ProtocolResult Service(const sup::dto::AnyValue& input, sup::dto::AnyValue& output) override;
+
+  void Open();
+  void Close();
+private:
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  bool m_open;
+};
+
+/**
+ * @brief Executor that only runs its tasks on demand, or refuses them.
+ */
+class ManualExecutor : public AsyncExecutor
+{
+public:
+  ManualExecutor();
+  ~ManualExecutor() override;
+
+  void Submit(Task task) override;
+
+  // Run all tasks that were submitted so far
+  void RunAll();
+
+  // Destroy all tasks that were submitted so far without running them
+  void DropAll();
+
+  void SetRefuse(bool refuse);
+private:
+  std::mutex m_mtx;
+  std::vector<Task> m_tasks;
+  bool m_refuse;
+};
+
 sup::dto::uint64 ExtractRequestId(const sup::dto::AnyValue& reply);
 
 bool ExtractReadyStatus(const sup::dto::AnyValue& reply);
@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/work_stealing_pool.h>
+
+#include <sup/protocol/async_executor.h>
+#include <sup/protocol/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace sup::protocol;
+
+class WorkStealingPoolTest : public ::testing::Test
+{
+protected:
+  WorkStealingPoolTest();
+  virtual ~WorkStealingPoolTest();
+};
+
+TEST_F(WorkStealingPoolTest, Construction)
+{
+  WorkStealingPool pool{3};
+  EXPECT_EQ(pool.GetNumberOfThreads(), 3);
+  EXPECT_THROW(WorkStealingPool{0}, InvalidOperationException);
+  EXPECT_THROW(CreateWorkStealingPool(0), InvalidOperationException);
+}
+
+TEST_F(WorkStealingPoolTest, ConcurrentSubmission)
+{
+  // Submit tasks concurrently from multiple threads
+  const std::size_t n_submitters = 4;
+  const std::size_t n_tasks = 250;
+  std::atomic<std::size_t> counter{0};
+  {
+    WorkStealingPool pool{4};
+    std::vector<std::thread> submitters;
+    for (std::size_t i = 0; i < n_submitters; ++i)
+    {
+      submitters.emplace_back([&pool, &counter, n_tasks](){
+        for (std::size_t j = 0; j < n_tasks; ++j)
+        {
+          pool.Submit([&counter](){ ++counter; });
+        }
+      });
+    }
+    for (auto& submitter : submitters)
+    {
+      submitter.join();
+    }
+  }
+  // Destruction of the pool only happens after all submitted tasks were executed
+  EXPECT_EQ(counter, n_submitters * n_tasks);
+}
+
+TEST_F(WorkStealingPoolTest, StealTasks)
+{
+  // A task submits other tasks to its own worker queue and then blocks until these are done. They
+  // can only be executed when another worker steals them.
+  const std::size_t n_tasks = 3;
+  WorkStealingPool pool{2};
+  std::promise<void> done;
+  std::atomic<std::size_t> counter{0};
+  pool.Submit([&](){
+    for (std::size_t i = 0; i < n_tasks; ++i)
+    {
+      pool.Submit([&](){
+        if (++counter == n_tasks)
+        {
+          done.set_value();
+        }
+      });
+    }
+    auto future = done.get_future();
+    EXPECT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  });
+}
+
+TEST_F(WorkStealingPoolTest, ThrowingTask)
+{
+  // A throwing task does not kill the worker thread
+  WorkStealingPool pool{1};
+  std::promise<void> done;
+  pool.Submit([](){ throw std::runtime_error("Throwing on demand"); });
+  pool.Submit([&done](){ done.set_value(); });
+  auto future = done.get_future();
+  EXPECT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+}
+
+WorkStealingPoolTest::WorkStealingPoolTest() = default;
+
+WorkStealingPoolTest::~WorkStealingPoolTest() = default;
@@ -0,0 +1,126 @@
+/******************************************************************************
+ *
+ * Project       : SUP RPC protocol stack
+ *
+ * Description   : The definition and implementation for the RPC protocol stack in SUP
+ *
+ * Author        : Kevin Meyer
+ *
+ * Copyright (c) : 2010-2026 ITER Organization,
+ *                 CS 90 046
+ *                 13067 St. Paul-lez-Durance Cedex
+ *                 France
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of ITER CODAC software.
+ * For the terms and conditions of redistribution or use of this software
+ * refer to the file LICENSE located in the top level directory
+ * of the distribution package.
+ ******************************************************************************/
+
+#include <sup/protocol/base/worker_pool.h>
+
+#include <sup/protocol/async_executor.h>
+#include <sup/protocol/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+using namespace sup::protocol;
+
+class WorkerPoolTest : public ::testing::Test
+{
+protected:
+  WorkerPoolTest();
+  virtual ~WorkerPoolTest();
+};
+
+TEST_F(WorkerPoolTest, Construction)
+{
+  WorkerPool pool{3};
+  EXPECT_EQ(pool.GetNumberOfThreads(), 3);
+  EXPECT_THROW(WorkerPool{0}, InvalidOperationException);
+  EXPECT_THROW(CreateWorkerPool(0), InvalidOperationException);
+}
+
+TEST_F(WorkerPoolTest, ExecuteTasks)
+{
+  const std::size_t n_tasks = 100;
+  std::atomic<std::size_t> counter{0};
+  std::promise<void> done;
+  {
+    WorkerPool pool{4};
+    for (std::size_t i = 0; i < n_tasks; ++i)
+    {
+      pool.Submit([&counter, &done, n_tasks](){
+        if (++counter == n_tasks)
+        {
+          done.set_value();
+        }
+      });
+    }
+    auto future = done.get_future();
+    EXPECT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  }
+  EXPECT_EQ(counter, n_tasks);
+}
+
+TEST_F(WorkerPoolTest, BoundedNumberOfThreads)
+{
+  // Submit more blocking tasks than there are threads: only two threads may run them.
+  const std::size_t n_tasks = 10;
+  std::mutex mtx;
+  std::set<std::thread::id> thread_ids;
+  std::atomic<std::size_t> counter{0};
+  {
+    WorkerPool pool{2};
+    for (std::size_t i = 0; i < n_tasks; ++i)
+    {
+      pool.Submit([&](){
+        {
+          std::lock_guard<std::mutex> lk{mtx};
+          thread_ids.insert(std::this_thread::get_id());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++counter;
+      });
+    }
+  }
+  // Destruction of the pool only happens after all submitted tasks were executed
+  EXPECT_EQ(counter, n_tasks);
+  EXPECT_LE(thread_ids.size(), 2);
+}
+
+TEST_F(WorkerPoolTest, ThrowingTask)
+{
+  // A throwing task does not kill the worker thread
+  WorkerPool pool{1};
+  std::promise<void> done;
+  pool.Submit([](){ throw std::runtime_error("Throwing on demand"); });
+  pool.Submit([&done](){ done.set_value(); });
+  auto future = done.get_future();
+  EXPECT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+}
+
+TEST_F(WorkerPoolTest, ThreadPerTaskExecutor)
+{
+  auto executor = CreateThreadPerTaskExecutor();
+  ASSERT_TRUE(static_cast<bool>(executor));
+  std::promise<std::thread::id> promise;
+  executor->Submit([&promise](){ promise.set_value(std::this_thread::get_id()); });
+  auto future = promise.get_future();
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  EXPECT_NE(future.get(), std::this_thread::get_id());
+}
+
+WorkerPoolTest::WorkerPoolTest() = default;
+
+WorkerPoolTest::~WorkerPoolTest() = default;